@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Assets/texture.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Assets
+{
+    // Single-channel height map decoded once. The same buffer is used
+    // in place as the Bullet heightfield data and as the GL height texture.
+    class HeightField : public Texture
+    {
+    public:
+        HeightField(std::string const &path, bool upload = true);
+
+        void upload() override;
+
+        float getHeight(float u, float v) const;
+        unsigned char getTexel(int x, int z) const;
+
+        const unsigned char *getData() const { return mData.data(); }
+        int getWidth() const { return mWidth; }
+        int getLength() const { return mLength; }
+
+    private:
+        HeightField(HeightField const &) = delete;
+        HeightField & operator=(HeightField const &) = delete;
+
+        void loadHeightField(std::string const &path);
+
+        std::vector<unsigned char> mData;
+        int mWidth;
+        int mLength;
+    };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Assets
+{
+    // Views of an object rendered around its vertical axis into gBuffer-layout atlases.
+    // Textures are created when the rendering engine first bakes it.
+    class Impostor
+    {
+    public:
+        Impostor(unsigned int frameCount = 8, unsigned int frameSize = 128);
+        ~Impostor();
+
+        bool isBaked() const { return mPositionID != 0; }
+
+        unsigned int mFrameCount;
+        unsigned int mFrameSize;
+
+        // Object-space bounding sphere that each frame covers
+        glm::vec3 mCenter;
+        float mRadius;
+
+        unsigned int mPositionID, mNormalID, mAlbedoSpecID;
+
+    private:
+        Impostor(Impostor const &) = delete;
+        Impostor & operator=(Impostor const &) = delete;
+    };
+}
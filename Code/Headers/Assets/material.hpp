@@ -14,6 +14,7 @@ namespace Assets
         ~Material();
 
         void prepareForRender();
+        void upload();
 
         std::shared_ptr<Texture> mAlbedoMap;
         std::shared_ptr<Texture> mSpecularMap;
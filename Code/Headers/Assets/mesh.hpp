@@ -1,7 +1,10 @@
 #pragma once
 
+#include "Utils/mappedfile.hpp"
+
 #include <glm/glm.hpp>
 
+#include <memory>
 #include <vector>
 
 namespace Assets
@@ -14,22 +17,88 @@ namespace Assets
         glm::vec3 Bitangent;
     };
 
+    // 20-byte GPU layout: positions normalized to the mesh bounds, 10-bit normal and tangent
+    // with the bitangent handedness in the tangent's w, and half-float texture coordinates
+    struct PackedVertex {
+        unsigned short Position[4];
+        unsigned int Normal;
+        unsigned int Tangent;
+        unsigned short TexCoords[2];
+    };
+
+    // A range of the shared index buffer; level 0 is the full-detail mesh
+    struct LodLevel {
+        unsigned int mIndexOffset;
+        unsigned int mIndexCount;
+        // Simplification error relative to the mesh's bounding radius
+        float mError;
+    };
+
+    // Packed is the default; float keeps source precision for meshes that need it
+    enum VertexFormat { FLOAT_VERTICES, PACKED_VERTICES };
+
     class Mesh
     {
     public:
         Mesh();
-        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices);
-        Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec3> normals, std::vector<glm::vec2> texCoords);
+        // Indices hold every LOD level back to back; no levels means the whole buffer is level 0
+        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<LodLevel> lods, bool upload = true);
+        Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec3> normals, std::vector<glm::vec2> texCoords, bool upload = true);
+        // Vertices, packed vertices and indices are used in place from a mapped cooked mesh file, with the bounds
+        // and position dequantization cooked alongside them
+        Mesh(std::shared_ptr<Utils::MappedFile> source, const Vertex *vertices, const PackedVertex *packedVertices,
+             unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount, std::vector<LodLevel> lods,
+             VertexFormat vertexFormat, glm::vec3 boundsMin, glm::vec3 boundsMax,
+             glm::vec3 positionScale, glm::vec3 positionOffset, bool upload = true);
         ~Mesh();
 
-        void draw();
-        void drawInstanced(std::vector<glm::mat4> modelMatrices);
+        void draw(unsigned int lod = 0);
+        void drawInstanced(std::vector<glm::mat4> modelMatrices, unsigned int lod = 0);
         void center();
         void setupMesh();
+        void computeBounds();
+        void setVertexFormat(VertexFormat vertexFormat);
+
+        const Vertex *getVertexData() const;
+        // Vertices in PACKED_VERTICES layout, quantized against getPositionScale() and getPositionOffset()
+        const PackedVertex *getPackedVertexData() const;
+        glm::vec3 getPositionScale() const { return mPositionScale; }
+        glm::vec3 getPositionOffset() const { return mPositionOffset; }
+        unsigned int getVertexCount() const;
+        const unsigned int *getIndexData() const;
+        unsigned int getIndexCount() const;
+        unsigned int getLodCount() const;
+        LodLevel const &getLod(unsigned int lod) const;
+        float getBoundingRadius() const;
 
         std::vector<Vertex> mVertices;
         std::vector<unsigned int> mIndices;
+        glm::vec3 mBoundsMin;
+        glm::vec3 mBoundsMax;
+        std::vector<LodLevel> mLods;
+        VertexFormat mVertexFormat;
 
         unsigned int mVBO, mInstanceVBO, mEBO, mVAO;
+
+    private:
+        void copyMappedData();
+        void packVertices();
+        void validateLods();
+        void uploadFloatVertices();
+        void uploadPackedVertices();
+        void setVertexConstants();
+
+        std::vector<PackedVertex> mPackedVertices;
+
+        std::shared_ptr<Utils::MappedFile> mSource;
+        const Vertex *mMappedVertices;
+        const PackedVertex *mMappedPackedVertices;
+        const unsigned int *mMappedIndices;
+        unsigned int mMappedVertexCount;
+        unsigned int mMappedIndexCount;
+
+        // Dequantization applied in the vertex shader
+        glm::vec3 mPositionScale;
+        glm::vec3 mPositionOffset;
     };
 }
\ No newline at end of file
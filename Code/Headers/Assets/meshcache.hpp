@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Assets/mesh.hpp"
+#include "Utils/mappedfile.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Assets
+{
+    // Model contents in GPU layout, either pointing into a mapped cooked file
+    // or into meshes that are about to be cooked
+    struct CookedModel
+    {
+        struct CookedMesh
+        {
+            const Vertex *mVertices;
+            // Same vertices in PACKED_VERTICES layout, so packed meshes upload without quantizing on load
+            const PackedVertex *mPackedVertices;
+            unsigned int mVertexCount;
+            const unsigned int *mIndices;
+            unsigned int mIndexCount;
+            glm::vec3 mBoundsMin;
+            glm::vec3 mBoundsMax;
+            std::vector<LodLevel> mLods;
+            VertexFormat mVertexFormat;
+            glm::vec3 mPositionScale;
+            glm::vec3 mPositionOffset;
+        };
+
+        struct TextureBinding
+        {
+            std::string mType;
+            std::string mPath;
+        };
+
+        std::vector<CookedMesh> mMeshes;
+        std::vector<TextureBinding> mTextures;
+
+        unsigned long long mSourceHash;
+        std::shared_ptr<Utils::MappedFile> mFile;
+    };
+
+    // On-disk cache of imported models and generated meshes, keyed by a hash of their source
+    class MeshCache
+    {
+    public:
+        static void initialize(std::string const &cacheDirectory);
+
+        // Fills in the source hash even on a miss, so the caller can save() after importing
+        static bool load(std::string const &path, unsigned int importFlags, CookedModel &model);
+        // Looks up contents under a caller-computed key, such as a hash of procedural geometry inputs
+        static bool load(unsigned long long sourceHash, CookedModel &model);
+        static void save(CookedModel const &model);
+
+    private:
+        static std::string getCachePath(unsigned long long sourceHash);
+
+        static std::string mCacheDirectory;
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Assets/mesh.hpp"
+#include "Assets/meshcache.hpp"
 #include "Assets/texture.hpp"
 
 #include <assimp/scene.h>
@@ -15,7 +16,9 @@ namespace Assets
     class Model
     {
     public:
-        Model(std::string const &path);
+        Model(std::string const &path, bool upload = true);
+
+        void upload();
 
         std::vector<std::shared_ptr<Mesh>> mMeshes;
         std::vector<std::shared_ptr<Texture>> mAlbedoTextures;
@@ -25,9 +28,10 @@ namespace Assets
 
     private:
         void loadModel(std::string const &path);
-        void processNode(aiNode *node, const aiScene *scene);
-        void processMesh(aiMesh *mesh, const aiScene *scene);
-        void loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
+        void processNode(aiNode *node, const aiScene *scene, std::vector<aiMesh *> &meshes);
+        std::shared_ptr<Mesh> processMesh(aiMesh *mesh);
+        void loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName, std::vector<CookedModel::TextureBinding> &textures);
+        void loadTextures(std::vector<CookedModel::TextureBinding> const &textures);
 
         std::string mDirectory;
         std::set<std::string> mTexturesLoaded;
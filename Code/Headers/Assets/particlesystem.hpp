@@ -24,5 +24,9 @@ namespace Assets
         float mParticleLifetime;
         glm::vec2 mInitialParticleSize;
         glm::vec2 mFinalParticleSize;
+
+        // Rendered into a half resolution target and composited over the scene, trading edge
+        // sharpness for less overdraw
+        bool mHalfResolution;
     };
 }
\ No newline at end of file
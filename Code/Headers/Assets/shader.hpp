@@ -3,21 +3,38 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <map>
 #include <string>
+#include <vector>
 
 namespace Assets
 {
+    // #define lines for every stage of a shader. Defines are always set; features are toggled per
+    // permutation, bit N of the permutation key enabling mFeatures[N].
+    struct ShaderOptions
+    {
+        std::vector<std::string> mDefines;
+        std::vector<std::string> mFeatures;
+    };
+
+    // Linked GL program with one variant per permutation. Variants come from the shader cache when possible;
+    // otherwise they are compiled and linked without waiting, with status checks deferred to the first use()
+    // so the driver can overlap compiles.
     class Shader
     {
     public:
-        Shader(std::string computePath);
-        Shader(std::string vertexPath, std::string fragmentPath);
-        Shader(std::string vertexPath, std::string geometryPath, std::string fragmentPath);
-        Shader(std::string vertexPath, std::string tcsPath, std::string tesPath, std::string geomPath, std::string fragmentPath);
+        Shader(std::string computePath, ShaderOptions const &options = ShaderOptions());
+        Shader(std::string vertexPath, std::string fragmentPath, ShaderOptions const &options = ShaderOptions());
+        Shader(std::string vertexPath, std::string geometryPath, std::string fragmentPath, ShaderOptions const &options = ShaderOptions());
+        Shader(std::string vertexPath, std::string tcsPath, std::string tesPath, std::string geomPath, std::string fragmentPath,
+               ShaderOptions const &options = ShaderOptions());
         ~Shader();
 
-        void attachShader(GLuint shaderType, std::string shaderPath, std::string shaderTypeStr);
-        void checkCompileErrors(GLuint shader, std::string type);
+        // Selects the variant used by use() and the setters; each is compiled the first time it is selected
+        void setPermutation(unsigned int permutation);
+        unsigned int getPermutation() const { return mPermutation; }
+
+        void checkCompileErrors(GLuint shader, std::string type) const;
         void use() const;
 
         void setBool(const std::string &name, bool value) const;
@@ -34,6 +51,34 @@ namespace Assets
         void setMat4(const std::string &name, const glm::mat4 &mat) const;
     
     private:
+        Shader(Shader const &) = delete;
+        Shader & operator=(Shader const &) = delete;
+
+        struct Stage
+        {
+            GLuint mType;
+            std::string mPath;
+            std::string mTypeStr;
+        };
+
+        struct Program
+        {
+            unsigned int mID;
+            unsigned long long mSourceHash;
+            bool mPending;
+            std::vector<GLuint> mStageIDs;
+            std::vector<std::vector<std::string>> mFiles;
+        };
+
+        void build(Program &program, unsigned int permutation);
+        // Blocks on a pending link, reports errors and saves the binary
+        void resolve(Program &program) const;
+        static GLuint attachShader(GLuint programID, GLuint shaderType, std::string const &shaderCode);
+
+        std::vector<Stage> mStages;
+        ShaderOptions mOptions;
+        unsigned int mPermutation;
         unsigned int mID;
+        mutable std::map<unsigned int, Program> mPrograms;
     };
 }
\ No newline at end of file
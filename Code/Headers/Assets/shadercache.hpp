@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+
+namespace Assets
+{
+    // On-disk cache of linked program binaries keyed by a hash of the shader sources and the driver.
+    // Also switches on the driver's background compiler threads where GL_KHR_parallel_shader_compile exists.
+    class ShaderCache
+    {
+    public:
+        // Must be called on the context thread before any shaders are built
+        static void initialize(std::string const &cacheDirectory, GLADloadproc loader);
+        static bool isParallelCompileSupported() { return mParallelCompile; }
+
+        // Loads into a freshly created program; false if missing or rejected by the driver
+        static bool load(unsigned long long sourceHash, unsigned int program);
+        // Program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+        static void save(unsigned long long sourceHash, unsigned int program);
+
+    private:
+        static std::string getCachePath(unsigned long long key);
+        static unsigned long long getKey(unsigned long long sourceHash);
+
+        static bool mEnabled;
+        static bool mParallelCompile;
+        static unsigned long long mDriverHash;
+        static std::string mCacheDirectory;
+    };
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Assets
+{
+    // Expands #include "file" (relative to the including file, each file at most once) and
+    // inserts #define lines after #version. Emits #line directives so compiler errors point
+    // at the original file: source string N in a message is files[N].
+    class ShaderPreprocessor
+    {
+    public:
+        static std::string process(std::string const &path, std::vector<std::string> const &defines,
+                                   std::vector<std::string> &files);
+
+    private:
+        static void expand(std::string const &path, std::vector<std::string> const &defines,
+                           std::string &output, std::vector<std::string> &files);
+    };
+}
@@ -1,17 +1,34 @@
 #pragma once
 
+#include "Assets/texturecache.hpp"
+
 #include <string>
+#include <vector>
 
 namespace Assets
 {
     class Texture
     {
     public:
-        Texture(std::string const &path, bool flipVertically = false);
+        // Decoding never touches GL, so a texture may be created on a worker
+        // thread with upload = false and uploaded later on the context thread
+        Texture(std::string const &path, bool flipVertically = false, bool upload = true);
+        virtual ~Texture() { }
+
+        virtual void upload();
 
         std::string mPath;
         unsigned int mID;
+    protected:
+        Texture();
+
     private:
         void loadTexture(std::string const &path, bool flipVertically);
+
+        CompressedImage mCompressedImage;
+        std::vector<unsigned char> mPixels;
+        int mWidth;
+        int mHeight;
+        int mComponents;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Utils/mappedfile.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Assets
+{
+    // Block-compressed image with its full mip chain, either mapped from the
+    // cache or freshly encoded. Level pointers stay valid while the image lives.
+    struct CompressedImage
+    {
+        struct Level
+        {
+            int mWidth;
+            int mHeight;
+            const unsigned char *mData;
+            unsigned int mSize;
+        };
+
+        unsigned int mFormat;
+        std::vector<Level> mLevels;
+
+        std::shared_ptr<Utils::MappedFile> mFile;
+        std::vector<unsigned char> mStorage;
+    };
+
+    // On-disk cache of BC1/BC3/BC4/BC5 textures keyed by a hash of the source file.
+    // Missing entries are transcoded on first load.
+    class TextureCache
+    {
+    public:
+        // Must be called on the context thread before any texture loads
+        static void initialize(std::string const &cacheDirectory);
+        static bool isEnabled() { return mEnabled; }
+
+        static bool load(std::string const &path, bool flipVertically, bool mipmaps, CompressedImage &image);
+        static void upload(unsigned int target, CompressedImage const &image);
+
+    private:
+        static bool readCacheFile(std::string const &cachePath, unsigned long long sourceHash, CompressedImage &image);
+        static void writeCacheFile(std::string const &cachePath, unsigned long long sourceHash, CompressedImage const &image);
+        static bool transcode(Utils::MappedFile const &source, bool flipVertically, bool mipmaps, CompressedImage &image);
+
+        static bool mEnabled;
+        static std::string mCacheDirectory;
+    };
+}
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "Components/physicsbody.hpp"
+#include "Core/trackpath.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
 
 namespace Components
 {
@@ -14,11 +19,27 @@ namespace Components
         void setBrake(float force);
         void setSteering(float steering);
 
-        std::unique_ptr<btDefaultVehicleRaycaster> mVehicleRaycaster;
+        std::unique_ptr<btVehicleRaycaster> mVehicleRaycaster;
         std::unique_ptr<btRaycastVehicle> mVehicle;
 
         float mSteering;
 
+        // Wheel world transforms before the last simulation tick
+        btTransform mPreviousWheelTransforms[4];
+        // Wheel model matrices, interpolated between ticks like the chassis
+        glm::mat4 mWheelModelMatrices[4];
+
+        // Path the car follows while far from the player; cars without one always run full dynamics
+        std::shared_ptr<Core::TrackPath> mTrackPath;
+        // Following the path kinematically, with the rigid body out of the world
+        bool mKinematic = false;
+        // Kinematic state: distance along the path, speed along it, offset to the left of it,
+        // and chassis height above the terrain
+        float mPathDistance = 0.0f;
+        float mPathSpeed = 0.0f;
+        float mLaneOffset = 0.0f;
+        float mRideHeight = 0.0f;
+
     private:
         CarPhysicsBody(CarPhysicsBody const &) = delete;
         CarPhysicsBody &operator=(CarPhysicsBody const &) = delete;
@@ -2,6 +2,7 @@
 
 #include "Components/component.hpp"
 #include "Assets/material.hpp"
+#include "Assets/impostor.hpp"
 
 namespace Components
 {
@@ -12,6 +13,11 @@ namespace Components
         virtual ~MeshRenderer();
 
         std::shared_ptr<Assets::Material> mMaterial;
+        // Optional; drawn in place of the meshes once they shrink past the last LOD level
+        std::shared_ptr<Assets::Impostor> mImpostor;
+
+        // Selected by the rendering engine each frame; one past the last mesh level means the impostor
+        unsigned int mLodLevel = 0;
 
     private:
         MeshRenderer(MeshRenderer const &) = delete;
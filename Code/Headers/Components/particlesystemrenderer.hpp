@@ -21,6 +21,8 @@ namespace Components
 
         bool mIsActive;
         float mTimeActive;
+        // Expired, or restored from a saved state, since the renderer last saw it; its buffers start over
+        bool mPendingReset;
         
         unsigned int mPositionBuffer;
         unsigned int mVelocityBuffer;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Components/component.hpp"
+#include "Physics/motionstate.hpp"
 
 #include <bullet/btBulletDynamicsCommon.h>
 
@@ -17,7 +18,7 @@ namespace Components
         std::unique_ptr<btRigidBody> mRigidBody;
         std::unique_ptr<btCollisionShape> mShape;
         std::vector<std::shared_ptr<btCollisionShape>> mChildShapes;
-        std::unique_ptr<btDefaultMotionState> mMotionState;
+        std::unique_ptr<Physics::MotionState> mMotionState;
     private:
         PhysicsBody(PhysicsBody const &) = delete;
         PhysicsBody &operator=(PhysicsBody const &) = delete;
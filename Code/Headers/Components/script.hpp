@@ -2,6 +2,7 @@
 
 #include "Components/component.hpp"
 #include "Core/scene.hpp"
+#include "Core/statestream.hpp"
 
 #include <GLFW/glfw3.h>
 
@@ -15,6 +16,12 @@ namespace Components
 
         virtual void onStart(Core::Scene &scene) = 0;
         virtual void onUpdate(GLFWwindow *window, Core::Scene &scene, float deltaTime) = 0;
+        // Simulation state the script carries between ticks, for snapshots; scripts without any write nothing
+        virtual void saveState(Core::StateWriter &writer) const;
+        virtual void loadState(Core::StateReader &reader);
+    protected:
+        // False for every key when there is no window, as when the scene runs headless
+        static bool isKeyPressed(GLFWwindow *window, int key);
     private:
         Script(Script const &) = delete;
         Script &operator=(Script const &) = delete;
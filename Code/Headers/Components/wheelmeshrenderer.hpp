@@ -10,6 +10,8 @@
 
 namespace Components
 {
+    class CarPhysicsBody;
+
     class WheelMeshRenderer : public Component
     {
     public:
@@ -19,7 +21,8 @@ namespace Components
         std::shared_ptr<Assets::Material> mMaterial;
 
         std::vector<std::shared_ptr<Assets::Mesh>> mWheelMeshes;
-        std::vector<glm::mat4> mWheelModelMatrices;
+        // Vehicle whose wheel transforms the meshes are drawn at
+        std::shared_ptr<CarPhysicsBody> mCarPhysicsBody;
 
     private:
         WheelMeshRenderer(WheelMeshRenderer const &) = delete;
@@ -0,0 +1,29 @@
+#pragma once
+
+namespace Core
+{
+    // Seeded random number stream. Each system draws from its own stream, so the numbers one system uses do not
+    // depend on how many another drew; a stream's sequence depends only on the seed and its stream id.
+    class Random
+    {
+    public:
+        Random(unsigned long long stream);
+        ~Random();
+
+        // Seed for streams created afterwards
+        static void setSeed(unsigned long long seed) { mSeed = seed; }
+        static unsigned long long getSeed() { return mSeed; }
+
+        unsigned long long next();
+        // Uniform in [min, max)
+        float nextFloat(float min, float max);
+
+        // Position in the stream, for saving and restoring it
+        unsigned long long getState() const { return mState; }
+        void setState(unsigned long long state) { mState = state; }
+
+    private:
+        static unsigned long long mSeed;
+        unsigned long long mState;
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace Core
+{
+    // Splits variable frame times into fixed simulation ticks. Time left over after the last tick is
+    // kept for the next frame and, as a fraction of a tick, tells rendering how far to interpolate
+    // between the last two simulation states.
+    class SimulationClock
+    {
+    public:
+        SimulationClock(double tickRate, int maxTicksPerFrame);
+        ~SimulationClock();
+
+        // Accumulates a frame's elapsed time and returns how many ticks to run. Time beyond
+        // maxTicksPerFrame ticks is dropped, so a hitch slows the simulation rather than spiralling.
+        int advance(double frameTime);
+
+        double getTickLength() const { return mTickLength; }
+        // Fraction of a tick accumulated since the last tick ran, in [0, 1)
+        float getInterpolationFactor() const { return (float) (mAccumulator / mTickLength); }
+        unsigned long long getTickCount() const { return mTickCount; }
+
+    private:
+        SimulationClock(SimulationClock const &) = delete;
+        SimulationClock & operator=(SimulationClock const &) = delete;
+
+        double mTickLength;
+        int mMaxTicksPerFrame;
+        double mAccumulator;
+        unsigned long long mTickCount;
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Core/scene.hpp"
+
+#include <vector>
+
+namespace Physics
+{
+    class PhysicsEngine;
+}
+
+namespace Core
+{
+    // Records the simulation for rewind and replay. Every tick's state is serialized and hashed; every interval
+    // ticks the serialized state is also kept, in a ring of snapshots. A tick simulated again after a rewind is
+    // checked against the hash it had the first time, so replays that diverge are reported at the tick they do.
+    class StateRecorder
+    {
+    public:
+        StateRecorder(Scene &scene, Physics::PhysicsEngine &physicsEngine, int capacity, int interval);
+        ~StateRecorder();
+
+        // Called after each tick
+        void record();
+        // Restores the latest snapshot at least ticks before the last recorded tick. Returns false if none is
+        // that old.
+        bool rewind(unsigned long long ticks);
+
+        unsigned long long getLastHash() const { return mLastHash; }
+
+    private:
+        StateRecorder(StateRecorder const &) = delete;
+        StateRecorder & operator=(StateRecorder const &) = delete;
+
+        void save(std::vector<unsigned char> &data) const;
+        void load(std::vector<unsigned char> const &data);
+
+        struct Snapshot
+        {
+            unsigned long long mTick;
+            bool mValid;
+            std::vector<unsigned char> mData;
+        };
+
+        struct TickHash
+        {
+            unsigned long long mTick;
+            bool mValid;
+            unsigned long long mHash;
+        };
+
+        Scene &mScene;
+        Physics::PhysicsEngine &mPhysicsEngine;
+        int mInterval;
+
+        std::vector<Snapshot> mSnapshots;
+        int mNextSnapshot;
+        // Hashes of the ticks the snapshots cover, indexed by tick
+        std::vector<TickHash> mHashes;
+        // Serialized state of the latest tick; swapped into the ring rather than copied
+        std::vector<unsigned char> mScratch;
+        unsigned long long mLastHash;
+        // Divergence is reported once per rewind
+        bool mDivergenceReported;
+    };
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+namespace Core
+{
+    // Appends values to a binary state buffer. Values are copied byte for byte, so they must be plain data without
+    // padding, or two equal states would not compare or hash equal.
+    class StateWriter
+    {
+    public:
+        StateWriter(std::vector<unsigned char> &data) : mData(data) { }
+
+        template <typename T>
+        void write(T const &value)
+        {
+            unsigned char const *bytes = reinterpret_cast<unsigned char const *>(&value);
+            mData.insert(mData.end(), bytes, bytes + sizeof(T));
+        }
+
+    private:
+        StateWriter(StateWriter const &) = delete;
+        StateWriter & operator=(StateWriter const &) = delete;
+
+        std::vector<unsigned char> &mData;
+    };
+
+    // Reads values back in the order a StateWriter wrote them
+    class StateReader
+    {
+    public:
+        StateReader(std::vector<unsigned char> const &data) : mData(data), mOffset(0) { }
+
+        template <typename T>
+        void read(T &value)
+        {
+            std::memcpy(&value, mData.data() + mOffset, sizeof(T));
+            mOffset += sizeof(T);
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            read(value);
+            return value;
+        }
+
+    private:
+        StateReader(StateReader const &) = delete;
+        StateReader & operator=(StateReader const &) = delete;
+
+        std::vector<unsigned char> const &mData;
+        size_t mOffset;
+    };
+
+    // 64 bit hash of a state buffer, eight bytes at a time
+    unsigned long long hashState(std::vector<unsigned char> const &data);
+}
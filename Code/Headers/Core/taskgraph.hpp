@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Core/threadpool.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Core
+{
+    // Dependency graph of one-shot tasks. Worker tasks run on the thread pool,
+    // main tasks run on the thread that calls run() (i.e. the one owning the GL context).
+    class TaskGraph
+    {
+    public:
+        TaskGraph(ThreadPool &threadPool);
+
+        int addWorkerTask(std::string const &name, std::function<void()> function, std::vector<int> const &dependencies = {});
+        int addMainTask(std::string const &name, std::function<void()> function, std::vector<int> const &dependencies = {});
+
+        void run();
+        void report() const;
+
+    private:
+        TaskGraph(TaskGraph const &) = delete;
+        TaskGraph & operator=(TaskGraph const &) = delete;
+
+        struct Task
+        {
+            std::string mName;
+            std::function<void()> mFunction;
+            std::vector<int> mDependents;
+            int mRemainingDependencies;
+            bool mMainThread;
+            double mStartTime;
+            double mEndTime;
+        };
+
+        int addTask(std::string const &name, std::function<void()> function, std::vector<int> const &dependencies, bool mainThread);
+        void schedule(int taskIdx);
+        void execute(int taskIdx);
+        double elapsedSeconds() const;
+
+        ThreadPool &mThreadPool;
+        std::vector<Task> mTasks;
+        std::deque<int> mReadyMainTasks;
+        int mCompletedTasks;
+        double mTotalTime;
+        std::chrono::steady_clock::time_point mRunStart;
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Core
+{
+    class ThreadPool
+    {
+    public:
+        // A thread count of zero uses one worker per hardware thread, less the main thread
+        ThreadPool(unsigned int numThreads = 0);
+        ~ThreadPool();
+
+        // Engine-wide pool shared by asset loading and simulation
+        static ThreadPool &getInstance();
+
+        void submit(std::function<void()> task);
+        // Runs function(i) for i in [0, count). The calling thread takes part, so this is safe to call from a worker.
+        void parallelFor(int count, std::function<void(int)> const &function);
+        // Runs function once on every worker, e.g. to set up per-thread state. Must not be called from a worker.
+        void runOnEachWorker(std::function<void()> const &function);
+        unsigned int getNumThreads() const { return mWorkers.size(); }
+
+    private:
+        ThreadPool(ThreadPool const &) = delete;
+        ThreadPool & operator=(ThreadPool const &) = delete;
+
+        void workerLoop();
+
+        std::vector<std::thread> mWorkers;
+        std::deque<std::function<void()>> mTasks;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mStopping;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace Core
+{
+    // Closed Catmull-Rom spline through points in the ground (x, z) plane, parameterized by arc length.
+    // The spline is sampled densely once; lookups interpolate between samples and wrap around the loop.
+    class TrackPath
+    {
+    public:
+        TrackPath(std::vector<glm::vec2> const &controlPoints, int samplesPerSegment = 16);
+        ~TrackPath();
+
+        // Path through segments points on an ellipse with semi-axes a along x and b along z, running from +x
+        // towards +z
+        static std::shared_ptr<TrackPath> createEllipse(float a, float b, int segments);
+        // Racing line between two elliptical walls: on the middle ellipse where its curvature is average, moving up
+        // to swing towards the inner wall where it bends hardest and towards the outer wall where it is straightest
+        static std::shared_ptr<TrackPath> createRacingLine(float innerA, float innerB, float outerA, float outerB,
+                                                           float swing, int segments);
+
+        float getLength() const { return mLength; }
+        glm::vec2 getPosition(float distance) const;
+        // Unit direction of travel
+        glm::vec2 getTangent(float distance) const;
+        // Unit direction to the left of travel, which points out of the loops built by createEllipse
+        glm::vec2 getLateral(float distance) const;
+        // Signed curvature, positive when the path turns to the right
+        float getCurvature(float distance) const;
+        // Distance along the path of the point nearest position
+        float getClosestDistance(glm::vec2 position) const;
+        // Same, searching only within range of a distance already known to be close
+        float getClosestDistance(glm::vec2 position, float nearDistance, float range) const;
+
+    private:
+        TrackPath(TrackPath const &) = delete;
+        TrackPath & operator=(TrackPath const &) = delete;
+
+        // Sample before distance, and how far distance lies towards the next one
+        void locate(float distance, int &sample, float &fraction) const;
+        // Nearest point on the chords from sample first onwards, wrapping around the loop
+        float findClosestDistance(glm::vec2 position, int first, int count) const;
+
+        std::vector<glm::vec2> mPositions;
+        std::vector<glm::vec2> mTangents;
+        std::vector<float> mCurvatures;
+        // Arc length at each sample; one more than the samples, ending at the total length
+        std::vector<float> mDistances;
+        float mLength;
+    };
+}
@@ -13,9 +13,12 @@ namespace Objects
     class Car : public Core::GameObject
     {
     public:
-        Car(glm::vec3 position, const Physics::PhysicsEngine &physicsEngine);
+        // Only the player's car gets the keyboard script and the camera that follows it
+        Car(glm::vec3 position, const Physics::PhysicsEngine &physicsEngine, bool isPlayer = true);
         ~Car();
 
+        // load() does CPU-side work only and may run on a worker thread; setup() creates GL resources
+        static void load();
         static void setup(std::shared_ptr<Assets::Shader> geometryShader);
     private:
         Car(Car const &) = delete;
@@ -4,6 +4,7 @@
 #include "Physics/physicsengine.hpp"
 #include "Assets/mesh.hpp"
 #include "Assets/material.hpp"
+#include "Assets/impostor.hpp"
 
 #include <glm/glm.hpp>
 
@@ -17,6 +18,8 @@ namespace Objects
         Streetlight(glm::vec3 position, float theta, bool onLeft, const Physics::PhysicsEngine &physicsEngine);
         ~Streetlight();
 
+        // load() does CPU-side work only and may run on a worker thread; setup() creates GL resources
+        static void load();
         static void setup(std::shared_ptr<Assets::Shader> geometryShader);
     private:
         Streetlight(Streetlight const &) = delete;
@@ -24,6 +27,7 @@ namespace Objects
 
         static std::shared_ptr<Assets::Mesh> mPostMesh;
         static std::shared_ptr<Assets::Material> mPostMaterial;
+        static std::shared_ptr<Assets::Impostor> mPostImpostor;
 
         static std::shared_ptr<Assets::Mesh> mBulbMesh;
         static std::shared_ptr<Assets::Material> mBulbMaterial;
@@ -2,8 +2,10 @@
 
 #include "Core/gameobject.hpp"
 #include "Physics/physicsengine.hpp"
+#include "Physics/heightfieldquery.hpp"
 #include "Assets/mesh.hpp"
 #include "Assets/material.hpp"
+#include "Assets/heightfield.hpp"
 
 #include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 
@@ -16,24 +18,25 @@ namespace Objects
     {
     public:
         Terrain(glm::vec3 position, const Physics::PhysicsEngine &physicsEngine);
-        ~Terrain();
 
 
+        // load() does CPU-side work only and may run on a worker thread; setup() creates GL resources
+        static void load();
         static void setup(std::shared_ptr<Assets::Shader> terrainShader);
+        static float getHeight(float x, float z);
+        // Batched heights, and optionally normals, for AI and gameplay code; safe to call from any thread
+        static void getHeights(float const *x, float const *z, int count, float *heights, glm::vec3 *normals = nullptr);
 
     private:
         Terrain(Terrain const &) = delete;
         Terrain & operator=(Terrain const &) = delete;
 
-        static void loadHeightMap(std::string heightMap);
-
         static std::shared_ptr<btHeightfieldTerrainShape> mTerrainShape;
 
         static std::shared_ptr<Assets::Mesh> mMesh;
         static std::shared_ptr<Assets::Material> mMaterial;
 
-        static int mHeightmapWidth;
-        static int mHeightmapHeight;
-        static unsigned char *mHeightData;
+        static std::shared_ptr<Assets::HeightField> mHeightField;
+        static std::shared_ptr<Physics::HeightFieldQuery> mHeightFieldQuery;
     };
 }
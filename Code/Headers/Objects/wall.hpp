@@ -20,7 +20,9 @@ namespace Objects
         Wall(glm::vec3 position, const Physics::PhysicsEngine &physicsEngine);
         ~Wall() { }
 
-        static void setup(std::shared_ptr<Assets::Shader> geometryShader, float trackInnerA, float trackInnerB, float trackOuterA, float trackOuterB);
+        // load() does CPU-side work only and may run on a worker thread; setup() creates GL resources
+        static void load(float trackInnerA, float trackInnerB, float trackOuterA, float trackOuterB);
+        static void setup(std::shared_ptr<Assets::Shader> geometryShader);
 
     private:
         Wall(Wall const &) = delete;
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Assets/heightfield.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+
+namespace Physics
+{
+    // World space height and normal lookups on a height field, matching the btHeightfieldTerrainShape built from
+    // it. The field is centered on the origin in x and z and spans [0, size.y] vertically; heights are bilinear
+    // between samples. Read-only, so any thread may query it.
+    class HeightFieldQuery
+    {
+    public:
+        HeightFieldQuery(std::shared_ptr<Assets::HeightField> heightField, glm::vec3 size);
+
+        bool contains(float x, float z) const;
+        float getHeight(float x, float z, glm::vec3 *normal = nullptr) const;
+        // Heights, and optionally normals, at count positions; evaluated four at a time with SSE2 where available
+        void getHeights(float const *x, float const *z, int count, float *heights, glm::vec3 *normals = nullptr) const;
+
+    private:
+        HeightFieldQuery(HeightFieldQuery const &) = delete;
+        HeightFieldQuery & operator=(HeightFieldQuery const &) = delete;
+
+        std::shared_ptr<Assets::HeightField> mHeightField;
+        glm::vec3 mSize;
+        // Samples per world unit along x and z, and world height per sample value
+        float mSamplesPerX;
+        float mSamplesPerZ;
+        float mHeightScale;
+    };
+}
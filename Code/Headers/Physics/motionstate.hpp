@@ -0,0 +1,53 @@
+#pragma once
+
+#include <bullet/btBulletDynamicsCommon.h>
+
+#include <vector>
+
+namespace Components
+{
+    class PhysicsBody;
+}
+
+namespace Physics
+{
+    // Bodies Bullet moved during a tick, in the order it reported them
+    struct MovedBodies
+    {
+        std::vector<Components::PhysicsBody *> mBodies;
+        unsigned long long mTick = 0;
+    };
+
+    // Bullet only reports transforms for active, non-static bodies, so static and sleeping ones never reach
+    // the moved list and cost nothing to keep in sync. Keeps the transform from before the body's latest
+    // tick for render interpolation.
+    class MotionState : public btMotionState
+    {
+    public:
+        MotionState(btTransform const &startTransform, Components::PhysicsBody &physicsBody, MovedBodies &movedBodies);
+        virtual ~MotionState();
+
+        virtual void getWorldTransform(btTransform &worldTransform) const override;
+        virtual void setWorldTransform(btTransform const &worldTransform) override;
+
+        // Places the body without it interpolating from where it was
+        void teleport(btTransform const &worldTransform);
+        // Stops interpolating once the body has come to rest
+        void settle() { mPreviousTransform = mTransform; }
+
+        btTransform const &getTransform() const { return mTransform; }
+        btTransform const &getPreviousTransform() const { return mPreviousTransform; }
+        unsigned long long getMovedTick() const { return mMovedTick; }
+
+    private:
+        MotionState(MotionState const &) = delete;
+        MotionState & operator=(MotionState const &) = delete;
+
+        btTransform mTransform;
+        btTransform mPreviousTransform;
+        unsigned long long mMovedTick;
+
+        Components::PhysicsBody &mPhysicsBody;
+        MovedBodies &mMovedBodies;
+    };
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+namespace Physics
+{
+    // Steps scenes of free falling box stacks with each thread count and prints the time per tick,
+    // to show how the multithreaded world scales with body count
+    class PhysicsBenchmark
+    {
+    public:
+        static void run(std::vector<int> const &bodyCounts, std::vector<int> const &threadCounts, int numTicks);
+
+    private:
+        // Average milliseconds per tick for one body and thread count
+        static double measure(int bodyCount, int numThreads, int numTicks);
+    };
+}
@@ -1,29 +1,85 @@
 #pragma once
 
+#include "Physics/motionstate.hpp"
+#include "Physics/simulationlod.hpp"
+#include "Physics/taskscheduler.hpp"
+#include "Physics/vehicleground.hpp"
 #include "Core/scene.hpp"
+#include "Core/statestream.hpp"
 
 #include <bullet/btBulletDynamicsCommon.h>
 
+#include <vector>
+
+namespace Components
+{
+    class CarPhysicsBody;
+}
+
 namespace Physics
 {
     class PhysicsEngine
     {
     public:
-        PhysicsEngine();
+        // More than one thread steps a multithreaded world on the engine thread pool, when Bullet is built with
+        // BT_THREADSAFE; otherwise the world is stepped on the calling thread alone
+        PhysicsEngine(int numThreads = 1);
         ~PhysicsEngine();
 
-        void updateScene(Core::Scene const &scene, double deltaTime);
+        // Advances the simulation by one fixed tick
+        void updateScene(Core::Scene const &scene, double tickLength);
+        // Poses game objects between the states before and after the last tick; a factor of 1 restores the simulation state
+        void interpolateTransforms(float interpolationFactor);
         void updateDirtyTransforms(std::shared_ptr<Core::GameObject> gameObject, glm::mat4 matrix, bool parentDirty);
         void connectDebugRenderer(btIDebugDraw *debugRenderer);
+        void drawDebugWorld();
+        // Threads the world is stepped on, including the calling thread
+        int getNumThreads() const;
+        unsigned long long getTickCount() const { return mTickCount; }
+
+        // Dynamic state of the scene's bodies and vehicles, and which vehicles follow their paths
+        void saveState(Core::Scene const &scene, Core::StateWriter &writer) const;
+        // Restores a saved state and poses game objects there, without interpolating from where they were
+        void loadState(Core::Scene const &scene, Core::StateReader &reader);
+        // Drops contact caches and rebuilds the broadphase, re-adding bodies in scene order, so that stepping
+        // from a restored state repeats what followed when it was saved
+        void resetCollisionState(Core::Scene const &scene);
+
+        // Motion state reporting the body to this engine whenever Bullet moves it
+        std::unique_ptr<MotionState> createMotionState(btTransform const &startTransform, Components::PhysicsBody &physicsBody) const;
+        // Wheel raycaster that resolves rays against the terrain height field where it can
+        std::unique_ptr<btVehicleRaycaster> createVehicleRaycaster() const;
+        // Terrain and static colliders vehicle raycasters check; the terrain registers itself here
+        VehicleGround &getVehicleGround() const { return *mVehicleGround; }
 
         std::unique_ptr<btDefaultCollisionConfiguration> mCollisionConfiguration;
         std::unique_ptr<btCollisionDispatcher> mDispatcher;
         std::unique_ptr<btDbvtBroadphase> mOverlappingPairCache;
-        std::unique_ptr<btSequentialImpulseConstraintSolver> mSolver;
+        // Solvers handed out to islands solved in parallel; unused by a single threaded world
+        std::unique_ptr<btConstraintSolver> mSolverPool;
+        std::unique_ptr<btConstraintSolver> mSolver;
         std::unique_ptr<btDiscreteDynamicsWorld> mDynamicsWorld;
 
     private:
         PhysicsEngine(PhysicsEngine const &) = delete;
         PhysicsEngine & operator=(PhysicsEngine const &) = delete;
+
+        // Records the scene's vehicles and their wheel transforms from before the tick
+        void gatherVehicles(Core::Scene const &scene);
+        // Called by Bullet after each tick's integration, where it would otherwise update vehicles one at a time
+        static void vehicleTickCallback(btDynamicsWorld *dynamicsWorld, btScalar timeStep);
+        void updateVehicles(btScalar timeStep);
+        void writeTransform(Components::PhysicsBody &physicsBody, btTransform const &physicsBodyTransform);
+
+        std::unique_ptr<TaskScheduler> mTaskScheduler;
+        unsigned long long mTickCount;
+        // Bodies moved by the latest tick, and those moved by the tick before it
+        std::unique_ptr<MovedBodies> mMovedBodies;
+        std::vector<Components::PhysicsBody *> mPreviouslyMovedBodies;
+        std::vector<Components::CarPhysicsBody *> mCarPhysicsBodies;
+        // Vehicles running full dynamics this tick, rather than following their paths
+        std::vector<Components::CarPhysicsBody *> mDynamicCarPhysicsBodies;
+        std::unique_ptr<VehicleGround> mVehicleGround;
+        std::unique_ptr<SimulationLod> mSimulationLod;
     };
 }
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Physics/heightfieldquery.hpp"
+
+#include <bullet/btBulletDynamicsCommon.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Components
+{
+    class CarPhysicsBody;
+}
+
+namespace Physics
+{
+    // Simulation level of detail for vehicles with a track path. Away from the player and from other cars, a
+    // vehicle leaves the dynamics world and follows its path kinematically: a distance along the spline and a
+    // speed, with its lane offset and ride height kept from the handover and the terrain sampled beneath it.
+    // Coming near the player or another car returns it to full dynamics, moving at the speed it had.
+    class SimulationLod
+    {
+    public:
+        SimulationLod();
+        ~SimulationLod();
+
+        // Moves cars between full dynamics and path following; run before the tick is stepped
+        void update(std::vector<Components::CarPhysicsBody *> const &carPhysicsBodies, btDynamicsWorld &dynamicsWorld,
+                    HeightFieldQuery const *heightFieldQuery);
+        // Moves kinematic cars along their paths by one tick; run after the tick is stepped
+        void advance(std::vector<Components::CarPhysicsBody *> const &carPhysicsBodies, HeightFieldQuery const &heightFieldQuery,
+                     float tickLength);
+
+    private:
+        SimulationLod(SimulationLod const &) = delete;
+        SimulationLod & operator=(SimulationLod const &) = delete;
+
+        bool canFollowPath(Components::CarPhysicsBody &carPhysicsBody, HeightFieldQuery const *heightFieldQuery) const;
+        void makeKinematic(Components::CarPhysicsBody &carPhysicsBody, btDynamicsWorld &dynamicsWorld,
+                           HeightFieldQuery const &heightFieldQuery);
+        void makeDynamic(Components::CarPhysicsBody &carPhysicsBody, btDynamicsWorld &dynamicsWorld);
+        // Squared distance from car index to the nearest other car, if one is within the grid's reach
+        float getNearestCarDistance2(int index) const;
+        long long getCellKey(glm::vec2 position) const;
+
+        // Ground positions of this tick's cars, and their indices sorted by grid cell
+        std::vector<glm::vec2> mPositions;
+        std::vector<std::pair<long long, int>> mCells;
+        // Positions of cars that always run full dynamics
+        std::vector<glm::vec2> mFoci;
+
+        // Kinematic cars advanced this tick, with their positions and the terrain beneath them
+        std::vector<Components::CarPhysicsBody *> mKinematicCars;
+        std::vector<float> mX;
+        std::vector<float> mZ;
+        std::vector<float> mHeights;
+        std::vector<glm::vec3> mNormals;
+    };
+}
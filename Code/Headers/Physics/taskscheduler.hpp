@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Core/threadpool.hpp"
+
+#include <LinearMath/btThreads.h>
+
+#include <functional>
+
+namespace Physics
+{
+    // Runs Bullet's parallel loops on the engine thread pool, with the stepping thread taking part in every loop.
+    // Bullet indexes per-thread storage by btGetCurrentThreadIndex() and sizes it from getNumThreads(), so the pool's
+    // workers claim their indices up front and getNumThreads() covers every worker; setNumThreads() only limits how
+    // many of them a loop is split across.
+    class TaskScheduler : public btITaskScheduler
+    {
+    public:
+        TaskScheduler(int numThreads);
+        virtual ~TaskScheduler();
+
+        virtual int getMaxNumThreads() const override;
+        virtual int getNumThreads() const override;
+        virtual void setNumThreads(int numThreads) override;
+
+        virtual void parallelFor(int iBegin, int iEnd, int grainSize, btIParallelForBody const &body) override;
+        virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, btIParallelSumBody const &body) override;
+
+    private:
+        TaskScheduler(TaskScheduler const &) = delete;
+        TaskScheduler & operator=(TaskScheduler const &) = delete;
+
+        // Number of jobs a range is split into, each at least grainSize long and at most one per thread
+        int getJobCount(int iBegin, int iEnd, int grainSize) const;
+        // Runs function(job) for job in [0, jobs) on the stepping thread and jobs-1 workers
+        void runJobs(int jobs, std::function<void(int)> const &function);
+
+        int mNumThreads;
+    };
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Physics/heightfieldquery.hpp"
+
+#include <bullet/btBulletDynamicsCommon.h>
+
+#include <memory>
+#include <vector>
+
+namespace Physics
+{
+    // What wheel rays land on: the terrain height field, which can be queried directly, and a coarse grid of
+    // every other static collider, so rays that might hit one of those know to fall back to a world ray test
+    class VehicleGround
+    {
+    public:
+        VehicleGround();
+        ~VehicleGround();
+
+        void setTerrain(btCollisionObject const *terrainObject, std::shared_ptr<HeightFieldQuery> heightFieldQuery);
+        // Rebuilds the collider grid if static bodies were added or removed since the last call
+        void update(btCollisionWorld &collisionWorld);
+
+        btCollisionObject const *getTerrainObject() const { return mTerrainObject; }
+        HeightFieldQuery const *getHeightFieldQuery() const { return mHeightFieldQuery.get(); }
+        // Whether any static collider other than the terrain may overlap the box
+        bool isNearCollider(btVector3 const &aabbMin, btVector3 const &aabbMax) const;
+
+    private:
+        VehicleGround(VehicleGround const &) = delete;
+        VehicleGround & operator=(VehicleGround const &) = delete;
+
+        struct Bounds
+        {
+            btVector3 mMin;
+            btVector3 mMax;
+        };
+
+        void addColliderBounds(btCollisionShape const *shape, btTransform const &transform);
+        // Grid cells covered by x and z bounds, clamped to the grid
+        void getCellRange(btVector3 const &aabbMin, btVector3 const &aabbMax, int &minX, int &minZ, int &maxX, int &maxZ) const;
+
+        btCollisionObject const *mTerrainObject;
+        std::shared_ptr<HeightFieldQuery> mHeightFieldQuery;
+
+        // Bounds of static colliders; walls and other meshes add one per triangle
+        std::vector<Bounds> mBounds;
+        // Bounds overlapping each cell, as ranges of mCellBounds indexed by mCellStarts
+        std::vector<int> mCellStarts;
+        std::vector<int> mCellBounds;
+        btVector3 mGridMin;
+        int mCellsX;
+        int mCellsZ;
+        int mStaticObjectCount;
+    };
+}
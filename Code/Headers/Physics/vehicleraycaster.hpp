@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Physics/vehicleground.hpp"
+
+#include <bullet/btBulletDynamicsCommon.h>
+
+namespace Physics
+{
+    // Resolves wheel rays against the terrain height field directly, without a broadphase query. Rays off the
+    // terrain or near another static collider take btDefaultVehicleRaycaster's world ray test instead.
+    // Other vehicles are not hit by rays that stay on the terrain.
+    class VehicleRaycaster : public btDefaultVehicleRaycaster
+    {
+    public:
+        VehicleRaycaster(btDynamicsWorld *dynamicsWorld, VehicleGround const &vehicleGround);
+        virtual ~VehicleRaycaster();
+
+        virtual void *castRay(btVector3 const &from, btVector3 const &to, btVehicleRaycasterResult &result) override;
+
+    private:
+        VehicleRaycaster(VehicleRaycaster const &) = delete;
+        VehicleRaycaster & operator=(VehicleRaycaster const &) = delete;
+
+        VehicleGround const &mVehicleGround;
+    };
+}
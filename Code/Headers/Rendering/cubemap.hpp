@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Assets/shader.hpp"
+#include "Assets/texturecache.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -20,6 +21,8 @@ namespace Rendering
         ~CubeMap() { }
 
         void setFaces(std::vector<std::string> faces);
+        void loadFace(unsigned int face, std::string const &path);
+        void upload();
         std::shared_ptr<Assets::Shader> getShader();
         void draw() const;
 
@@ -31,5 +34,15 @@ namespace Rendering
         GLuint mVAO;
         GLuint mVBO;
         GLuint mTextureID;
+
+        // Decoded faces waiting for upload
+        struct FaceData
+        {
+            Assets::CompressedImage mCompressedImage;
+            std::vector<unsigned char> mPixels;
+            int mWidth;
+            int mHeight;
+        };
+        FaceData mFaces[6];
     };
 }
\ No newline at end of file
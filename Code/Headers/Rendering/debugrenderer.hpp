@@ -22,8 +22,9 @@ namespace Rendering
     public:
         DebugRenderer();
 
-        void drawAccumulated();
-        void clear();
+        // Lines are accumulated by the simulation and handed over once per frame, then drawn by the renderer
+        void takeLines(std::vector<Vertex> &lines);
+        void draw(std::vector<Vertex> const &lines);
 
         virtual void drawLine(const btVector3 &from, const btVector3 &to, const btVector3 &color) override;
         virtual void drawContactPoint(const btVector3 &PointOnB, const btVector3 &normalOnB, btScalar distance, int lifeTime, const btVector3 &color) override;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Rendering/rendersettings.hpp"
+
+#include <glad/glad.h>
+
+namespace Rendering
+{
+    // Measures GPU frame time with timer queries and steers the internal render scale towards
+    // the configured frame time budget. Query results are read a few frames late so the CPU
+    // never waits on the GPU.
+    class DynamicResolution
+    {
+    public:
+        DynamicResolution();
+        ~DynamicResolution();
+
+        // Bracket the GPU work of one frame
+        void beginFrame();
+        void endFrame();
+
+        // Feeds the latest measurement through the controller and returns the scale to render at
+        float update(RenderSettings const &renderSettings);
+
+        float getScale() const { return mScale; }
+        // Most recent GPU frame time in seconds, or 0 before the first measurement arrives
+        double getGPUTime() const { return mGPUTime; }
+
+    private:
+        DynamicResolution(DynamicResolution const &) = delete;
+        DynamicResolution & operator=(DynamicResolution const &) = delete;
+
+        static const int QUERY_COUNT = 4;
+
+        GLuint mQueries[QUERY_COUNT];
+        bool mQueryIssued[QUERY_COUNT];
+        int mCurrentQuery;
+
+        double mGPUTime;
+        bool mNewMeasurement;
+
+        float mScale;
+        float mIntegral;
+        // Frame time error of the latest measurement, as a fraction of the budget
+        float mError;
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Rendering/renderingengine.hpp"
+#include "Rendering/rendersnapshot.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rendering
+{
+    // Draws frames on a dedicated thread that owns the GL context, while the calling thread simulates the
+    // next ones. Snapshots come from a fixed set: with two, one is being drawn while the other is filled,
+    // and a third lets the simulation run a frame further ahead to absorb render hitches.
+    class FramePipeline
+    {
+    public:
+        // Takes the window's context from the calling thread. A negative CPU leaves the render thread unpinned.
+        FramePipeline(GLFWwindow *window, RenderingEngine &renderingEngine, int framesInFlight, int renderCPU);
+        // Draws the frames still queued, then hands the context back to the calling thread
+        ~FramePipeline();
+
+        // Blocks until a snapshot is free to be filled
+        RenderSnapshot &acquireSnapshot();
+        // Queues the acquired snapshot for drawing
+        void submitSnapshot();
+
+    private:
+        FramePipeline(FramePipeline const &) = delete;
+        FramePipeline & operator=(FramePipeline const &) = delete;
+
+        void renderLoop();
+
+        GLFWwindow *mWindow;
+        RenderingEngine &mRenderingEngine;
+        int mRenderCPU;
+
+        std::vector<std::unique_ptr<RenderSnapshot>> mSnapshots;
+        std::deque<RenderSnapshot *> mFreeSnapshots;
+        std::deque<RenderSnapshot *> mQueuedSnapshots;
+        RenderSnapshot *mAcquiredSnapshot;
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mStopping;
+
+        std::thread mRenderThread;
+    };
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace Rendering
+{
+    // Whether the process has a GL context. Without one, assets and components keep their CPU-side data but
+    // skip creating GPU resources, so the scene can be built and simulated headless.
+    class GraphicsContext
+    {
+    public:
+        static void setHeadless(bool headless) { mHeadless = headless; }
+        static bool isHeadless() { return mHeadless; }
+
+    private:
+        static bool mHeadless;
+    };
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Rendering
+{
+    // Size and format of a graph texture. Transient textures with equal descriptions share pooled storage.
+    struct TextureDesc
+    {
+        int mWidth;
+        int mHeight;
+        GLenum mInternalFormat;
+        GLenum mFilter;
+
+        bool operator==(TextureDesc const &other) const;
+    };
+
+    // Frame described as passes that declare the textures they read and write. Each frame the graph culls
+    // passes whose outputs nothing uses, aliases transient textures with disjoint lifetimes onto a pool
+    // that survives across frames, and binds framebuffers and issues memory barriers from the declarations.
+    // Passes run in the order they are added.
+    class RenderGraph
+    {
+    public:
+        typedef int Resource;
+
+        class PassBuilder
+        {
+        public:
+            // Contents are undefined when the first pass using it starts
+            Resource createTexture(std::string const &name, TextureDesc const &desc);
+            // Sampled by the pass
+            Resource read(Resource resource);
+            // Color attachment, in attachment order; previous contents are kept
+            Resource write(Resource resource);
+            // Depth attachment, tested against and possibly written
+            Resource writeDepth(Resource resource);
+            // Image load/store access, bound to image units in order: storage reads, then storage writes
+            Resource readStorage(Resource resource);
+            Resource writeStorage(Resource resource);
+            // Keeps the pass even if nothing reads what it writes
+            void setSideEffect();
+            // Restricts the viewport to the bottom-left corner of the targets; by default it covers them
+            void setRenderArea(int width, int height);
+
+        private:
+            friend class RenderGraph;
+            PassBuilder(RenderGraph &graph, int pass) : mGraph(graph), mPass(pass) { }
+
+            RenderGraph &mGraph;
+            int mPass;
+        };
+
+        typedef std::function<void(PassBuilder &)> SetupFunction;
+        typedef std::function<void()> ExecuteFunction;
+
+        RenderGraph();
+        ~RenderGraph();
+
+        // Clears the previous frame's passes; the default framebuffer is imported at the given size
+        void beginFrame(int width, int height);
+        Resource getBackbuffer() const { return mBackbuffer; }
+        TextureDesc const &getDesc(Resource resource) const;
+
+        void addPass(std::string const &name, SetupFunction const &setup, ExecuteFunction const &execute);
+        void execute();
+
+        // Valid while a pass that uses the resource executes
+        GLuint getTexture(Resource resource) const;
+        // Framebuffer with the resource as its only color attachment, e.g. as a blit source
+        GLuint getFramebuffer(Resource resource);
+        // Rebinds the executing pass's framebuffer and viewport after code that changed them
+        void bindPassTarget();
+
+        unsigned int getCulledPassCount() const;
+        unsigned int getPooledTextureCount() const { return mPool.size(); }
+
+    private:
+        RenderGraph(RenderGraph const &) = delete;
+        RenderGraph & operator=(RenderGraph const &) = delete;
+
+        struct ResourceNode
+        {
+            std::string mName;
+            TextureDesc mDesc;
+            bool mImported;
+            int mPoolIndex;
+            // Barrier bits the last image store still needs before each kind of access sees it
+            GLbitfield mPendingBarriers;
+        };
+
+        struct Pass
+        {
+            std::string mName;
+            ExecuteFunction mExecute;
+            std::vector<Resource> mReads;
+            std::vector<Resource> mWrites;
+            std::vector<Resource> mStorageReads;
+            std::vector<Resource> mStorageWrites;
+            Resource mDepth;
+            int mRenderWidth;
+            int mRenderHeight;
+            bool mSideEffect;
+            bool mCulled;
+
+            std::vector<Resource> mAllocations;
+            std::vector<Resource> mReleases;
+        };
+
+        struct PooledTexture
+        {
+            GLuint mID;
+            TextureDesc mDesc;
+            unsigned int mLastUsedFrame;
+            bool mInUse;
+        };
+
+        void cull();
+        void computeLifetimes();
+        void insertBarriers(Pass const &pass);
+        void bindTargets(Pass const &pass);
+        void bindImages(Pass const &pass);
+        int acquireTexture(TextureDesc const &desc);
+        void collectGarbage();
+        GLuint getFramebuffer(std::vector<Resource> const &colors, Resource depth);
+
+        std::vector<ResourceNode> mResources;
+        std::vector<Pass> mPasses;
+        Resource mBackbuffer;
+        int mCurrentPass;
+        unsigned int mFrame;
+
+        std::vector<PooledTexture> mPool;
+        // Keyed by color attachment textures followed by the depth texture (or 0)
+        std::map<std::vector<GLuint>, GLuint> mFramebuffers;
+    };
+}
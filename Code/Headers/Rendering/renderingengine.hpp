@@ -2,9 +2,14 @@
 
 #include "Rendering/textrenderer.hpp"
 #include "Rendering/debugrenderer.hpp"
+#include "Rendering/rendergraph.hpp"
+#include "Rendering/dynamicresolution.hpp"
 #include "Assets/material.hpp"
+#include "Assets/impostor.hpp"
+#include "Assets/mesh.hpp"
+#include "Components/meshrenderer.hpp"
 #include "Components/terrainrenderer.hpp"
-#include "Core/scene.hpp"
+#include "Rendering/rendersnapshot.hpp"
 
 #include <glad/glad.h>
 
@@ -13,10 +18,11 @@ namespace Rendering
     class RenderingEngine
     {
     public:
-        RenderingEngine(int texWidth, int texHeight);
+        RenderingEngine();
         ~RenderingEngine();
 
-        void renderScene(Core::Scene const &scene, double deltaTime, double rollingFPS);
+        // Must be called on the thread owning the GL context; the snapshot is not needed once this returns
+        void renderScene(RenderSnapshot const &snapshot);
 
         std::unique_ptr<DebugRenderer> mDebugRenderer;
         
@@ -24,17 +30,53 @@ namespace Rendering
         RenderingEngine(RenderingEngine const &) = delete;
         RenderingEngine & operator=(RenderingEngine const &) = delete;
 
+        // Graph resources making up the gBuffer
+        struct GBuffer
+        {
+            RenderGraph::Resource mPosition;
+            RenderGraph::Resource mNormal;
+            RenderGraph::Resource mAlbedoSpec;
+            RenderGraph::Resource mDepth;
+        };
+
+        // Frame passes, declared in execution order
+        GBuffer addGeometryPass(RenderSnapshot const &snapshot);
+        RenderGraph::Resource addLightingPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer);
+        // Diffuse and specular light computed once per downsample x downsample block of the render area
+        void addLowResLightingPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer, int downsample,
+                                   RenderGraph::Resource &diffuse, RenderGraph::Resource &specular);
+        RenderGraph::Resource addOverlayPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer, RenderGraph::Resource sceneColor);
+        // Particle systems marked half resolution, drawn offscreen and composited over the scene
+        RenderGraph::Resource addHalfResParticlePasses(RenderSnapshot const &snapshot, GBuffer const &gBuffer, RenderGraph::Resource sceneColor);
+        // Fog, tonemapping, color grading, FXAA and the upscale to the window in one compute pass
+        RenderGraph::Resource addPostProcessPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer, RenderGraph::Resource sceneColor);
+        void addPresentPass(RenderGraph::Resource image);
+        void addGBufferDebugPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer);
+        void addUIPass(RenderSnapshot const &snapshot);
+
+        void renderGeometry(RenderSnapshot const &snapshot);
+        void renderParticles(RenderSnapshot const &snapshot, bool halfResolution);
+        bool hasActiveParticles(RenderSnapshot const &snapshot, bool halfResolution);
         void clearFramebuffer();
 
-        void calculateCameraUniforms(Core::Scene const &scene);
         void prepareMaterialForRender(std::shared_ptr<Assets::Material> material);
        
         void setCameraUniforms(std::shared_ptr<Assets::Shader> shader);
-        void setModelUniforms(std::shared_ptr<Assets::Shader> shader, Core::Scene const &scene, Core::GameObject &gameObject);
-        void setLightingUniforms(Core::Scene const &scene);
-        void setTerrainUniforms(std::shared_ptr<Assets::Shader> shader, Core::Scene const &scene, std::shared_ptr<Components::TerrainRenderer> terrainRenderer);
+        void setModelUniforms(std::shared_ptr<Assets::Shader> shader, glm::mat4 const &modelMatrix);
+        void setLightingUniforms(RenderSnapshot const &snapshot);
+        // Culls the snapshot's spot lights against the view frustum and uploads the rest for the lighting passes
+        void uploadSpotLights(RenderSnapshot const &snapshot);
+        void setTerrainUniforms(std::shared_ptr<Assets::Shader> shader, std::shared_ptr<Components::TerrainRenderer> terrainRenderer);
 
         void drawQuad();
+        // Fraction of the scene targets covered by the render area, for full-screen passes sampling them
+        glm::vec2 getTexCoordScale(RenderSnapshot const &snapshot);
+
+        // Picks a mesh LOD or the impostor from the object's projected size, with hysteresis
+        void selectLod(Components::MeshRenderer &meshRenderer, std::vector<std::shared_ptr<Assets::Mesh>> const &meshes,
+                       glm::mat4 const &modelMatrix, float framebufferHeight);
+        void bakeImpostor(Assets::Impostor &impostor, std::vector<std::shared_ptr<Assets::Mesh>> const &meshes,
+                          std::shared_ptr<Assets::Material> material);
 
         glm::mat4 mProjectionMtx;
         glm::mat4 mViewMtx;
@@ -43,21 +85,21 @@ namespace Rendering
 
         int mDrawCalls;
 
-        GLuint mGBufferID;
-        GLuint mGDepthID, mGPositionID, mGNormalID, mGAlbedoSpecID;
-
-        GLuint mLBufferID;
-        GLuint mLColorID;
+        RenderGraph mRenderGraph;
 
-        float mTexWidth;
-        float mTexHeight;
+        std::unique_ptr<DynamicResolution> mDynamicResolution;
+        int mRenderWidth;
+        int mRenderHeight;
 
         std::unique_ptr<Assets::Shader> mLightingShader;
-        std::unique_ptr<Assets::Shader> mFXAAShader;
+        std::unique_ptr<Assets::Shader> mPostProcessShader;
         std::unique_ptr<Assets::Shader> mDebugPositionShader;
         std::unique_ptr<Assets::Shader> mDebugNormalShader;
         std::unique_ptr<Assets::Shader> mDebugAlbedoShader;
         std::unique_ptr<Assets::Shader> mDebugSpecShader;
+        std::unique_ptr<Assets::Shader> mImpostorShader;
+        std::unique_ptr<Assets::Shader> mDepthDownsampleShader;
+        std::unique_ptr<Assets::Shader> mParticleCompositeShader;
 
         std::unique_ptr<Assets::Texture> mDefaultAlbedoTexture;
         std::unique_ptr<Assets::Texture> mDefaultNormalTexture;
@@ -65,5 +107,7 @@ namespace Rendering
 
         unsigned int mQuadVAO, mQuadVBO;
         unsigned int mTerrainVAO, mTerrainVBO, mTerrainEBO;
+        unsigned int mImpostorVAO, mImpostorInstanceVBO;
+        unsigned int mSpotLightBuffer, mSpotLightCount;
     };
 }
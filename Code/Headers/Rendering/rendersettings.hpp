@@ -23,11 +23,47 @@ namespace Rendering
     NONE
   };
 
+  // Rate diffuse and specular lighting is computed at; the value is the downsampling factor
+  enum LightingResolution {
+    FULL_RESOLUTION = 1,
+    HALF_RESOLUTION = 2,
+    QUARTER_RESOLUTION = 4
+  };
+
+  // Shader permutation bits; shaders list their features in this order
+  enum TerrainPermutation {
+    TERRAIN_WIREFRAME_OVERLAY = 1 << 0,
+    TERRAIN_WIREFRAME_ONLY = 1 << 1
+  };
+
+  enum PostProcessPermutation {
+    POST_PROCESS_FXAA = 1 << 0,
+    POST_PROCESS_SHOW_EDGES = 1 << 1
+  };
+
+  enum LightingPermutation {
+    LIGHTING_LOW_RESOLUTION = 1 << 0,
+    LIGHTING_UPSAMPLE = 1 << 1
+  };
+
   struct RenderSettings {
     RenderMode mRenderMode;
     TerrainRenderMode mTerrainRenderMode;
     FXAARenderMode mFXAARenderMode;
+    LightingResolution mLightingResolution;
     bool mDrawDebugLines;
+
+    // Post-processing applied to the lit scene
+    float mFogDensity;
+    float mExposure;
+    float mContrast;
+    float mSaturation;
+
+    // Scene passes render at a fraction of the framebuffer size, steered towards the GPU frame time target
+    bool mDynamicResolution;
+    float mMinRenderScale;
+    float mMaxRenderScale;
+    float mTargetGPUFrameTime;
     
     float mFramebufferWidth;
     float mFramebufferHeight;
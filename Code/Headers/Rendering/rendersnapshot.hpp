@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Rendering/rendersettings.hpp"
+#include "Rendering/debugrenderer.hpp"
+#include "Rendering/cubemap.hpp"
+#include "Components/meshrenderer.hpp"
+#include "Components/wheelmeshrenderer.hpp"
+#include "Components/terrainrenderer.hpp"
+#include "Components/particlesystemrenderer.hpp"
+#include "Components/pointlight.hpp"
+#include "Components/spotlight.hpp"
+#include "Core/scene.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace Rendering
+{
+    // Everything the renderer needs from one simulated frame, copied out of the scene so the simulation can
+    // move on while the frame is drawn. Components are only referenced for data that is fixed once the scene
+    // is initialized (meshes, materials, light colors) or that the renderer alone touches (LOD levels, GPU buffers).
+    struct RenderSnapshot
+    {
+        struct MeshInstance
+        {
+            std::shared_ptr<Components::MeshRenderer> mMeshRenderer;
+            glm::mat4 mModelMatrix;
+        };
+
+        struct WheelInstance
+        {
+            std::shared_ptr<Components::WheelMeshRenderer> mWheelMeshRenderer;
+            // Body the wheels take their LOD level from, if any
+            std::shared_ptr<Components::MeshRenderer> mBodyMeshRenderer;
+            std::vector<glm::mat4> mModelMatrices;
+        };
+
+        struct TerrainInstance
+        {
+            std::shared_ptr<Components::TerrainRenderer> mTerrainRenderer;
+            glm::mat4 mModelMatrix;
+        };
+
+        struct PointLightInstance
+        {
+            std::shared_ptr<Components::PointLight> mPointLight;
+            glm::vec3 mPosition;
+        };
+
+        struct SpotLightInstance
+        {
+            std::shared_ptr<Components::SpotLight> mSpotLight;
+            glm::vec3 mPosition;
+            glm::vec3 mDirection;
+        };
+
+        // A particle system that is running, or that expired this frame and needs its buffers reset
+        struct ParticleEmitter
+        {
+            std::shared_ptr<Components::ParticleSystemRenderer> mParticleSystemRenderer;
+            glm::mat4 mModelMatrix;
+            float mTimeActive;
+            bool mReset;
+        };
+
+        // Copies the scene's current state, taking any particle system resets the renderer has not yet seen.
+        // Runs on the simulation thread; debug lines accumulated since the last capture move into the snapshot.
+        void capture(Core::Scene &scene, DebugRenderer &debugRenderer, double deltaTime, double rollingFPS);
+
+        RenderSettings mRenderSettings;
+        double mDeltaTime;
+        double mRollingFPS;
+
+        glm::mat4 mProjectionMtx;
+        glm::mat4 mViewMtx;
+        glm::vec3 mViewPosition;
+        // Point lights nearest to what the camera follows are the ones drawn
+        glm::vec3 mFollowPosition;
+
+        CubeMap const *mCubeMap;
+
+        std::vector<MeshInstance> mMeshes;
+        std::vector<WheelInstance> mWheels;
+        std::vector<TerrainInstance> mTerrains;
+        std::vector<PointLightInstance> mPointLights;
+        std::vector<SpotLightInstance> mSpotLights;
+        std::vector<ParticleEmitter> mParticleEmitters;
+        std::vector<Vertex> mDebugLines;
+    };
+}
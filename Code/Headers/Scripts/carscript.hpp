@@ -19,6 +19,8 @@ namespace Scripts
 
         virtual void onStart(Core::Scene &scene) override;
         virtual void onUpdate(GLFWwindow *window, Core::Scene &scene, float deltaTime) override;
+        virtual void saveState(Core::StateWriter &writer) const override;
+        virtual void loadState(Core::StateReader &reader) override;
 
     private:
         glm::vec3 mInitialPosition;
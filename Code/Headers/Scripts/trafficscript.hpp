@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Components/script.hpp"
+#include "Components/carphysicsbody.hpp"
+#include "Core/trackpath.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace Scripts
+{
+    // Drives cars around a racing line, steering with pure pursuit towards a point ahead on the line and holding a
+    // speed planned from its curvature. Every car is controlled by this one script, so each tick's control update
+    // is a single batch over per-agent arrays rather than a script per car.
+    class TrafficScript : public Components::Script
+    {
+    public:
+        TrafficScript(Core::GameObject &gameObject, std::shared_ptr<Core::TrackPath> racingLine);
+        virtual ~TrafficScript();
+
+        // Drives a car laneOffset to the left of the racing line
+        void addAgent(std::shared_ptr<Components::CarPhysicsBody> carPhysicsBody, float laneOffset);
+
+        virtual void onStart(Core::Scene &scene) override;
+        virtual void onUpdate(GLFWwindow *window, Core::Scene &scene, float deltaTime) override;
+        virtual void saveState(Core::StateWriter &writer) const override;
+        virtual void loadState(Core::StateReader &reader) override;
+
+    private:
+        TrafficScript(TrafficScript const &) = delete;
+        TrafficScript & operator=(TrafficScript const &) = delete;
+
+        float getPlannedSpeed(float distance) const;
+
+        std::shared_ptr<Core::TrackPath> mRacingLine;
+        // Highest speed at evenly spaced distances along the racing line that can still brake for the bends ahead
+        std::vector<float> mSpeedProfile;
+        float mProfileSpacing;
+
+        std::vector<std::shared_ptr<Components::CarPhysicsBody>> mAgents;
+
+        // Agent state, one array per field
+        std::vector<float> mLaneOffsets;
+        std::vector<float> mWheelbases;
+        std::vector<float> mPathDistances;
+        std::vector<float> mPositionX;
+        std::vector<float> mPositionZ;
+        std::vector<float> mLeftX;
+        std::vector<float> mLeftZ;
+        std::vector<float> mSpeeds;
+        std::vector<float> mTargetX;
+        std::vector<float> mTargetZ;
+        std::vector<float> mTargetSpeeds;
+
+        // Controls computed for each agent
+        std::vector<float> mSteerings;
+        std::vector<float> mEngineForces;
+        std::vector<float> mBrakeForces;
+    };
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+namespace Utils
+{
+  // Encoders for the BCn block formats. Blocks are 4x4 texels; inputs are RGBA8.
+  class BlockCompression
+  {
+    public:
+      enum Format { BC1, BC3, BC4, BC5 };
+
+      static unsigned int getBlockSize(Format format);
+      static unsigned int getCompressedSize(Format format, int width, int height);
+
+      // Compress a whole RGBA8 image, padding partial edge blocks by clamping
+      static std::vector<unsigned char> compress(Format format, const unsigned char *rgba, int width, int height);
+
+      static void encodeBC1(const unsigned char *texels, unsigned char *block);
+      static void encodeBC3(const unsigned char *texels, unsigned char *block);
+      static void encodeBC4(const unsigned char *texels, int channel, unsigned char *block);
+      static void encodeBC5(const unsigned char *texels, unsigned char *block);
+  };
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Utils
+{
+  class FileUtils
+  {
+    public:
+      static void createDirectories(std::string const &path);
+      // Writes through a temporary file and renames it, so readers never see a partial file
+      static bool writeAtomically(std::string const &path, std::string const &contents);
+
+      // FNV-1a, chainable through the seed
+      static unsigned long long hash(const void *data, size_t size, unsigned long long seed = 14695981039346656037ULL);
+  };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+  // Read-only view of a file. Memory-mapped where the platform allows it,
+  // otherwise read into memory once.
+  class MappedFile
+  {
+    public:
+      MappedFile(std::string const &path);
+      ~MappedFile();
+
+      bool isValid() const { return mData != nullptr; }
+      const unsigned char *getData() const { return mData; }
+      size_t getSize() const { return mSize; }
+
+    private:
+      MappedFile(MappedFile const &) = delete;
+      MappedFile & operator=(MappedFile const &) = delete;
+
+      const unsigned char *mData;
+      size_t mSize;
+      bool mMapped;
+      std::vector<unsigned char> mBuffer;
+  };
+}
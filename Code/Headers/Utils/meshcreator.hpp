@@ -16,7 +16,7 @@ namespace Utils
         MeshCreator() { }
         ~MeshCreator() { }
 
-        std::shared_ptr<Assets::Mesh> create();
+        std::shared_ptr<Assets::Mesh> create(bool upload = true);
 
         int addOpenCylinder(float tDiff, float height1, float height2, float radius);
         void addRotatedOpenCylinder(float height1, float height2, float radius, float x1, float x2, float angle1, float angle2);
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Assets/mesh.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+  // Index and vertex reordering run when meshes are built or cooked
+  class MeshOptimizer
+  {
+    public:
+      // Runs every stage in order, appends the LOD chain and logs the vertex count and ACMR before and after
+      static void optimize(std::string const &name, std::vector<Assets::Vertex> &vertices, std::vector<unsigned int> &indices,
+                           std::vector<Assets::LodLevel> &lods);
+
+      // Merges bitwise identical vertices
+      static void weldVertices(std::vector<Assets::Vertex> &vertices, std::vector<unsigned int> &indices);
+      // Forsyth's linear-speed triangle ordering for the post-transform cache
+      static void optimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount);
+      // Splits the cache-ordered triangles into clusters at cache restarts and draws outward-facing clusters first
+      static void optimizeOverdraw(std::vector<Assets::Vertex> const &vertices, std::vector<unsigned int> &indices);
+      // Lays vertices out in the order they are first referenced
+      static void optimizeVertexFetch(std::vector<Assets::Vertex> &vertices, std::vector<unsigned int> &indices);
+
+      // Average cache misses per triangle through a FIFO cache
+      static float computeACMR(std::vector<unsigned int> const &indices, unsigned int vertexCount, unsigned int cacheSize = 16);
+  };
+}
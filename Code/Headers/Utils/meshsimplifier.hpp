@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Assets/mesh.hpp"
+
+#include <vector>
+
+namespace Utils
+{
+  // Quadric error edge collapse onto existing vertices, so every level shares the base vertex buffer
+  class MeshSimplifier
+  {
+    public:
+      // Collapses edges until the index count reaches targetIndexCount or the next collapse would exceed maxError.
+      // Errors are relative to the mesh's bounding radius. Attribute seams and open borders are kept in place.
+      static std::vector<unsigned int> simplify(std::vector<Assets::Vertex> const &vertices, std::vector<unsigned int> const &indices,
+                                                unsigned int targetIndexCount, float maxError, float &error);
+
+      // Appends simplified levels after the base indices and describes every level, base first
+      static void buildLodChain(std::vector<Assets::Vertex> const &vertices, std::vector<unsigned int> &indices,
+                                std::vector<Assets::LodLevel> &lods);
+  };
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Assets/mesh.hpp"
+
+#include <vector>
+
+namespace Utils
+{
+  // MikkTSpace-style tangent frames for indexed meshes: angle-weighted averages over shared vertices,
+  // with vertices split where triangles of opposite UV winding meet
+  class TangentGenerator
+  {
+    public:
+      // Fills in Tangent and Bitangent; may append vertices for the handedness splits
+      static void generate(std::vector<Assets::Vertex> &vertices, std::vector<unsigned int> &indices);
+  };
+}
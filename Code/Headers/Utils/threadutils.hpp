@@ -0,0 +1,11 @@
+#pragma once
+
+namespace Utils
+{
+  class ThreadUtils
+  {
+    public:
+      // Restricts the calling thread to one logical CPU. Returns false where pinning is unsupported or fails.
+      static bool setCurrentThreadAffinity(int cpu);
+  };
+}
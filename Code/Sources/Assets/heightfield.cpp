@@ -0,0 +1,89 @@
+#include "Assets/heightfield.hpp"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace Assets
+{
+    HeightField::HeightField(std::string const &path, bool upload)
+        : mWidth(0), mLength(0)
+    {
+        mPath = path;
+        loadHeightField(path);
+        if (upload) {
+            this->upload();
+        }
+    }
+
+    float HeightField::getHeight(float u, float v) const
+    {
+        if (mData.empty()) {
+            return 0.0f;
+        }
+
+        // Map normalized coordinates onto the sample grid
+        float x = std::min(std::max(u, 0.0f), 1.0f) * (mWidth - 1);
+        float z = std::min(std::max(v, 0.0f), 1.0f) * (mLength - 1);
+        int x0 = (int) x;
+        int z0 = (int) z;
+        int x1 = std::min(x0 + 1, mWidth - 1);
+        int z1 = std::min(z0 + 1, mLength - 1);
+        float fx = x - x0;
+        float fz = z - z0;
+
+        const unsigned char *row0 = &mData[z0*mWidth];
+        const unsigned char *row1 = &mData[z1*mWidth];
+        float h0 = row0[x0] + (row0[x1] - row0[x0]) * fx;
+        float h1 = row1[x0] + (row1[x1] - row1[x0]) * fx;
+        return (h0 + (h1 - h0) * fz) * (1.0f / 255.0f);
+    }
+
+    unsigned char HeightField::getTexel(int x, int z) const
+    {
+        x = std::min(std::max(x, 0), mWidth - 1);
+        z = std::min(std::max(z, 0), mLength - 1);
+        return mData[z*mWidth + x];
+    }
+
+    void HeightField::loadHeightField(std::string const &path)
+    {
+        int nrChannels;
+        unsigned char *data = stbi_load(path.c_str(), &mWidth, &mLength, &nrChannels, 1);
+        if (data) {
+            mData.assign(data, data + mWidth*mLength);
+        } else {
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            mWidth = 0;
+            mLength = 0;
+        }
+        stbi_image_free(data);
+    }
+
+    void HeightField::upload()
+    {
+        if (mID != 0) {
+            return;
+        }
+
+        glGenTextures(1, &mID);
+        if (mData.empty()) {
+            return;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, mID);
+        // Rows of a single-channel image are not necessarily 4-byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, mWidth, mLength, 0, GL_RED, GL_UNSIGNED_BYTE, mData.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+}
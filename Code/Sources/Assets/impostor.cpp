@@ -0,0 +1,20 @@
+#include "Assets/impostor.hpp"
+
+#include <glad/glad.h>
+
+namespace Assets
+{
+    Impostor::Impostor(unsigned int frameCount, unsigned int frameSize)
+        : mFrameCount(frameCount), mFrameSize(frameSize), mCenter(0), mRadius(0),
+          mPositionID(0), mNormalID(0), mAlbedoSpecID(0)
+    {
+    }
+
+    Impostor::~Impostor()
+    {
+        if (isBaked()) {
+            GLuint textures[3] = {mPositionID, mNormalID, mAlbedoSpecID};
+            glDeleteTextures(3, textures);
+        }
+    }
+}
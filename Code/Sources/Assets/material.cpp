@@ -11,4 +11,14 @@ namespace Assets
     Material::~Material()
     {
     }
+
+    void Material::upload()
+    {
+        // Upload any maps that were decoded off the context thread
+        for (auto &map : {mAlbedoMap, mSpecularMap, mNormalMap, mHeightMap}) {
+            if (map) {
+                map->upload();
+            }
+        }
+    }
 }
\ No newline at end of file
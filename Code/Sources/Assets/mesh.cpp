@@ -1,21 +1,117 @@
 #include "Assets/mesh.hpp"
+#include "Utils/meshoptimizer.hpp"
+#include "Utils/tangentgenerator.hpp"
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
+// Generic vertex attributes holding the per-mesh dequantization constants
+const unsigned int POSITION_SCALE_ATTRIBUTE = 9;
+const unsigned int POSITION_OFFSET_ATTRIBUTE = 10;
+
+namespace
+{
+    // Signed normalized GL_INT_2_10_10_10_REV
+    unsigned int packSnorm1010102(glm::vec3 const &v, float w)
+    {
+        unsigned int result = 0;
+        for (int c = 0; c < 3; c++) {
+            int value = (int) std::round(std::max(-1.0f, std::min(1.0f, v[c])) * 511.0f);
+            result |= ((unsigned int) value & 0x3FF) << (c*10);
+        }
+        result |= ((unsigned int) (w < 0.0f ? -1 : 1) & 0x3) << 30;
+        return result;
+    }
+
+    // IEEE 754 binary16 with round-to-nearest-even, flushing denormals to zero
+    unsigned short packHalf(float value)
+    {
+        unsigned int bits;
+        memcpy(&bits, &value, sizeof(bits));
+        unsigned int sign = (bits >> 16) & 0x8000;
+        int exponent = (int) ((bits >> 23) & 0xFF) - 127 + 15;
+        unsigned int mantissa = bits & 0x7FFFFF;
+
+        if (((bits >> 23) & 0xFF) == 0xFF) {
+            return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+        }
+        if (exponent <= 0) {
+            return sign;
+        }
+        if (exponent >= 31) {
+            return sign | 0x7C00;
+        }
+
+        unsigned int half = (exponent << 10) | (mantissa >> 13);
+        unsigned int remainder = mantissa & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+            half++;
+        }
+        return sign | half;
+    }
+}
+
 namespace Assets
 {
-    Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
+    Mesh::Mesh()
+        : mVertexFormat(PACKED_VERTICES), mVBO(0), mInstanceVBO(0), mEBO(0), mVAO(0),
+          mMappedVertices(nullptr), mMappedPackedVertices(nullptr), mMappedIndices(nullptr), mMappedVertexCount(0),
+          mMappedIndexCount(0), mPositionScale(1), mPositionOffset(0)
     {
-        mVertices = vertices;
-        mIndices = indices;
+    }
+
+    Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<LodLevel> lods, bool upload)
+        : mVertexFormat(PACKED_VERTICES), mVBO(0), mInstanceVBO(0), mEBO(0), mVAO(0),
+          mMappedVertices(nullptr), mMappedPackedVertices(nullptr), mMappedIndices(nullptr), mMappedVertexCount(0),
+          mMappedIndexCount(0), mPositionScale(1), mPositionOffset(0)
+    {
+        mVertices = std::move(vertices);
+        mIndices = std::move(indices);
+        mLods = std::move(lods);
+        validateLods();
+        computeBounds();
+        packVertices();
 
         // Now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        if (upload) {
+            setupMesh();
+        }
+    }
+
+    Mesh::Mesh(std::shared_ptr<Utils::MappedFile> source, const Vertex *vertices, const PackedVertex *packedVertices,
+               unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount, std::vector<LodLevel> lods,
+               VertexFormat vertexFormat, glm::vec3 boundsMin, glm::vec3 boundsMax,
+               glm::vec3 positionScale, glm::vec3 positionOffset, bool upload)
+        : mVertexFormat(vertexFormat), mVBO(0), mInstanceVBO(0), mEBO(0), mVAO(0),
+          mMappedVertices(nullptr), mMappedPackedVertices(nullptr), mMappedIndices(nullptr), mMappedVertexCount(0),
+          mMappedIndexCount(0), mPositionScale(1), mPositionOffset(0)
+    {
+        mSource = source;
+        mMappedVertices = vertices;
+        mMappedPackedVertices = packedVertices;
+        mMappedVertexCount = vertexCount;
+        mMappedIndices = indices;
+        mMappedIndexCount = indexCount;
+        mLods = std::move(lods);
+        validateLods();
+        mBoundsMin = boundsMin;
+        mBoundsMax = boundsMax;
+        mPositionScale = positionScale;
+        mPositionOffset = positionOffset;
+
+        if (upload) {
+            setupMesh();
+        }
     }
 
-    Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec3> normals, std::vector<glm::vec2> texCoords)
+    Mesh::Mesh(std::vector<glm::vec3> positions, std::vector<glm::vec3> normals, std::vector<glm::vec2> texCoords, bool upload)
+        : mVertexFormat(PACKED_VERTICES), mVBO(0), mInstanceVBO(0), mEBO(0), mVAO(0),
+          mMappedVertices(nullptr), mMappedPackedVertices(nullptr), mMappedIndices(nullptr), mMappedVertexCount(0),
+          mMappedIndexCount(0), mPositionScale(1), mPositionOffset(0)
     {
         // Check for same number of elements
         if (positions.size() != normals.size()) {
@@ -33,86 +129,49 @@ namespace Assets
             normal = glm::normalize(normal);
         }
 
-        // Calculate tangents and bitangents
-        //TODO averaging of shared vertices
-        std::vector<glm::vec3> tangents;
-        std::vector<glm::vec3> bitangents;
-
-        for (int i = 0; i < positions.size(); i += 3) {
-            glm::highp_dvec3 hpPosition1 = positions[i];
-            glm::highp_dvec3 hpPosition2 = positions[i+1];
-            glm::highp_dvec3 hpPosition3 = positions[i+2];
-
-            glm::highp_dvec2 hpUV1 = texCoords[i];
-            glm::highp_dvec2 hpUV2 = texCoords[i+1];
-            glm::highp_dvec2 hpUV3 = texCoords[i+2];
-
-            glm::highp_dvec3 edge1 = hpPosition2 - hpPosition1;
-            glm::highp_dvec3 edge2 = hpPosition3 - hpPosition1;
-            glm::highp_dvec2 deltaUV1 = hpUV2 - hpUV1;
-            glm::highp_dvec2 deltaUV2 = hpUV3 - hpUV1; 
-            
-            double f = 1.0 / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-            glm::vec3 tangent;
-            tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-            tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-            tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-            tangent = glm::normalize(tangent);
-
-            glm::vec3 bitangent;
-            bitangent.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-            bitangent.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-            bitangent.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-            bitangent = glm::normalize(bitangent);  
-
-
-            // Check for invalid values
-            if (tangent[0] != tangent[0] || tangent[1] != tangent[1] || tangent[2] != tangent[2] ||
-                bitangent[0] != bitangent[0] || bitangent[1] != bitangent[1] || bitangent[2] != bitangent[2]) {
-                // Theoretically, this will only be invalid when not using normal maps, no tangent/bitangent doesn't matter
-                tangents.push_back(glm::vec3(1, 0, 0));
-                bitangents.push_back(glm::vec3(0, 1, 0));
-            }
-            // Check for values that were not properly normalized
-            else if (glm::length(tangent) < 0.9 || glm::length(bitangent) < 0.9) {
-                // Theoretically, this will only be zero when not using normal maps, no tangent/bitangent doesn't matter
-                tangents.push_back(glm::vec3(1, 0, 0));
-                bitangents.push_back(glm::vec3(0, 1, 0));
-            }
-            else {
-                tangents.push_back(glm::vec3(1, 0, 0));
-                bitangents.push_back(glm::vec3(0, 1, 0));
-            }
-        }
-
-        // Create vertices
+        // Create vertices, welded so that tangents are averaged across the triangles sharing them
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
         for (unsigned int i = 0; i < positions.size(); i++) {
-            vertices.push_back(Vertex{positions[i], normals[i], texCoords[i], tangents[i/3], bitangents[i/3]});
+            vertices.push_back(Vertex{positions[i], normals[i], texCoords[i], glm::vec3(0), glm::vec3(0)});
             indices.push_back(i);
         }
-        mVertices = vertices;
-        mIndices = indices;
+        Utils::MeshOptimizer::weldVertices(vertices, indices);
+
+        // Calculate tangents and bitangents
+        Utils::TangentGenerator::generate(vertices, indices);
+
+        // Weld the triangle soup, reorder it for the vertex cache and build its LOD chain
+        Utils::MeshOptimizer::optimize("(generated)", vertices, indices, mLods);
+        mVertices = std::move(vertices);
+        mIndices = std::move(indices);
+        validateLods();
+        computeBounds();
+        packVertices();
 
         // Now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        if (upload) {
+            setupMesh();
+        }
     }
 
     Mesh::~Mesh()
     {
     }
 
-    void Mesh::draw()
+    void Mesh::draw(unsigned int lod)
     {
+        LodLevel const &level = getLod(lod);
+        setVertexConstants();
         glBindVertexArray(mVAO);
-        glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, level.mIndexCount, GL_UNSIGNED_INT, (void*)(level.mIndexOffset*sizeof(unsigned int)));
         glBindVertexArray(0);
     }
 
-    void Mesh::drawInstanced(std::vector<glm::mat4> modelMatrices)
+    void Mesh::drawInstanced(std::vector<glm::mat4> modelMatrices, unsigned int lod)
     {
+        LodLevel const &level = getLod(lod);
+        setVertexConstants();
         glBindVertexArray(mVAO);
         glBindBuffer(GL_ARRAY_BUFFER, mInstanceVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4)*modelMatrices.size(), &modelMatrices[0], GL_STATIC_DRAW);
@@ -128,24 +187,44 @@ namespace Assets
         glEnableVertexAttribArray(8);
         glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3*sizeof(glm::vec4)));
         glVertexAttribDivisor(8, 1);
-        glDrawElementsInstanced(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0, modelMatrices.size());
+        glDrawElementsInstanced(GL_TRIANGLES, level.mIndexCount, GL_UNSIGNED_INT,
+                                (void*)(level.mIndexOffset*sizeof(unsigned int)), modelMatrices.size());
         glBindVertexArray(0);
     }
 
     void Mesh::setupMesh()
     {
-        // Create buffers/arrays
-        glGenVertexArrays(1, &mVAO);
+        // Vertex and index storage is immutable, so buffers are recreated if the mesh is uploaded again
+        if (mVAO == 0) {
+            glGenVertexArrays(1, &mVAO);
+            glGenBuffers(1, &mInstanceVBO);
+        }
+        else {
+            glDeleteBuffers(1, &mVBO);
+            glDeleteBuffers(1, &mEBO);
+        }
         glGenBuffers(1, &mVBO);
-        glGenBuffers(1, &mInstanceVBO);
         glGenBuffers(1, &mEBO);
 
         // Bind VAO/VBO/EBO and set buffer data
         glBindVertexArray(mVAO);
         glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-        glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), &mVertices[0], GL_STATIC_DRAW);
+        if (mVertexFormat == PACKED_VERTICES) {
+            uploadPackedVertices();
+        }
+        else {
+            uploadFloatVertices();
+        }
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(unsigned int), &mIndices[0], GL_STATIC_DRAW);
+        glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, getIndexCount() * sizeof(unsigned int), getIndexData(), 0);
+
+        glBindVertexArray(0);
+    }
+
+    void Mesh::uploadFloatVertices()
+    {
+        // Straight from the mapped file for cooked meshes
+        glBufferStorage(GL_ARRAY_BUFFER, getVertexCount() * sizeof(Vertex), getVertexData(), 0);
 
         // Setup VAO
         // Vertex Positions
@@ -163,12 +242,57 @@ namespace Assets
         // Vertex bitangent
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+    }
 
-        glBindVertexArray(0);
+    void Mesh::uploadPackedVertices()
+    {
+        // Straight from the mapped file for cooked meshes, like float vertices
+        glBufferStorage(GL_ARRAY_BUFFER, getVertexCount() * sizeof(PackedVertex), getPackedVertexData(), 0);
+
+        // Setup VAO
+        // Vertex Positions
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Position));
+        // Vertex normals
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+        // Vertex texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+        // Vertex tangent and handedness
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Tangent));
+        // Vertex bitangent is reconstructed
+        glDisableVertexAttribArray(4);
+    }
+
+    void Mesh::setVertexConstants()
+    {
+        // Current generic attribute values are context state, so they are set per draw
+        if (mVertexFormat == PACKED_VERTICES) {
+            glVertexAttrib4f(POSITION_SCALE_ATTRIBUTE, mPositionScale.x, mPositionScale.y, mPositionScale.z, 1.0f);
+            glVertexAttrib3f(POSITION_OFFSET_ATTRIBUTE, mPositionOffset.x, mPositionOffset.y, mPositionOffset.z);
+        }
+        else {
+            glVertexAttrib4f(POSITION_SCALE_ATTRIBUTE, 1.0f, 1.0f, 1.0f, 0.0f);
+            glVertexAttrib3f(POSITION_OFFSET_ATTRIBUTE, 0.0f, 0.0f, 0.0f);
+        }
+    }
+
+    void Mesh::setVertexFormat(VertexFormat vertexFormat)
+    {
+        mVertexFormat = vertexFormat;
+
+        // Meshes that have not been uploaded yet pick up the change on upload
+        if (mVAO != 0) {
+            setupMesh();
+        }
     }
 
     void Mesh::center()
     {
+        copyMappedData();
+
         glm::vec3 totals(0);
         for (auto &vertex : mVertices) {
             totals += vertex.Position;
@@ -178,7 +302,143 @@ namespace Assets
         for (auto &vertex : mVertices) {
             vertex.Position -= center;
         }
+        mBoundsMin -= center;
+        mBoundsMax -= center;
+        // Positions keep their place within the bounds, so packed vertices only need the offset moved
+        mPositionOffset -= center;
+
+        // Meshes that have not been uploaded yet pick up the change on upload
+        if (mVAO != 0) {
+            setupMesh();
+        }
+    }
+
+    void Mesh::computeBounds()
+    {
+        const Vertex *vertices = getVertexData();
+        unsigned int vertexCount = getVertexCount();
+        if (vertexCount == 0) {
+            mBoundsMin = mBoundsMax = glm::vec3(0);
+            return;
+        }
+
+        mBoundsMin = mBoundsMax = vertices[0].Position;
+        for (unsigned int i = 1; i < vertexCount; i++) {
+            mBoundsMin = glm::min(mBoundsMin, vertices[i].Position);
+            mBoundsMax = glm::max(mBoundsMax, vertices[i].Position);
+        }
+
+        // Packed positions are normalized to the bounds, guarding flat axes
+        glm::vec3 extent = mBoundsMax - mBoundsMin;
+        for (int c = 0; c < 3; c++) {
+            if (extent[c] <= 0.0f) {
+                extent[c] = 1.0f;
+            }
+        }
+        mPositionScale = extent;
+        mPositionOffset = mBoundsMin;
+    }
+
+    void Mesh::packVertices()
+    {
+        // Done once when a mesh is built; cooked meshes map the result
+        const Vertex *vertices = getVertexData();
+        mPackedVertices.resize(getVertexCount());
+        for (unsigned int i = 0; i < mPackedVertices.size(); i++) {
+            auto &vertex = vertices[i];
+            auto &packedVertex = mPackedVertices[i];
+
+            glm::vec3 position = glm::clamp((vertex.Position - mPositionOffset) / mPositionScale, glm::vec3(0), glm::vec3(1));
+            for (int c = 0; c < 3; c++) {
+                packedVertex.Position[c] = (unsigned short) std::round(position[c] * 65535.0f);
+            }
+            packedVertex.Position[3] = 0;
+
+            // The shader rebuilds the bitangent as cross(N, T) * handedness
+            float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+            packedVertex.Normal = packSnorm1010102(vertex.Normal, 1.0f);
+            packedVertex.Tangent = packSnorm1010102(vertex.Tangent, handedness);
+
+            packedVertex.TexCoords[0] = packHalf(vertex.TexCoords.x);
+            packedVertex.TexCoords[1] = packHalf(vertex.TexCoords.y);
+        }
+    }
+
+    const Vertex *Mesh::getVertexData() const
+    {
+        return mSource ? mMappedVertices : mVertices.data();
+    }
+
+    const PackedVertex *Mesh::getPackedVertexData() const
+    {
+        return mSource ? mMappedPackedVertices : mPackedVertices.data();
+    }
+
+    unsigned int Mesh::getVertexCount() const
+    {
+        return mSource ? mMappedVertexCount : mVertices.size();
+    }
+
+    const unsigned int *Mesh::getIndexData() const
+    {
+        return mSource ? mMappedIndices : mIndices.data();
+    }
+
+    unsigned int Mesh::getIndexCount() const
+    {
+        return mSource ? mMappedIndexCount : mIndices.size();
+    }
+
+    unsigned int Mesh::getLodCount() const
+    {
+        return mLods.size();
+    }
+
+    LodLevel const &Mesh::getLod(unsigned int lod) const
+    {
+        // Meshes that failed to build have no levels and draw nothing
+        static const LodLevel EMPTY_LEVEL = {0, 0, 0.0f};
+        if (mLods.empty()) {
+            return EMPTY_LEVEL;
+        }
+        return mLods[std::min<unsigned int>(lod, mLods.size() - 1)];
+    }
+
+    float Mesh::getBoundingRadius() const
+    {
+        return glm::length(mBoundsMax - mBoundsMin) * 0.5f;
+    }
 
-        setupMesh();
+    void Mesh::validateLods()
+    {
+        // Fall back to a single level covering the whole index buffer
+        unsigned int indexCount = getIndexCount();
+        for (auto &lod : mLods) {
+            if (lod.mIndexOffset + lod.mIndexCount > indexCount) {
+                std::cout << "Invalid LOD range, ignoring LOD levels." << std::endl;
+                mLods.clear();
+                break;
+            }
+        }
+        if (mLods.empty()) {
+            mLods.push_back({0, indexCount, 0.0f});
+        }
+    }
+
+    void Mesh::copyMappedData()
+    {
+        // Mapped data is read-only, so take a private copy before modifying it
+        if (!mSource) {
+            return;
+        }
+        mVertices.assign(mMappedVertices, mMappedVertices + mMappedVertexCount);
+        mPackedVertices.assign(mMappedPackedVertices, mMappedPackedVertices + mMappedVertexCount);
+        mIndices.assign(mMappedIndices, mMappedIndices + mMappedIndexCount);
+        mSource.reset();
+        mMappedVertices = nullptr;
+        mMappedPackedVertices = nullptr;
+        mMappedIndices = nullptr;
+        mMappedVertexCount = 0;
+        mMappedIndexCount = 0;
     }
 }
\ No newline at end of file
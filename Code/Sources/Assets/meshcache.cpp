@@ -0,0 +1,262 @@
+#include "Assets/meshcache.hpp"
+#include "Utils/fileutils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+const unsigned int CACHE_VERSION = 5;
+const char CACHE_MAGIC[4] = {'D', 'S', 'M', 'C'};
+const unsigned int DATA_ALIGNMENT = 16;
+const unsigned int MAX_LOD_LEVELS = 8;
+
+namespace
+{
+    struct CacheHeader
+    {
+        char mMagic[4];
+        unsigned int mVersion;
+        unsigned long long mSourceHash;
+        unsigned int mVertexStride;
+        unsigned int mPackedVertexStride;
+        unsigned int mMeshCount;
+        unsigned int mTextureCount;
+        unsigned int mStringsSize;
+    };
+
+    struct CacheMesh
+    {
+        unsigned long long mVertexOffset;
+        unsigned long long mPackedVertexOffset;
+        unsigned long long mIndexOffset;
+        unsigned int mVertexCount;
+        unsigned int mIndexCount;
+        float mBoundsMin[3];
+        float mBoundsMax[3];
+        unsigned int mVertexFormat;
+        float mPositionScale[3];
+        float mPositionOffset[3];
+        unsigned int mLodCount;
+        unsigned int mLodIndexOffsets[MAX_LOD_LEVELS];
+        unsigned int mLodIndexCounts[MAX_LOD_LEVELS];
+        float mLodErrors[MAX_LOD_LEVELS];
+    };
+
+    struct CacheTexture
+    {
+        unsigned int mTypeOffset;
+        unsigned int mTypeLength;
+        unsigned int mPathOffset;
+        unsigned int mPathLength;
+    };
+
+    // Pads so that the next blob starts aligned within the file
+    void alignContents(std::string &blobs, size_t dataStart)
+    {
+        size_t end = dataStart + blobs.size();
+        blobs.resize(blobs.size() + (DATA_ALIGNMENT - end % DATA_ALIGNMENT) % DATA_ALIGNMENT, '\0');
+    }
+}
+
+namespace Assets
+{
+    std::string MeshCache::mCacheDirectory;
+
+    void MeshCache::initialize(std::string const &cacheDirectory)
+    {
+        mCacheDirectory = cacheDirectory;
+        Utils::FileUtils::createDirectories(mCacheDirectory);
+    }
+
+    bool MeshCache::load(std::string const &path, unsigned int importFlags, CookedModel &model)
+    {
+        model.mSourceHash = 0;
+        if (mCacheDirectory.empty()) {
+            return false;
+        }
+
+        // Key on source contents, import options and vertex layout
+        {
+            Utils::MappedFile source(path);
+            if (!source.isValid()) {
+                return false;
+            }
+            unsigned int options[3] = {importFlags, (unsigned int) sizeof(Vertex), CACHE_VERSION};
+            model.mSourceHash = Utils::FileUtils::hash(source.getData(), source.getSize());
+            model.mSourceHash = Utils::FileUtils::hash(options, sizeof(options), model.mSourceHash);
+        }
+
+        return load(model.mSourceHash, model);
+    }
+
+    bool MeshCache::load(unsigned long long sourceHash, CookedModel &model)
+    {
+        model.mSourceHash = sourceHash;
+        if (mCacheDirectory.empty()) {
+            return false;
+        }
+
+        auto file = std::make_shared<Utils::MappedFile>(getCachePath(model.mSourceHash));
+        if (!file->isValid() || file->getSize() < sizeof(CacheHeader)) {
+            return false;
+        }
+
+        CacheHeader header;
+        memcpy(&header, file->getData(), sizeof(CacheHeader));
+        if (memcmp(header.mMagic, CACHE_MAGIC, 4) != 0 || header.mVersion != CACHE_VERSION ||
+            header.mSourceHash != model.mSourceHash || header.mVertexStride != sizeof(Vertex) ||
+            header.mPackedVertexStride != sizeof(PackedVertex)) {
+            return false;
+        }
+
+        size_t meshTable = sizeof(CacheHeader);
+        size_t textureTable = meshTable + header.mMeshCount*sizeof(CacheMesh);
+        size_t strings = textureTable + header.mTextureCount*sizeof(CacheTexture);
+        if (file->getSize() < strings + header.mStringsSize) {
+            return false;
+        }
+
+        const unsigned char *data = file->getData();
+        model.mMeshes.clear();
+        for (unsigned int i = 0; i < header.mMeshCount; i++) {
+            CacheMesh cacheMesh;
+            memcpy(&cacheMesh, data + meshTable + i*sizeof(CacheMesh), sizeof(CacheMesh));
+            if (cacheMesh.mVertexOffset + cacheMesh.mVertexCount*sizeof(Vertex) > file->getSize() ||
+                cacheMesh.mPackedVertexOffset + cacheMesh.mVertexCount*sizeof(PackedVertex) > file->getSize() ||
+                cacheMesh.mIndexOffset + cacheMesh.mIndexCount*sizeof(unsigned int) > file->getSize()) {
+                std::cout << "Corrupt mesh cache file: " << getCachePath(sourceHash) << std::endl;
+                model.mMeshes.clear();
+                return false;
+            }
+
+            // Blobs are stored aligned and in GPU layout, so they are used in place
+            CookedModel::CookedMesh mesh;
+            mesh.mVertices = reinterpret_cast<const Vertex *>(data + cacheMesh.mVertexOffset);
+            mesh.mPackedVertices = reinterpret_cast<const PackedVertex *>(data + cacheMesh.mPackedVertexOffset);
+            mesh.mVertexCount = cacheMesh.mVertexCount;
+            mesh.mIndices = reinterpret_cast<const unsigned int *>(data + cacheMesh.mIndexOffset);
+            mesh.mIndexCount = cacheMesh.mIndexCount;
+            mesh.mBoundsMin = glm::vec3(cacheMesh.mBoundsMin[0], cacheMesh.mBoundsMin[1], cacheMesh.mBoundsMin[2]);
+            mesh.mBoundsMax = glm::vec3(cacheMesh.mBoundsMax[0], cacheMesh.mBoundsMax[1], cacheMesh.mBoundsMax[2]);
+            mesh.mVertexFormat = cacheMesh.mVertexFormat == FLOAT_VERTICES ? FLOAT_VERTICES : PACKED_VERTICES;
+            mesh.mPositionScale = glm::vec3(cacheMesh.mPositionScale[0], cacheMesh.mPositionScale[1], cacheMesh.mPositionScale[2]);
+            mesh.mPositionOffset = glm::vec3(cacheMesh.mPositionOffset[0], cacheMesh.mPositionOffset[1], cacheMesh.mPositionOffset[2]);
+            for (unsigned int lod = 0; lod < std::min(cacheMesh.mLodCount, MAX_LOD_LEVELS); lod++) {
+                mesh.mLods.push_back({cacheMesh.mLodIndexOffsets[lod], cacheMesh.mLodIndexCounts[lod], cacheMesh.mLodErrors[lod]});
+            }
+            model.mMeshes.push_back(mesh);
+        }
+
+        model.mTextures.clear();
+        const char *stringData = reinterpret_cast<const char *>(data + strings);
+        for (unsigned int i = 0; i < header.mTextureCount; i++) {
+            CacheTexture cacheTexture;
+            memcpy(&cacheTexture, data + textureTable + i*sizeof(CacheTexture), sizeof(CacheTexture));
+            if (cacheTexture.mTypeOffset + cacheTexture.mTypeLength > header.mStringsSize ||
+                cacheTexture.mPathOffset + cacheTexture.mPathLength > header.mStringsSize) {
+                std::cout << "Corrupt mesh cache file: " << getCachePath(sourceHash) << std::endl;
+                model.mMeshes.clear();
+                model.mTextures.clear();
+                return false;
+            }
+            model.mTextures.push_back({
+                std::string(stringData + cacheTexture.mTypeOffset, cacheTexture.mTypeLength),
+                std::string(stringData + cacheTexture.mPathOffset, cacheTexture.mPathLength)
+            });
+        }
+
+        model.mFile = file;
+        return true;
+    }
+
+    void MeshCache::save(CookedModel const &model)
+    {
+        if (mCacheDirectory.empty() || model.mSourceHash == 0) {
+            return;
+        }
+
+        CacheHeader header;
+        memcpy(header.mMagic, CACHE_MAGIC, 4);
+        header.mVersion = CACHE_VERSION;
+        header.mSourceHash = model.mSourceHash;
+        header.mVertexStride = sizeof(Vertex);
+        header.mPackedVertexStride = sizeof(PackedVertex);
+        header.mMeshCount = model.mMeshes.size();
+        header.mTextureCount = model.mTextures.size();
+
+        // String table
+        std::string strings;
+        std::vector<CacheTexture> cacheTextures;
+        for (auto &texture : model.mTextures) {
+            CacheTexture cacheTexture;
+            cacheTexture.mTypeOffset = strings.size();
+            cacheTexture.mTypeLength = texture.mType.size();
+            strings += texture.mType;
+            cacheTexture.mPathOffset = strings.size();
+            cacheTexture.mPathLength = texture.mPath.size();
+            strings += texture.mPath;
+            cacheTextures.push_back(cacheTexture);
+        }
+        header.mStringsSize = strings.size();
+
+        // Lay out the data blobs after the tables
+        size_t dataStart = sizeof(CacheHeader) + model.mMeshes.size()*sizeof(CacheMesh) +
+                           cacheTextures.size()*sizeof(CacheTexture) + strings.size();
+        std::string blobs;
+        alignContents(blobs, dataStart);
+
+        std::vector<CacheMesh> cacheMeshes;
+        for (auto &mesh : model.mMeshes) {
+            CacheMesh cacheMesh;
+            cacheMesh.mVertexOffset = dataStart + blobs.size();
+            cacheMesh.mVertexCount = mesh.mVertexCount;
+            blobs.append(reinterpret_cast<const char *>(mesh.mVertices), mesh.mVertexCount*sizeof(Vertex));
+            alignContents(blobs, dataStart);
+            cacheMesh.mPackedVertexOffset = dataStart + blobs.size();
+            blobs.append(reinterpret_cast<const char *>(mesh.mPackedVertices), mesh.mVertexCount*sizeof(PackedVertex));
+            alignContents(blobs, dataStart);
+            cacheMesh.mIndexOffset = dataStart + blobs.size();
+            cacheMesh.mIndexCount = mesh.mIndexCount;
+            blobs.append(reinterpret_cast<const char *>(mesh.mIndices), mesh.mIndexCount*sizeof(unsigned int));
+            alignContents(blobs, dataStart);
+            for (int c = 0; c < 3; c++) {
+                cacheMesh.mBoundsMin[c] = mesh.mBoundsMin[c];
+                cacheMesh.mBoundsMax[c] = mesh.mBoundsMax[c];
+                cacheMesh.mPositionScale[c] = mesh.mPositionScale[c];
+                cacheMesh.mPositionOffset[c] = mesh.mPositionOffset[c];
+            }
+            cacheMesh.mVertexFormat = mesh.mVertexFormat;
+            cacheMesh.mLodCount = std::min<unsigned int>(mesh.mLods.size(), MAX_LOD_LEVELS);
+            for (unsigned int lod = 0; lod < MAX_LOD_LEVELS; lod++) {
+                bool used = lod < cacheMesh.mLodCount;
+                cacheMesh.mLodIndexOffsets[lod] = used ? mesh.mLods[lod].mIndexOffset : 0;
+                cacheMesh.mLodIndexCounts[lod] = used ? mesh.mLods[lod].mIndexCount : 0;
+                cacheMesh.mLodErrors[lod] = used ? mesh.mLods[lod].mError : 0.0f;
+            }
+            cacheMeshes.push_back(cacheMesh);
+        }
+
+        std::string contents(reinterpret_cast<const char *>(&header), sizeof(header));
+        if (!cacheMeshes.empty()) {
+            contents.append(reinterpret_cast<const char *>(&cacheMeshes[0]), cacheMeshes.size()*sizeof(CacheMesh));
+        }
+        if (!cacheTextures.empty()) {
+            contents.append(reinterpret_cast<const char *>(&cacheTextures[0]), cacheTextures.size()*sizeof(CacheTexture));
+        }
+        contents += strings;
+        contents += blobs;
+
+        std::string cachePath = getCachePath(model.mSourceHash);
+        if (!Utils::FileUtils::writeAtomically(cachePath, contents)) {
+            std::cout << "Unable to write mesh cache file: " << cachePath << std::endl;
+        }
+    }
+
+    std::string MeshCache::getCachePath(unsigned long long sourceHash)
+    {
+        std::stringstream cachePath;
+        cachePath << mCacheDirectory << "/" << std::hex << sourceHash << ".dsm";
+        return cachePath.str();
+    }
+}
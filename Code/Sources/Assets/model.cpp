@@ -1,10 +1,17 @@
 #include "Assets/model.hpp"
 
+#include "Core/threadpool.hpp"
+#include "Utils/meshoptimizer.hpp"
+#include "Utils/tangentgenerator.hpp"
+
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
 #include <iostream>
 
+// Tangent frames come from Utils::TangentGenerator rather than aiProcess_CalcTangentSpace
+const unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
+
 const char pathSeparator =
 #ifdef _WIN32
     '\\';
@@ -14,16 +21,57 @@ const char pathSeparator =
 
 namespace Assets
 {
-    Model::Model(std::string const &path)
+    Model::Model(std::string const &path, bool upload)
     {
         loadModel(path);
+        if (upload) {
+            this->upload();
+        }
+    }
+
+    void Model::upload()
+    {
+        for (auto &mesh : mMeshes) {
+            mesh->setupMesh();
+        }
+        for (auto &texture : mAlbedoTextures) {
+            texture->upload();
+        }
+        for (auto &texture : mSpecularTextures) {
+            texture->upload();
+        }
+        for (auto &texture : mNormalTextures) {
+            texture->upload();
+        }
+        for (auto &texture : mHeightMapTextures) {
+            texture->upload();
+        }
     }
 
     void Model::loadModel(std::string const &path)
     {
+        // Retrieve the directory path of the filepath
+        mDirectory = path.substr(0, path.find_last_of('/'));
+
+        // Use the cooked copy if there is one: no import and no per-vertex work
+        CookedModel cookedModel;
+        if (MeshCache::load(path, IMPORT_FLAGS, cookedModel)) {
+            for (auto &cookedMesh : cookedModel.mMeshes) {
+                mMeshes.push_back(std::make_shared<Mesh>(
+                    cookedModel.mFile,
+                    cookedMesh.mVertices, cookedMesh.mPackedVertices, cookedMesh.mVertexCount,
+                    cookedMesh.mIndices, cookedMesh.mIndexCount,
+                    cookedMesh.mLods, cookedMesh.mVertexFormat, cookedMesh.mBoundsMin, cookedMesh.mBoundsMax,
+                    cookedMesh.mPositionScale, cookedMesh.mPositionOffset, false
+                ));
+            }
+            loadTextures(cookedModel.mTextures);
+            return;
+        }
+
         // Read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, IMPORT_FLAGS);
         
         // Check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
@@ -31,128 +79,136 @@ namespace Assets
             std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
             return;
         }
-        
-        // Retrieve the directory path of the filepath
-        mDirectory = path.substr(0, path.find_last_of('/'));
 
-        // Process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        // Gather ASSIMP's meshes in node order, then convert them in parallel
+        std::vector<aiMesh *> meshes;
+        processNode(scene->mRootNode, scene, meshes);
+        mMeshes.resize(meshes.size());
+        Core::ThreadPool::getInstance().parallelFor(meshes.size(), [this, &meshes](int i) {
+            mMeshes[i] = processMesh(meshes[i]);
+        });
+
+        // Process materials
+        // We assume a convention for sampler names in the shaders. Each diffuse texture should be named
+        // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER.
+        // Same applies to other texture as the following list summarizes:
+        // diffuse: texture_diffuseN
+        // specular: texture_specularN
+        // normal: texture_normalN
+        std::vector<CookedModel::TextureBinding> textures;
+        for (auto mesh : meshes) {
+            aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+            loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", textures);
+            loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", textures);
+            loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", textures);
+            loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height", textures);
+        }
+        loadTextures(textures);
+
+        // Cook the result so later launches skip the import
+        for (auto &mesh : mMeshes) {
+            cookedModel.mMeshes.push_back({
+                mesh->getVertexData(), mesh->getPackedVertexData(), mesh->getVertexCount(),
+                mesh->getIndexData(), mesh->getIndexCount(),
+                mesh->mBoundsMin, mesh->mBoundsMax,
+                mesh->mLods, mesh->mVertexFormat,
+                mesh->getPositionScale(), mesh->getPositionOffset()
+            });
+        }
+        cookedModel.mTextures = textures;
+        MeshCache::save(cookedModel);
     }
 
-    void Model::processNode(aiNode *node, const aiScene *scene)
+    void Model::processNode(aiNode *node, const aiScene *scene, std::vector<aiMesh *> &meshes)
     {
         // Process each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++) {
             // The node object only contains indices to index the actual objects in the scene.
             // The scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            processMesh(mesh, scene);
+            meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
         // After we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++) {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, meshes);
         }
     }
 
-    void Model::processMesh(aiMesh *mesh, const aiScene *scene)
+    std::shared_ptr<Mesh> Model::processMesh(aiMesh *mesh)
     {
-        // Data to fill
-        std::vector<Vertex> vertices;
+        // Data to fill, sized up front
+        std::vector<Vertex> vertices(mesh->mNumVertices);
         std::vector<unsigned int> indices;
-        std::vector<Texture> textures;
+        indices.reserve(mesh->mNumFaces*3);
 
         // Walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++) {
-            Vertex vertex;
-            glm::vec3 vector;
+            Vertex &vertex = vertices[i];
             // Positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
             // Normals
-            vector.x = mesh->mNormals[i].x;
-            vector.y = mesh->mNormals[i].y;
-            vector.z = mesh->mNormals[i].z;
-            vertex.Normal = vector;
+            vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
             // Texture coordinates
+            // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
+            // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
             if(mesh->mTextureCoords[0])
-            {
-                glm::vec2 vec;
-                // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
-                // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
-            }
+                vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
             else
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-            // Tangent
-            vector.x = mesh->mTangents[i].x;
-            vector.y = mesh->mTangents[i].y;
-            vector.z = mesh->mTangents[i].z;
-            vertex.Tangent = vector;
-            // Bitangent
-            vector.x = mesh->mBitangents[i].x;
-            vector.y = mesh->mBitangents[i].y;
-            vector.z = mesh->mBitangents[i].z;
-            vertex.Bitangent = vector;
-            vertices.push_back(vertex);
-        }
-
-        // Now wak through each of the mesh's faces and retrieve the corresponding vertex indices.
+        }
+
+        // Now walk through each of the mesh's faces and retrieve the corresponding vertex indices.
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace &face = mesh->mFaces[i];
             // Retrieve all indices of the face and store them in the indices vector
-            for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+            indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
         }
 
-        // Process materials
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        // We assume a convention for sampler names in the shaders. Each diffuse texture should be named
-        // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER.
-        // Same applies to other texture as the following list summarizes:
-        // diffuse: texture_diffuseN
-        // specular: texture_specularN
-        // normal: texture_normalN
-
-        // Load textures
-        loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
+        // Tangent frames, then optimized and simplified once here, and cooked
+        Utils::TangentGenerator::generate(vertices, indices);
+        std::vector<LodLevel> lods;
+        Utils::MeshOptimizer::optimize(mesh->mName.C_Str(), vertices, indices, lods);
 
         // return a mesh object created from the extracted mesh data
-        mMeshes.push_back(std::make_shared<Mesh>(vertices, indices));
+        return std::make_shared<Mesh>(std::move(vertices), std::move(indices), std::move(lods), false);
     }
 
-    void Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
+    void Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName, std::vector<CookedModel::TextureBinding> &textures)
     {
         for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
             aiString str;
             mat->GetTexture(type, i, &str);
             // Check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
             if (mTexturesLoaded.find(str.C_Str()) == mTexturesLoaded.end()) {
-                // If the texture hasn't been loaded already, load it
-                std::string path = mDirectory + pathSeparator + str.C_Str();
-                std::shared_ptr<Texture> texture = std::make_shared<Texture>(path);
-                
-                if (typeName == "texture_diffuse") {
-                    mAlbedoTextures.push_back(texture);
-                }
-                else if (typeName == "texture_specular") {
-                    mSpecularTextures.push_back(texture);
-                }
-                else if (typeName == "texture_normal") {
-                    mNormalTextures.push_back(texture);
-                }
-                else if (typeName == "texture_heightmap") {
-                    mHeightMapTextures.push_back(texture);
-                }
+                textures.push_back({typeName, str.C_Str()});
                 mTexturesLoaded.insert(str.C_Str());
             }
         }
     }
+
+    void Model::loadTextures(std::vector<CookedModel::TextureBinding> const &textures)
+    {
+        // Decode in parallel, then sort into the per-type lists in binding order
+        std::vector<std::shared_ptr<Texture>> loaded(textures.size());
+        Core::ThreadPool::getInstance().parallelFor(textures.size(), [this, &textures, &loaded](int i) {
+            std::string path = mDirectory + pathSeparator + textures[i].mPath;
+            loaded[i] = std::make_shared<Texture>(path, false, false);
+        });
+
+        for (unsigned int i = 0; i < textures.size(); i++) {
+            std::string const &typeName = textures[i].mType;
+            if (typeName == "texture_diffuse") {
+                mAlbedoTextures.push_back(loaded[i]);
+            }
+            else if (typeName == "texture_specular") {
+                mSpecularTextures.push_back(loaded[i]);
+            }
+            else if (typeName == "texture_normal") {
+                mNormalTextures.push_back(loaded[i]);
+            }
+            else if (typeName == "texture_heightmap") {
+                mHeightMapTextures.push_back(loaded[i]);
+            }
+        }
+    }
 }
\ No newline at end of file
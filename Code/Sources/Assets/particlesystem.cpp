@@ -8,6 +8,7 @@
 namespace Assets
 {
     ParticleSystem::ParticleSystem()
+        : mHalfResolution(false)
     {
     }
 
@@ -1,95 +1,158 @@
 #include "Assets/shader.hpp"
+#include "Assets/shadercache.hpp"
+#include "Assets/shaderpreprocessor.hpp"
+#include "Utils/fileutils.hpp"
 
-#include <fstream>
-#include <sstream>
 #include <iostream>
 
 namespace Assets
 {
-    Shader::Shader(std::string computePath)
+    Shader::Shader(std::string computePath, ShaderOptions const &options)
+        : mStages({{GL_COMPUTE_SHADER, computePath, "COMPUTE"}}), mOptions(options), mPermutation(~0u), mID(0)
     {
-        // Create shader
-        mID = glCreateProgram();
-        attachShader(GL_COMPUTE_SHADER, computePath, "COMPUTE");
-        glLinkProgram(mID);
-        checkCompileErrors(mID, "PROGRAM");
+        setPermutation(0);
     }
 
-    Shader::Shader(std::string vertexPath, std::string fragmentPath)
+    Shader::Shader(std::string vertexPath, std::string fragmentPath, ShaderOptions const &options)
+        : mStages({
+              {GL_VERTEX_SHADER, vertexPath, "VERTEX"},
+              {GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT"}
+          }),
+          mOptions(options), mPermutation(~0u), mID(0)
     {
-        // Create shader
-        mID = glCreateProgram();
-        attachShader(GL_VERTEX_SHADER, vertexPath, "VERTEX");
-        attachShader(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
-        glLinkProgram(mID);
-        checkCompileErrors(mID, "PROGRAM");
+        setPermutation(0);
     }
 
-    Shader::Shader(std::string vertexPath, std::string geometryPath, std::string fragmentPath)
+    Shader::Shader(std::string vertexPath, std::string geometryPath, std::string fragmentPath, ShaderOptions const &options)
+        : mStages({
+              {GL_VERTEX_SHADER, vertexPath, "VERTEX"},
+              {GL_GEOMETRY_SHADER, geometryPath, "GEOMETRY"},
+              {GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT"}
+          }),
+          mOptions(options), mPermutation(~0u), mID(0)
     {
-        // Create shader
-        mID = glCreateProgram();
-        attachShader(GL_VERTEX_SHADER, vertexPath, "VERTEX");
-        attachShader(GL_GEOMETRY_SHADER, geometryPath, "GEOMETRY");
-        attachShader(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
-        glLinkProgram(mID);
-        checkCompileErrors(mID, "PROGRAM");
+        setPermutation(0);
     }
 
-    Shader::Shader(std::string vertexPath, std::string tcsPath, std::string tesPath, std::string geomPath, std::string fragmentPath)
-    {
-        // Create shader
-        mID = glCreateProgram();
-        attachShader(GL_VERTEX_SHADER, vertexPath, "VERTEX");
-        attachShader(GL_TESS_CONTROL_SHADER, tcsPath, "TCS");
-        attachShader(GL_TESS_EVALUATION_SHADER, tesPath, "TES");
-        attachShader(GL_GEOMETRY_SHADER, geomPath, "GEOMETRY");
-        attachShader(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
-        glLinkProgram(mID);
-        checkCompileErrors(mID, "PROGRAM");
+    Shader::Shader(std::string vertexPath, std::string tcsPath, std::string tesPath, std::string geomPath, std::string fragmentPath,
+                   ShaderOptions const &options)
+        : mStages({
+              {GL_VERTEX_SHADER, vertexPath, "VERTEX"},
+              {GL_TESS_CONTROL_SHADER, tcsPath, "TCS"},
+              {GL_TESS_EVALUATION_SHADER, tesPath, "TES"},
+              {GL_GEOMETRY_SHADER, geomPath, "GEOMETRY"},
+              {GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT"}
+          }),
+          mOptions(options), mPermutation(~0u), mID(0)
+    {
+        setPermutation(0);
     }
 
     Shader::~Shader()
     {
     }
 
-    void Shader::attachShader(GLuint shaderType, std::string shaderPath, std::string shaderTypeStr)
+    void Shader::setPermutation(unsigned int permutation)
     {
-        // Retrieve the source code from shaderPath
-        std::string shaderCode;
-        std::ifstream shaderFile;
+        // Bits without a feature would only produce duplicate variants
+        permutation &= (1u << mOptions.mFeatures.size()) - 1;
+        if (permutation == mPermutation) {
+            return;
+        }
+        mPermutation = permutation;
 
-        // Ensure ifstream objects can throw exceptions:
-        shaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try {
-            // Open file
-            shaderFile.open(shaderPath);
-            std::stringstream shaderStream;
-            // Read file's buffer contents into streams
-            shaderStream << shaderFile.rdbuf();
-            // Close file handlers
-            shaderFile.close();
-            // Convert stream into string
-            shaderCode = shaderStream.str();
+        auto iter = mPrograms.find(permutation);
+        if (iter == mPrograms.end()) {
+            iter = mPrograms.emplace(permutation, Program()).first;
+            build(iter->second, permutation);
         }
-        catch (std::ifstream::failure e) {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        mID = iter->second.mID;
+    }
+
+    void Shader::build(Program &program, unsigned int permutation)
+    {
+        std::vector<std::string> defines = mOptions.mDefines;
+        for (unsigned int i = 0; i < mOptions.mFeatures.size(); i++) {
+            if (permutation & (1u << i)) {
+                defines.push_back(mOptions.mFeatures[i]);
+            }
+        }
+
+        // Preprocess every stage, keying the variant on the stage types and expanded sources
+        std::vector<std::string> sources;
+        program.mSourceHash = Utils::FileUtils::hash(nullptr, 0);
+        for (auto &stage : mStages) {
+            std::vector<std::string> files;
+            sources.push_back(ShaderPreprocessor::process(stage.mPath, defines, files));
+            program.mFiles.push_back(files);
+            program.mSourceHash = Utils::FileUtils::hash(&stage.mType, sizeof(stage.mType), program.mSourceHash);
+            program.mSourceHash = Utils::FileUtils::hash(sources.back().data(), sources.back().size(), program.mSourceHash);
+        }
+
+        // Create shader
+        program.mID = glCreateProgram();
+        program.mPending = false;
+        if (ShaderCache::load(program.mSourceHash, program.mID)) {
+            return;
+        }
+
+        // Compile and link without querying status, which would wait for the driver
+        for (unsigned int i = 0; i < mStages.size(); i++) {
+            program.mStageIDs.push_back(attachShader(program.mID, mStages[i].mType, sources[i]));
         }
+        glProgramParameteri(program.mID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program.mID);
+        program.mPending = true;
+    }
+
+    void Shader::resolve(Program &program) const
+    {
+        for (unsigned int i = 0; i < program.mStageIDs.size(); i++) {
+            checkCompileErrors(program.mStageIDs[i], mStages[i].mTypeStr);
+        }
+        checkCompileErrors(program.mID, "PROGRAM");
+
+        GLint success = GL_FALSE;
+        glGetProgramiv(program.mID, GL_LINK_STATUS, &success);
+        if (success) {
+            ShaderCache::save(program.mSourceHash, program.mID);
+        }
+        else {
+            // Source string numbers in the messages above index the stage's files
+            std::cout << "Shader sources for permutation " << mPermutation << ":" << std::endl;
+            for (unsigned int i = 0; i < program.mFiles.size(); i++) {
+                for (unsigned int j = 0; j < program.mFiles[i].size(); j++) {
+                    std::cout << "  " << mStages[i].mTypeStr << " " << j << ": " << program.mFiles[i][j] << std::endl;
+                }
+            }
+        }
+
+        // Stages are no longer needed once linked
+        for (auto shaderID : program.mStageIDs) {
+            glDetachShader(program.mID, shaderID);
+            glDeleteShader(shaderID);
+        }
+        program.mStageIDs.clear();
+        program.mPending = false;
+    }
+
+    GLuint Shader::attachShader(GLuint programID, GLuint shaderType, std::string const &shaderCode)
+    {
         const char *shaderCodeCStr = shaderCode.c_str();
-        
+
         // Compile the shaders
         unsigned int shaderID;
         shaderID = glCreateShader(shaderType);
         glShaderSource(shaderID, 1, &shaderCodeCStr, NULL);
         glCompileShader(shaderID);
-        checkCompileErrors(shaderID, shaderTypeStr);
 
         // Attach
-        glAttachShader(mID, shaderID);
+        glAttachShader(programID, shaderID);
+        return shaderID;
     }
     
     // Utility function for checking shader compilation/linking errors.
-    void Shader::checkCompileErrors(GLuint shader, std::string type)
+    void Shader::checkCompileErrors(GLuint shader, std::string type) const
     {
         GLint success;
         GLchar infoLog[1024];
@@ -113,6 +176,10 @@ namespace Assets
 
     void Shader::use() const
     {
+        Program &program = mPrograms.at(mPermutation);
+        if (program.mPending) {
+            resolve(program);
+        }
         glUseProgram(mID);
     }
 
@@ -0,0 +1,156 @@
+#include "Assets/shadercache.hpp"
+#include "Utils/fileutils.hpp"
+#include "Utils/mappedfile.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// GL_KHR_parallel_shader_compile is an extension rather than core, so glad does not define it
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+const unsigned int CACHE_VERSION = 1;
+const char CACHE_MAGIC[4] = {'D', 'S', 'P', 'B'};
+
+namespace
+{
+    struct CacheHeader
+    {
+        char mMagic[4];
+        unsigned int mVersion;
+        unsigned long long mKey;
+        unsigned int mBinaryFormat;
+        unsigned int mBinarySize;
+    };
+
+    bool hasExtension(const char *name)
+    {
+        GLint numExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+        for (GLint i = 0; i < numExtensions; i++) {
+            const char *extension = (const char *) glGetStringi(GL_EXTENSIONS, i);
+            if (extension && strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+namespace Assets
+{
+    bool ShaderCache::mEnabled = false;
+    bool ShaderCache::mParallelCompile = false;
+    unsigned long long ShaderCache::mDriverHash = 0;
+    std::string ShaderCache::mCacheDirectory;
+
+    void ShaderCache::initialize(std::string const &cacheDirectory, GLADloadproc loader)
+    {
+        mCacheDirectory = cacheDirectory;
+
+        // Binaries are only valid for the exact driver that produced them
+        mDriverHash = Utils::FileUtils::hash(nullptr, 0);
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            const char *value = (const char *) glGetString(name);
+            if (value) {
+                mDriverHash = Utils::FileUtils::hash(value, strlen(value) + 1, mDriverHash);
+            }
+        }
+
+        // Some drivers accept binaries but expose no formats to save them in
+        GLint numFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        mEnabled = numFormats > 0;
+        if (mEnabled) {
+            Utils::FileUtils::createDirectories(mCacheDirectory);
+        }
+        else {
+            std::cout << "Program binaries unsupported, compiling shaders from source." << std::endl;
+        }
+
+        // Let the driver compile on as many threads as it likes, so links return immediately
+        mParallelCompile = false;
+        if (hasExtension("GL_KHR_parallel_shader_compile")) {
+            auto maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) loader("glMaxShaderCompilerThreadsKHR");
+            if (maxShaderCompilerThreads) {
+                maxShaderCompilerThreads(0xFFFFFFFF);
+                mParallelCompile = true;
+            }
+        }
+    }
+
+    bool ShaderCache::load(unsigned long long sourceHash, unsigned int program)
+    {
+        if (!mEnabled) {
+            return false;
+        }
+
+        unsigned long long key = getKey(sourceHash);
+        Utils::MappedFile file(getCachePath(key));
+        if (!file.isValid() || file.getSize() < sizeof(CacheHeader)) {
+            return false;
+        }
+
+        CacheHeader header;
+        memcpy(&header, file.getData(), sizeof(CacheHeader));
+        if (memcmp(header.mMagic, CACHE_MAGIC, 4) != 0 || header.mVersion != CACHE_VERSION ||
+            header.mKey != key || file.getSize() < sizeof(CacheHeader) + header.mBinarySize) {
+            return false;
+        }
+
+        // Drivers may still reject a binary, in which case the caller compiles from source
+        glProgramBinary(program, header.mBinaryFormat, file.getData() + sizeof(CacheHeader), header.mBinarySize);
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        return success == GL_TRUE;
+    }
+
+    void ShaderCache::save(unsigned long long sourceHash, unsigned int program)
+    {
+        if (!mEnabled) {
+            return;
+        }
+
+        GLint binarySize = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+        if (binarySize <= 0) {
+            return;
+        }
+
+        CacheHeader header;
+        memcpy(header.mMagic, CACHE_MAGIC, 4);
+        header.mVersion = CACHE_VERSION;
+        header.mKey = getKey(sourceHash);
+
+        std::string contents(sizeof(CacheHeader) + binarySize, '\0');
+        GLenum binaryFormat = 0;
+        GLsizei written = 0;
+        glGetProgramBinary(program, binarySize, &written, &binaryFormat, &contents[sizeof(CacheHeader)]);
+        if (written <= 0) {
+            return;
+        }
+        header.mBinaryFormat = binaryFormat;
+        header.mBinarySize = written;
+        contents.resize(sizeof(CacheHeader) + written);
+        memcpy(&contents[0], &header, sizeof(CacheHeader));
+
+        std::string cachePath = getCachePath(header.mKey);
+        if (!Utils::FileUtils::writeAtomically(cachePath, contents)) {
+            std::cout << "Unable to write shader cache file: " << cachePath << std::endl;
+        }
+    }
+
+    std::string ShaderCache::getCachePath(unsigned long long key)
+    {
+        std::stringstream cachePath;
+        cachePath << mCacheDirectory << "/" << std::hex << key << ".dsp";
+        return cachePath.str();
+    }
+
+    unsigned long long ShaderCache::getKey(unsigned long long sourceHash)
+    {
+        unsigned long long key = Utils::FileUtils::hash(&sourceHash, sizeof(sourceHash), mDriverHash);
+        return Utils::FileUtils::hash(&CACHE_VERSION, sizeof(CACHE_VERSION), key);
+    }
+}
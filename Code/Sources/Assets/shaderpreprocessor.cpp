@@ -0,0 +1,92 @@
+#include "Assets/shaderpreprocessor.hpp"
+#include "Utils/mappedfile.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    // Directive name if the line is a preprocessor directive, with the rest of the line in arguments
+    std::string parseDirective(std::string const &line, std::string &arguments)
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] != '#') {
+            return std::string();
+        }
+        size_t nameStart = line.find_first_not_of(" \t", start + 1);
+        if (nameStart == std::string::npos) {
+            return std::string();
+        }
+        size_t nameEnd = line.find_first_of(" \t", nameStart);
+        arguments = nameEnd == std::string::npos ? std::string() : line.substr(nameEnd);
+        return line.substr(nameStart, nameEnd == std::string::npos ? std::string::npos : nameEnd - nameStart);
+    }
+}
+
+namespace Assets
+{
+    std::string ShaderPreprocessor::process(std::string const &path, std::vector<std::string> const &defines,
+                                            std::vector<std::string> &files)
+    {
+        std::string output;
+        files.clear();
+        expand(path, defines, output, files);
+        return output;
+    }
+
+    void ShaderPreprocessor::expand(std::string const &path, std::vector<std::string> const &defines,
+                                    std::string &output, std::vector<std::string> &files)
+    {
+        Utils::MappedFile file(path);
+        if (!file.isValid()) {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+            return;
+        }
+        unsigned int fileIndex = files.size();
+        files.push_back(path);
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+
+        std::istringstream source(std::string((const char *) file.getData(), file.getSize()));
+        std::string line;
+        unsigned int lineNumber = 0;
+        while (std::getline(source, line)) {
+            lineNumber++;
+            std::string arguments;
+            std::string directive = parseDirective(line, arguments);
+
+            if (directive == "version") {
+                // Only the top-level file declares a version; defines must follow it
+                if (fileIndex != 0) {
+                    output += "\n";
+                    continue;
+                }
+                output += line + "\n";
+                for (auto &define : defines) {
+                    output += "#define " + define + "\n";
+                }
+                output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+            }
+            else if (directive == "include") {
+                size_t open = arguments.find('"');
+                size_t close = open == std::string::npos ? std::string::npos : arguments.find('"', open + 1);
+                if (close == std::string::npos) {
+                    std::cout << "Malformed #include in " << path << ":" << lineNumber << std::endl;
+                    output += "\n";
+                    continue;
+                }
+                std::string includePath = directory + arguments.substr(open + 1, close - open - 1);
+                if (std::find(files.begin(), files.end(), includePath) != files.end()) {
+                    output += "\n";
+                    continue;
+                }
+                output += "#line 1 " + std::to_string(files.size()) + "\n";
+                expand(includePath, defines, output, files);
+                output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+            }
+            else {
+                output += line + "\n";
+            }
+        }
+    }
+}
@@ -3,36 +3,82 @@
 #include <glad/glad.h>
 #include <stb_image.h>
 
+#include <algorithm>
 #include <iostream>
 
 namespace Assets
 {
-    Texture::Texture(std::string const &path, bool flipVertically)
+    Texture::Texture() : mID(0), mWidth(0), mHeight(0), mComponents(0)
+    {
+    }
+
+    Texture::Texture(std::string const &path, bool flipVertically, bool upload)
+        : mID(0), mWidth(0), mHeight(0), mComponents(0)
     {
         loadTexture(path, flipVertically);
+        if (upload) {
+            this->upload();
+        }
     }
 
     void Texture::loadTexture(std::string const &path, bool flipVertically)
     {
         mPath = path;
 
+        // Prefer the pre-mipped block-compressed copy from the texture cache
+        if (TextureCache::load(path, flipVertically, true, mCompressedImage)) {
+            return;
+        }
+
+        // Flip manually, since stbi_set_flip_vertically_on_load is global state shared by all loader threads
+        unsigned char *data = stbi_load(path.c_str(), &mWidth, &mHeight, &mComponents, 0);
+        if (data) {
+            int rowSize = mWidth*mComponents;
+            mPixels.resize(rowSize*mHeight);
+            for (int row = 0; row < mHeight; row++) {
+                int srcRow = flipVertically ? mHeight-1-row : row;
+                std::copy(data + srcRow*rowSize, data + (srcRow+1)*rowSize, mPixels.begin() + row*rowSize);
+            }
+            stbi_image_free(data);
+        } else {
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            stbi_image_free(data);
+        }
+    }
+
+    void Texture::upload()
+    {
+        if (mID != 0) {
+            return;
+        }
+
         glGenTextures(1, &mID);
 
-        stbi_set_flip_vertically_on_load(flipVertically);
+        if (!mCompressedImage.mLevels.empty()) {
+            glBindTexture(GL_TEXTURE_2D, mID);
+            TextureCache::upload(GL_TEXTURE_2D, mCompressedImage);
 
-        int width, height, nrComponents;
-        unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
-        if (data) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            // Release the mapping once the blocks live on the GPU
+            mCompressedImage = CompressedImage();
+        }
+        else if (!mPixels.empty()) {
             GLenum format;
-            if (nrComponents == 1)
+            if (mComponents == 1)
                 format = GL_RED;
-            else if (nrComponents == 3)
+            else if (mComponents == 3)
                 format = GL_RGB;
-            else if (nrComponents == 4)
+            else if (mComponents == 4)
                 format = GL_RGBA;
 
             glBindTexture(GL_TEXTURE_2D, mID);
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format, GL_UNSIGNED_BYTE, &mPixels[0]);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
             glGenerateMipmap(GL_TEXTURE_2D);
 
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -40,10 +86,8 @@ namespace Assets
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-            stbi_image_free(data);
-        } else {
-            std::cout << "Texture failed to load at path: " << path << std::endl;
-            stbi_image_free(data);
+            // Pixels are no longer needed once they live on the GPU
+            std::vector<unsigned char>().swap(mPixels);
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,249 @@
+#include "Assets/texturecache.hpp"
+#include "Utils/blockcompression.hpp"
+#include "Utils/fileutils.hpp"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// S3TC is an extension rather than core, so glad does not define these
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+
+const unsigned int CACHE_VERSION = 1;
+const char CACHE_MAGIC[4] = {'D', 'S', 'T', 'C'};
+
+namespace
+{
+    struct CacheHeader
+    {
+        char mMagic[4];
+        unsigned int mVersion;
+        unsigned long long mSourceHash;
+        unsigned int mFormat;
+        unsigned int mLevelCount;
+    };
+
+    struct CacheLevel
+    {
+        unsigned int mWidth;
+        unsigned int mHeight;
+        unsigned int mOffset;
+        unsigned int mSize;
+    };
+
+    // 2x2 box filter, clamping at odd edges
+    std::vector<unsigned char> downsample(std::vector<unsigned char> const &rgba, int width, int height, int newWidth, int newHeight)
+    {
+        std::vector<unsigned char> result(newWidth*newHeight*4);
+        for (int y = 0; y < newHeight; y++) {
+            int y0 = std::min(y*2, height - 1);
+            int y1 = std::min(y*2 + 1, height - 1);
+            for (int x = 0; x < newWidth; x++) {
+                int x0 = std::min(x*2, width - 1);
+                int x1 = std::min(x*2 + 1, width - 1);
+                for (int c = 0; c < 4; c++) {
+                    int sum = rgba[(y0*width + x0)*4 + c] + rgba[(y0*width + x1)*4 + c] +
+                              rgba[(y1*width + x0)*4 + c] + rgba[(y1*width + x1)*4 + c];
+                    result[(y*newWidth + x)*4 + c] = (sum + 2)/4;
+                }
+            }
+        }
+        return result;
+    }
+}
+
+namespace Assets
+{
+    bool TextureCache::mEnabled = false;
+    std::string TextureCache::mCacheDirectory;
+
+    void TextureCache::initialize(std::string const &cacheDirectory)
+    {
+        mCacheDirectory = cacheDirectory;
+
+        // RGTC is core, but S3TC is required for color textures
+        mEnabled = false;
+        GLint numExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+        for (GLint i = 0; i < numExtensions; i++) {
+            const char *extension = (const char *) glGetStringi(GL_EXTENSIONS, i);
+            if (extension && strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0) {
+                mEnabled = true;
+                break;
+            }
+        }
+
+        if (mEnabled) {
+            Utils::FileUtils::createDirectories(mCacheDirectory);
+        }
+        else {
+            std::cout << "S3TC texture compression unsupported, using uncompressed textures." << std::endl;
+        }
+    }
+
+    bool TextureCache::load(std::string const &path, bool flipVertically, bool mipmaps, CompressedImage &image)
+    {
+        if (!mEnabled) {
+            return false;
+        }
+
+        Utils::MappedFile source(path);
+        if (!source.isValid()) {
+            return false;
+        }
+
+        // Key on source contents and every option that changes the output
+        unsigned long long sourceHash = Utils::FileUtils::hash(source.getData(), source.getSize());
+        unsigned char options[3] = {(unsigned char) flipVertically, (unsigned char) mipmaps, (unsigned char) CACHE_VERSION};
+        sourceHash = Utils::FileUtils::hash(options, sizeof(options), sourceHash);
+
+        std::stringstream cachePath;
+        cachePath << mCacheDirectory << "/" << std::hex << sourceHash << ".dtc";
+
+        if (readCacheFile(cachePath.str(), sourceHash, image)) {
+            return true;
+        }
+        if (!transcode(source, flipVertically, mipmaps, image)) {
+            return false;
+        }
+        writeCacheFile(cachePath.str(), sourceHash, image);
+        return true;
+    }
+
+    void TextureCache::upload(unsigned int target, CompressedImage const &image)
+    {
+        for (unsigned int i = 0; i < image.mLevels.size(); i++) {
+            auto &level = image.mLevels[i];
+            glCompressedTexImage2D(target, i, image.mFormat, level.mWidth, level.mHeight, 0, level.mSize, level.mData);
+        }
+        if (target == GL_TEXTURE_2D) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.mLevels.size() - 1);
+        }
+    }
+
+    bool TextureCache::readCacheFile(std::string const &cachePath, unsigned long long sourceHash, CompressedImage &image)
+    {
+        auto file = std::make_shared<Utils::MappedFile>(cachePath);
+        if (!file->isValid() || file->getSize() < sizeof(CacheHeader)) {
+            return false;
+        }
+
+        CacheHeader header;
+        memcpy(&header, file->getData(), sizeof(CacheHeader));
+        if (memcmp(header.mMagic, CACHE_MAGIC, 4) != 0 || header.mVersion != CACHE_VERSION ||
+            header.mSourceHash != sourceHash || header.mLevelCount == 0) {
+            return false;
+        }
+
+        size_t tableEnd = sizeof(CacheHeader) + header.mLevelCount*sizeof(CacheLevel);
+        if (file->getSize() < tableEnd) {
+            return false;
+        }
+
+        image.mFormat = header.mFormat;
+        image.mLevels.clear();
+        for (unsigned int i = 0; i < header.mLevelCount; i++) {
+            CacheLevel level;
+            memcpy(&level, file->getData() + sizeof(CacheHeader) + i*sizeof(CacheLevel), sizeof(CacheLevel));
+            if ((size_t) level.mOffset + level.mSize > file->getSize()) {
+                std::cout << "Corrupt texture cache file: " << cachePath << std::endl;
+                image.mLevels.clear();
+                return false;
+            }
+            image.mLevels.push_back({(int) level.mWidth, (int) level.mHeight, file->getData() + level.mOffset, level.mSize});
+        }
+        image.mFile = file;
+        return true;
+    }
+
+    void TextureCache::writeCacheFile(std::string const &cachePath, unsigned long long sourceHash, CompressedImage const &image)
+    {
+        CacheHeader header;
+        memcpy(header.mMagic, CACHE_MAGIC, 4);
+        header.mVersion = CACHE_VERSION;
+        header.mSourceHash = sourceHash;
+        header.mFormat = image.mFormat;
+        header.mLevelCount = image.mLevels.size();
+
+        std::string contents((const char *) &header, sizeof(header));
+        unsigned int offset = sizeof(CacheHeader) + image.mLevels.size()*sizeof(CacheLevel);
+        for (auto &level : image.mLevels) {
+            CacheLevel cacheLevel = {(unsigned int) level.mWidth, (unsigned int) level.mHeight, offset, level.mSize};
+            contents.append((const char *) &cacheLevel, sizeof(cacheLevel));
+            offset += level.mSize;
+        }
+        for (auto &level : image.mLevels) {
+            contents.append((const char *) level.mData, level.mSize);
+        }
+
+        if (!Utils::FileUtils::writeAtomically(cachePath, contents)) {
+            std::cout << "Unable to write texture cache file: " << cachePath << std::endl;
+        }
+    }
+
+    bool TextureCache::transcode(Utils::MappedFile const &source, bool flipVertically, bool mipmaps, CompressedImage &image)
+    {
+        int width, height, nrComponents;
+        unsigned char *data = stbi_load_from_memory(source.getData(), source.getSize(), &width, &height, &nrComponents, 4);
+        if (!data) {
+            return false;
+        }
+
+        std::vector<unsigned char> rgba(width*height*4);
+        int rowSize = width*4;
+        for (int row = 0; row < height; row++) {
+            int srcRow = flipVertically ? height-1-row : row;
+            std::copy(data + srcRow*rowSize, data + (srcRow+1)*rowSize, rgba.begin() + row*rowSize);
+        }
+        stbi_image_free(data);
+
+        Utils::BlockCompression::Format format;
+        if (nrComponents == 1) {
+            format = Utils::BlockCompression::BC4;
+            image.mFormat = GL_COMPRESSED_RED_RGTC1;
+        }
+        else if (nrComponents == 2) {
+            format = Utils::BlockCompression::BC5;
+            image.mFormat = GL_COMPRESSED_RG_RGTC2;
+        }
+        else if (nrComponents == 3) {
+            format = Utils::BlockCompression::BC1;
+            image.mFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        }
+        else {
+            format = Utils::BlockCompression::BC3;
+            image.mFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        }
+
+        // Encode every level, then point the levels into the shared storage
+        std::vector<unsigned int> offsets;
+        image.mLevels.clear();
+        image.mStorage.clear();
+        int levelWidth = width;
+        int levelHeight = height;
+        while (true) {
+            std::vector<unsigned char> blocks = Utils::BlockCompression::compress(format, &rgba[0], levelWidth, levelHeight);
+            offsets.push_back(image.mStorage.size());
+            image.mLevels.push_back({levelWidth, levelHeight, nullptr, (unsigned int) blocks.size()});
+            image.mStorage.insert(image.mStorage.end(), blocks.begin(), blocks.end());
+
+            if (!mipmaps || (levelWidth == 1 && levelHeight == 1)) {
+                break;
+            }
+            int newWidth = std::max(1, levelWidth/2);
+            int newHeight = std::max(1, levelHeight/2);
+            rgba = downsample(rgba, levelWidth, levelHeight, newWidth, newHeight);
+            levelWidth = newWidth;
+            levelHeight = newHeight;
+        }
+        for (unsigned int i = 0; i < image.mLevels.size(); i++) {
+            image.mLevels[i].mData = &image.mStorage[offsets[i]];
+        }
+        return true;
+    }
+}
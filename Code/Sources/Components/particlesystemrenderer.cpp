@@ -1,14 +1,21 @@
 #include "Components/particlesystemrenderer.hpp"
+#include "Core/random.hpp"
+#include "Rendering/graphicscontext.hpp"
 
-float frand(float min,float max)
+const unsigned long long PARTICLE_RANDOM_STREAM = 1;
+
+// Buffers are only reset on the render thread, so every emitter shares one stream
+Core::Random &particleRandom()
 {
-   return rand()*(max-min)/RAND_MAX+min;
+  static Core::Random random(PARTICLE_RANDOM_STREAM);
+  return random;
 }
 
 
 namespace Components
 {
-  ParticleSystemRenderer::ParticleSystemRenderer(Core::GameObject &gameObject) : Component(gameObject)
+  ParticleSystemRenderer::ParticleSystemRenderer(Core::GameObject &gameObject) : Component(gameObject),
+    mPendingReset(false)
   {
   }
 
@@ -37,6 +44,9 @@ namespace Components
   void ParticleSystemRenderer::setupParticleSystem(unsigned int numParticles)
   {
     mNumParticles = numParticles;
+    if (Rendering::GraphicsContext::isHeadless()) {
+      return;
+    }
 
     // Create position buffer
     glGenBuffers(1, &mPositionBuffer);
@@ -76,9 +86,9 @@ namespace Components
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, mPositionBuffer);
     glm::vec4 *pos = (glm::vec4*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, mNumParticles*sizeof(glm::vec4), GL_MAP_WRITE_BIT|GL_MAP_INVALIDATE_BUFFER_BIT);
     for (int i = 0; i < mNumParticles; i++) {
-      pos[i].x = frand(-mMaxOffset.x, mMaxOffset.x);
-      pos[i].y = frand(-mMaxOffset.y, mMaxOffset.y);
-      pos[i].z = frand(-mMaxOffset.z, mMaxOffset.z);
+      pos[i].x = particleRandom().nextFloat(-mMaxOffset.x, mMaxOffset.x);
+      pos[i].y = particleRandom().nextFloat(-mMaxOffset.y, mMaxOffset.y);
+      pos[i].z = particleRandom().nextFloat(-mMaxOffset.z, mMaxOffset.z);
       pos[i].w = 0.0f;
     }
     glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
@@ -9,4 +9,17 @@ namespace Components
   Script::~Script()
   {
   }
+
+  void Script::saveState(Core::StateWriter &writer) const
+  {
+  }
+
+  void Script::loadState(Core::StateReader &reader)
+  {
+  }
+
+  bool Script::isKeyPressed(GLFWwindow *window, int key)
+  {
+    return window != nullptr && glfwGetKey(window, key) == GLFW_PRESS;
+  }
 }
\ No newline at end of file
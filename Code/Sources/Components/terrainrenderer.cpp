@@ -1,4 +1,5 @@
 #include "Components/terrainrenderer.hpp"
+#include "Rendering/graphicscontext.hpp"
 
 namespace Components
 {
@@ -20,6 +21,9 @@ namespace Components
         mStartPositions.push_back(glm::vec2(startX, startZ));
       }
     }
+    if (Rendering::GraphicsContext::isHeadless()) {
+      return;
+    }
 
     glGenBuffers(1, &mInstanceVBO);
     glBindBuffer(GL_ARRAY_BUFFER, mInstanceVBO);
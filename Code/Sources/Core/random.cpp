@@ -0,0 +1,47 @@
+#include "Core/random.hpp"
+
+namespace Core
+{
+    unsigned long long Random::mSeed = 0;
+
+    namespace
+    {
+        // SplitMix64, which spreads nearby seeds and stream ids across the whole state space
+        unsigned long long mix(unsigned long long value)
+        {
+            value += 0x9e3779b97f4a7c15ULL;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+            return value ^ (value >> 31);
+        }
+    }
+
+    Random::Random(unsigned long long stream)
+        : mState(mix(mSeed ^ mix(stream)))
+    {
+        // xorshift never leaves a zero state
+        if (mState == 0) {
+            mState = 0x9e3779b97f4a7c15ULL;
+        }
+    }
+
+    Random::~Random()
+    {
+    }
+
+    unsigned long long Random::next()
+    {
+        // xorshift64*
+        mState ^= mState >> 12;
+        mState ^= mState << 25;
+        mState ^= mState >> 27;
+        return mState * 0x2545f4914f6cdd1dULL;
+    }
+
+    float Random::nextFloat(float min, float max)
+    {
+        // Top 24 bits, which a float holds exactly
+        float unit = (next() >> 40) * (1.0f / 16777216.0f);
+        return min + (max - min)*unit;
+    }
+}
@@ -1,5 +1,6 @@
 #include "Core/scene.hpp"
 #include "Components/script.hpp"
+#include "Components/particlesystemrenderer.hpp"
 
 #include <iostream>
 
@@ -34,6 +35,19 @@ namespace Core
         for (auto script : getComponents<Components::Script>()) {
             script->onUpdate(window, *this, deltaTime);
         }
+
+        // Particle lifetimes advance with the simulation, not with the frames that draw them
+        for (auto &particleSystemRenderer : getComponents<Components::ParticleSystemRenderer>()) {
+            if (!particleSystemRenderer->mIsActive) {
+                continue;
+            }
+            particleSystemRenderer->mTimeActive += deltaTime;
+            if (particleSystemRenderer->mTimeActive >= particleSystemRenderer->mParticleSystem->mParticleLifetime*2) {
+                particleSystemRenderer->mTimeActive = 0.0f;
+                particleSystemRenderer->mIsActive = false;
+                particleSystemRenderer->mPendingReset = true;
+            }
+        }
     }
 
     void Scene::initialize()
@@ -0,0 +1,32 @@
+#include "Core/simulationclock.hpp"
+
+#include <algorithm>
+
+namespace Core
+{
+    SimulationClock::SimulationClock(double tickRate, int maxTicksPerFrame)
+        : mTickLength(1.0 / tickRate), mMaxTicksPerFrame(maxTicksPerFrame), mAccumulator(0.0), mTickCount(0)
+    {
+    }
+
+    SimulationClock::~SimulationClock()
+    {
+    }
+
+    int SimulationClock::advance(double frameTime)
+    {
+        mAccumulator += std::max(frameTime, 0.0);
+
+        int ticks = (int) (mAccumulator / mTickLength);
+        if (ticks > mMaxTicksPerFrame) {
+            ticks = mMaxTicksPerFrame;
+            mAccumulator = 0.0;
+        }
+        else {
+            mAccumulator = std::max(mAccumulator - ticks * mTickLength, 0.0);
+        }
+
+        mTickCount += ticks;
+        return ticks;
+    }
+}
@@ -0,0 +1,100 @@
+#include "Core/staterecorder.hpp"
+#include "Core/statestream.hpp"
+#include "Components/script.hpp"
+#include "Components/particlesystemrenderer.hpp"
+#include "Physics/physicsengine.hpp"
+
+#include <iostream>
+
+namespace Core
+{
+    StateRecorder::StateRecorder(Scene &scene, Physics::PhysicsEngine &physicsEngine, int capacity, int interval)
+        : mScene(scene), mPhysicsEngine(physicsEngine), mInterval(interval), mSnapshots(capacity), mNextSnapshot(0),
+          mHashes(capacity*interval), mLastHash(0), mDivergenceReported(false)
+    {
+        for (auto &snapshot : mSnapshots) {
+            snapshot.mValid = false;
+        }
+        for (auto &tickHash : mHashes) {
+            tickHash.mValid = false;
+        }
+    }
+
+    StateRecorder::~StateRecorder()
+    {
+    }
+
+    void StateRecorder::record()
+    {
+        unsigned long long tick = mPhysicsEngine.getTickCount();
+        mScratch.clear();
+        save(mScratch);
+        mLastHash = hashState(mScratch);
+
+        auto &tickHash = mHashes[tick % mHashes.size()];
+        if (tickHash.mValid && tickHash.mTick == tick && tickHash.mHash != mLastHash && !mDivergenceReported) {
+            std::cout << "Simulation diverged from its recorded run at tick " << tick << std::endl;
+            mDivergenceReported = true;
+        }
+        tickHash = { tick, true, mLastHash };
+
+        if (tick % mInterval == 0) {
+            // Both the recorded run and any replay from here start with empty contact caches
+            mPhysicsEngine.resetCollisionState(mScene);
+            auto &snapshot = mSnapshots[mNextSnapshot];
+            snapshot.mTick = tick;
+            snapshot.mValid = true;
+            snapshot.mData.swap(mScratch);
+            mNextSnapshot = (mNextSnapshot + 1) % mSnapshots.size();
+        }
+    }
+
+    bool StateRecorder::rewind(unsigned long long ticks)
+    {
+        unsigned long long tick = mPhysicsEngine.getTickCount();
+        Snapshot const *latest = nullptr;
+        for (auto &snapshot : mSnapshots) {
+            if (snapshot.mValid && snapshot.mTick + ticks <= tick && (!latest || snapshot.mTick > latest->mTick)) {
+                latest = &snapshot;
+            }
+        }
+        if (!latest) {
+            return false;
+        }
+
+        load(latest->mData);
+        mLastHash = hashState(latest->mData);
+        mDivergenceReported = false;
+        return true;
+    }
+
+    void StateRecorder::save(std::vector<unsigned char> &data) const
+    {
+        StateWriter writer(data);
+        mPhysicsEngine.saveState(mScene, writer);
+        for (auto &script : mScene.getComponents<Components::Script>()) {
+            script->saveState(writer);
+        }
+        // Particle positions live on the GPU and only decorate the scene, so emitters restart rather than resume
+        for (auto &particleSystemRenderer : mScene.getComponents<Components::ParticleSystemRenderer>()) {
+            writer.write(particleSystemRenderer->mIsActive);
+            writer.write(particleSystemRenderer->mTimeActive);
+            writer.write(particleSystemRenderer->mGameObject.mTransform->mTranslation);
+        }
+    }
+
+    void StateRecorder::load(std::vector<unsigned char> const &data)
+    {
+        StateReader reader(data);
+        mPhysicsEngine.loadState(mScene, reader);
+        for (auto &script : mScene.getComponents<Components::Script>()) {
+            script->loadState(reader);
+        }
+        for (auto &particleSystemRenderer : mScene.getComponents<Components::ParticleSystemRenderer>()) {
+            reader.read(particleSystemRenderer->mIsActive);
+            reader.read(particleSystemRenderer->mTimeActive);
+            particleSystemRenderer->mGameObject.mTransform->setTranslation(reader.read<glm::vec3>());
+            particleSystemRenderer->mPendingReset = true;
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#include "Core/statestream.hpp"
+
+namespace Core
+{
+    unsigned long long hashState(std::vector<unsigned char> const &data)
+    {
+        // FNV-1a over words rather than bytes, with a final avalanche
+        const unsigned long long prime = 0x100000001b3ULL;
+        unsigned long long hash = 0xcbf29ce484222325ULL;
+        size_t words = data.size() / 8;
+        for (size_t i = 0; i < words; i++) {
+            unsigned long long word;
+            std::memcpy(&word, data.data() + i*8, 8);
+            hash = (hash ^ word) * prime;
+        }
+        for (size_t i = words*8; i < data.size(); i++) {
+            hash = (hash ^ data[i]) * prime;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+}
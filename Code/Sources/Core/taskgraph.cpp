@@ -0,0 +1,123 @@
+#include "Core/taskgraph.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+namespace Core
+{
+    TaskGraph::TaskGraph(ThreadPool &threadPool)
+        : mThreadPool(threadPool), mCompletedTasks(0), mTotalTime(0)
+    {
+    }
+
+    int TaskGraph::addWorkerTask(std::string const &name, std::function<void()> function, std::vector<int> const &dependencies)
+    {
+        return addTask(name, function, dependencies, false);
+    }
+
+    int TaskGraph::addMainTask(std::string const &name, std::function<void()> function, std::vector<int> const &dependencies)
+    {
+        return addTask(name, function, dependencies, true);
+    }
+
+    int TaskGraph::addTask(std::string const &name, std::function<void()> function, std::vector<int> const &dependencies, bool mainThread)
+    {
+        int taskIdx = mTasks.size();
+        Task task;
+        task.mName = name;
+        task.mFunction = function;
+        task.mRemainingDependencies = dependencies.size();
+        task.mMainThread = mainThread;
+        task.mStartTime = 0;
+        task.mEndTime = 0;
+        mTasks.push_back(task);
+
+        // Dependencies must already exist, which also rules out cycles
+        for (int dependency : dependencies) {
+            mTasks[dependency].mDependents.push_back(taskIdx);
+        }
+        return taskIdx;
+    }
+
+    void TaskGraph::run()
+    {
+        mRunStart = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        for (unsigned int i = 0; i < mTasks.size(); i++) {
+            if (mTasks[i].mRemainingDependencies == 0) {
+                schedule(i);
+            }
+        }
+
+        // Main thread services its own queue until every task has finished
+        while (mCompletedTasks < (int) mTasks.size()) {
+            if (!mReadyMainTasks.empty()) {
+                int taskIdx = mReadyMainTasks.front();
+                mReadyMainTasks.pop_front();
+                lock.unlock();
+                execute(taskIdx);
+                lock.lock();
+            }
+            else {
+                mCondition.wait(lock);
+            }
+        }
+
+        mTotalTime = elapsedSeconds();
+    }
+
+    void TaskGraph::report() const
+    {
+        double serialTime = 0;
+        std::cout << "Task schedule (" << mThreadPool.getNumThreads() << " worker threads):" << std::endl;
+        for (auto &task : mTasks) {
+            double duration = task.mEndTime - task.mStartTime;
+            serialTime += duration;
+            std::cout << std::fixed << std::setprecision(1)
+                      << "  [" << (task.mMainThread ? "main  " : "worker") << "] "
+                      << std::setw(8) << task.mStartTime*1000.0 << " - "
+                      << std::setw(8) << task.mEndTime*1000.0 << " ms  ("
+                      << std::setw(7) << duration*1000.0 << " ms)  "
+                      << task.mName << std::endl;
+        }
+        std::cout << "  Total: " << mTotalTime*1000.0 << " ms, "
+                  << "serial: " << serialTime*1000.0 << " ms" << std::endl;
+        std::cout << std::defaultfloat;
+    }
+
+    void TaskGraph::schedule(int taskIdx)
+    {
+        if (mTasks[taskIdx].mMainThread) {
+            mReadyMainTasks.push_back(taskIdx);
+            mCondition.notify_all();
+        }
+        else {
+            mThreadPool.submit([this, taskIdx]() { execute(taskIdx); });
+        }
+    }
+
+    void TaskGraph::execute(int taskIdx)
+    {
+        Task &task = mTasks[taskIdx];
+        double startTime = elapsedSeconds();
+        task.mFunction();
+        double endTime = elapsedSeconds();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        task.mStartTime = startTime;
+        task.mEndTime = endTime;
+        mCompletedTasks++;
+        for (int dependent : task.mDependents) {
+            if (--mTasks[dependent].mRemainingDependencies == 0) {
+                schedule(dependent);
+            }
+        }
+        mCondition.notify_all();
+    }
+
+    double TaskGraph::elapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - mRunStart).count();
+    }
+}
@@ -0,0 +1,132 @@
+#include "Core/threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace Core
+{
+    ThreadPool::ThreadPool(unsigned int numThreads) : mStopping(false)
+    {
+        if (numThreads == 0) {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            numThreads = std::max(hardwareThreads, 2u) - 1;
+        }
+
+        for (unsigned int i = 0; i < numThreads; i++) {
+            mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mCondition.notify_all();
+        for (auto &worker : mWorkers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool &ThreadPool::getInstance()
+    {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    void ThreadPool::submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTasks.push_back(std::move(task));
+        }
+        mCondition.notify_one();
+    }
+
+    void ThreadPool::parallelFor(int count, std::function<void(int)> const &function)
+    {
+        if (count <= 0) {
+            return;
+        }
+
+        struct Batch
+        {
+            std::atomic<int> mNext;
+            std::atomic<int> mDone;
+            std::mutex mMutex;
+            std::condition_variable mCondition;
+        };
+        auto batch = std::make_shared<Batch>();
+        batch->mNext = 0;
+        batch->mDone = 0;
+
+        // Helpers that start after the batch is exhausted exit without touching function
+        auto work = [batch, count, &function]() {
+            int i;
+            while ((i = batch->mNext++) < count) {
+                function(i);
+                if (++batch->mDone == count) {
+                    std::lock_guard<std::mutex> lock(batch->mMutex);
+                    batch->mCondition.notify_all();
+                }
+            }
+        };
+
+        int numHelpers = std::min<int>(count - 1, mWorkers.size());
+        for (int i = 0; i < numHelpers; i++) {
+            submit(work);
+        }
+        work();
+
+        std::unique_lock<std::mutex> lock(batch->mMutex);
+        batch->mCondition.wait(lock, [&batch, count]() { return batch->mDone == count; });
+    }
+
+    void ThreadPool::runOnEachWorker(std::function<void()> const &function)
+    {
+        struct Latch
+        {
+            std::mutex mMutex;
+            std::condition_variable mCondition;
+            unsigned int mDone;
+        };
+        auto latch = std::make_shared<Latch>();
+        latch->mDone = 0;
+
+        // Each worker holds its task until all have run theirs, so none can take two of them
+        unsigned int numWorkers = mWorkers.size();
+        for (unsigned int i = 0; i < numWorkers; i++) {
+            submit([latch, numWorkers, &function]() {
+                function();
+                std::unique_lock<std::mutex> lock(latch->mMutex);
+                if (++latch->mDone == numWorkers) {
+                    latch->mCondition.notify_all();
+                }
+                latch->mCondition.wait(lock, [&latch, numWorkers]() { return latch->mDone == numWorkers; });
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(latch->mMutex);
+        latch->mCondition.wait(lock, [&latch, numWorkers]() { return latch->mDone == numWorkers; });
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+                // Drain remaining work before shutting down
+                if (mTasks.empty()) {
+                    return;
+                }
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            task();
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#include "Core/trackpath.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Core
+{
+    TrackPath::TrackPath(std::vector<glm::vec2> const &controlPoints, int samplesPerSegment)
+        : mLength(0.0f)
+    {
+        int count = controlPoints.size();
+        for (int i = 0; i < count; i++) {
+            glm::vec2 p0 = controlPoints[(i + count - 1) % count];
+            glm::vec2 p1 = controlPoints[i];
+            glm::vec2 p2 = controlPoints[(i + 1) % count];
+            glm::vec2 p3 = controlPoints[(i + 2) % count];
+            for (int j = 0; j < samplesPerSegment; j++) {
+                float t = (float) j / samplesPerSegment;
+                float t2 = t*t;
+                float t3 = t2*t;
+                mPositions.push_back(0.5f * (2.0f*p1 + (p2 - p0)*t + (2.0f*p0 - 5.0f*p1 + 4.0f*p2 - p3)*t2 +
+                                             (3.0f*p1 - p0 - 3.0f*p2 + p3)*t3));
+                mTangents.push_back(glm::normalize(0.5f * ((p2 - p0) + 2.0f*(2.0f*p0 - 5.0f*p1 + 4.0f*p2 - p3)*t +
+                                                           3.0f*(3.0f*p1 - p0 - 3.0f*p2 + p3)*t2)));
+            }
+        }
+
+        mDistances.push_back(0.0f);
+        for (size_t i = 0; i < mPositions.size(); i++) {
+            mLength += glm::length(mPositions[(i + 1) % mPositions.size()] - mPositions[i]);
+            mDistances.push_back(mLength);
+        }
+
+        // Turn between neighbouring tangents per unit length
+        int sampleCount = mPositions.size();
+        for (int i = 0; i < sampleCount; i++) {
+            int previous = (i + sampleCount - 1) % sampleCount;
+            int next = (i + 1) % sampleCount;
+            float span = (mDistances[previous + 1] - mDistances[previous]) + (mDistances[i + 1] - mDistances[i]);
+            mCurvatures.push_back((mTangents[previous].x*mTangents[next].y - mTangents[previous].y*mTangents[next].x) / span);
+        }
+    }
+
+    TrackPath::~TrackPath()
+    {
+    }
+
+    std::shared_ptr<TrackPath> TrackPath::createEllipse(float a, float b, int segments)
+    {
+        std::vector<glm::vec2> controlPoints;
+        for (int i = 0; i < segments; i++) {
+            float theta = glm::radians(360.0f)*i/segments;
+            controlPoints.push_back(glm::vec2(a*glm::cos(theta), b*glm::sin(theta)));
+        }
+        return std::make_shared<TrackPath>(controlPoints);
+    }
+
+    std::shared_ptr<TrackPath> TrackPath::createRacingLine(float innerA, float innerB, float outerA, float outerB,
+                                                           float swing, int segments)
+    {
+        float a = (innerA + outerA)/2;
+        float b = (innerB + outerB)/2;
+        auto curvature = [a, b](float theta) {
+            float sinTheta = glm::sin(theta);
+            float cosTheta = glm::cos(theta);
+            return a*b / std::pow(a*a*sinTheta*sinTheta + b*b*cosTheta*cosTheta, 1.5f);
+        };
+        // An ellipse bends least at the ends of its major axis and hardest at the ends of its minor axis
+        float minCurvature = std::min(curvature(0.0f), curvature(glm::radians(90.0f)));
+        float maxCurvature = std::max(curvature(0.0f), curvature(glm::radians(90.0f)));
+
+        std::vector<glm::vec2> controlPoints;
+        for (int i = 0; i < segments; i++) {
+            float theta = glm::radians(360.0f)*i/segments;
+            float bend = maxCurvature - minCurvature > 1e-6f ?
+                (curvature(theta) - minCurvature) / (maxCurvature - minCurvature) : 0.5f;
+            glm::vec2 outward = glm::normalize(glm::vec2(b*glm::cos(theta), a*glm::sin(theta)));
+            controlPoints.push_back(glm::vec2(a*glm::cos(theta), b*glm::sin(theta)) + outward*swing*(1.0f - 2.0f*bend));
+        }
+        return std::make_shared<TrackPath>(controlPoints);
+    }
+
+    void TrackPath::locate(float distance, int &sample, float &fraction) const
+    {
+        distance = std::fmod(distance, mLength);
+        if (distance < 0.0f) {
+            distance += mLength;
+        }
+        sample = std::upper_bound(mDistances.begin(), mDistances.end(), distance) - mDistances.begin() - 1;
+        sample = std::min(std::max(sample, 0), (int) mPositions.size() - 1);
+        fraction = (distance - mDistances[sample]) / (mDistances[sample + 1] - mDistances[sample]);
+    }
+
+    glm::vec2 TrackPath::getPosition(float distance) const
+    {
+        int sample;
+        float fraction;
+        locate(distance, sample, fraction);
+        return glm::mix(mPositions[sample], mPositions[(sample + 1) % mPositions.size()], fraction);
+    }
+
+    glm::vec2 TrackPath::getTangent(float distance) const
+    {
+        int sample;
+        float fraction;
+        locate(distance, sample, fraction);
+        return glm::normalize(glm::mix(mTangents[sample], mTangents[(sample + 1) % mTangents.size()], fraction));
+    }
+
+    glm::vec2 TrackPath::getLateral(float distance) const
+    {
+        glm::vec2 tangent = getTangent(distance);
+        return glm::vec2(tangent.y, -tangent.x);
+    }
+
+    float TrackPath::getCurvature(float distance) const
+    {
+        int sample;
+        float fraction;
+        locate(distance, sample, fraction);
+        return glm::mix(mCurvatures[sample], mCurvatures[(sample + 1) % mCurvatures.size()], fraction);
+    }
+
+    float TrackPath::getClosestDistance(glm::vec2 position) const
+    {
+        return findClosestDistance(position, 0, mPositions.size());
+    }
+
+    float TrackPath::getClosestDistance(glm::vec2 position, float nearDistance, float range) const
+    {
+        int sample;
+        float fraction;
+        locate(nearDistance, sample, fraction);
+        int samples = std::min((int) std::ceil(range / mLength * mPositions.size()), (int) mPositions.size()/2);
+        return findClosestDistance(position, sample - samples, 2*samples + 1);
+    }
+
+    float TrackPath::findClosestDistance(glm::vec2 position, int first, int count) const
+    {
+        // Nearest point on each chord between samples
+        float closestDistance = 0.0f;
+        float closestSquared = INFINITY;
+        for (int j = 0; j < count; j++) {
+            int i = ((first + j) % (int) mPositions.size() + mPositions.size()) % mPositions.size();
+            glm::vec2 start = mPositions[i];
+            glm::vec2 chord = mPositions[(i + 1) % mPositions.size()] - start;
+            float fraction = glm::clamp(glm::dot(position - start, chord) / glm::dot(chord, chord), 0.0f, 1.0f);
+            glm::vec2 offset = position - (start + chord*fraction);
+            float squared = glm::dot(offset, offset);
+            if (squared < closestSquared) {
+                closestSquared = squared;
+                closestDistance = mDistances[i] + (mDistances[i + 1] - mDistances[i])*fraction;
+            }
+        }
+        return closestDistance;
+    }
+}
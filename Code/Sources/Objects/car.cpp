@@ -46,7 +46,7 @@ namespace Objects
     std::shared_ptr<Assets::Model> Car::mModel;
     std::shared_ptr<Assets::Material> Car::mMaterial;
 
-    Car::Car(glm::vec3 position, const Physics::PhysicsEngine &physicsEngine) : Core::GameObject(position)
+    Car::Car(glm::vec3 position, const Physics::PhysicsEngine &physicsEngine, bool isPlayer) : Core::GameObject(position)
     {
         // **** SETUP TRANSFORM ****
         mTransform->setScale(glm::vec3(SCALE_FACTOR));
@@ -74,7 +74,6 @@ namespace Objects
         wheelMeshRenderer->mWheelMeshes.push_back(mModel->mMeshes[3]);    // Wheel 2
         wheelMeshRenderer->mWheelMeshes.push_back(mModel->mMeshes[4]);    // Wheel 3
         wheelMeshRenderer->mWheelMeshes.push_back(mModel->mMeshes[5]);    // Wheel 4
-        wheelMeshRenderer->mWheelModelMatrices.reserve(4);
         addComponent(wheelMeshRenderer);
 
         // Create physics body
@@ -93,11 +92,11 @@ namespace Objects
         btScalar mass(MASS);
         btVector3 localInertia(0, 0, 0);
         carPhysicsBody->mShape->calculateLocalInertia(mass, localInertia);
-        carPhysicsBody->mMotionState = std::make_unique<btDefaultMotionState>(carTransform);
+        carPhysicsBody->mMotionState = physicsEngine.createMotionState(carTransform, *carPhysicsBody);
         btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, &(*carPhysicsBody->mMotionState), &(*carPhysicsBody->mShape), localInertia);
         carPhysicsBody->mRigidBody = std::make_unique<btRigidBody>(rbInfo);
 
-        carPhysicsBody->mVehicleRaycaster = std::make_unique<btDefaultVehicleRaycaster>(&(*physicsEngine.mDynamicsWorld));
+        carPhysicsBody->mVehicleRaycaster = physicsEngine.createVehicleRaycaster();
         btRaycastVehicle::btVehicleTuning tuning;
         carPhysicsBody->mVehicle = std::make_unique<btRaycastVehicle>(tuning, &(*carPhysicsBody->mRigidBody), &(*carPhysicsBody->mVehicleRaycaster));
         carPhysicsBody->mRigidBody->setActivationState(DISABLE_DEACTIVATION);
@@ -133,15 +132,18 @@ namespace Objects
 
         carPhysicsBody->mVehicle->setCoordinateSystem(0, 1, 2);
 
+        // The vehicle is not added to the world as an action; the physics engine updates all vehicles in parallel batches
         physicsEngine.mDynamicsWorld->addRigidBody(&(*carPhysicsBody->mRigidBody));
-        physicsEngine.mDynamicsWorld->addVehicle(&(*carPhysicsBody->mVehicle));
 
         addComponent<Components::PhysicsBody>(carPhysicsBody);
         addComponent(carPhysicsBody);
+        wheelMeshRenderer->mCarPhysicsBody = carPhysicsBody;
 
         // Create car script
-        auto carScript = std::make_shared<Scripts::CarScript>(*this, position);
-        addComponent<Components::Script>(carScript);
+        if (isPlayer) {
+            auto carScript = std::make_shared<Scripts::CarScript>(*this, position);
+            addComponent<Components::Script>(carScript);
+        }
 
         // **** CREATE SPOTLIGHTS AND TAILLIGHTS ****
         // Create child gameobjects
@@ -192,6 +194,10 @@ namespace Objects
             tailLightGameObject->addComponent(tailLight);
         }
 
+        if (!isPlayer) {
+            return;
+        }
+
         // **** CREATE GAMEOBJECT WITH CAMERA TO FOLLOW CAR ****
         // Create gameobject
         auto cameraGameObject = std::make_shared<Core::GameObject>(glm::vec3(0, 0, 2));
@@ -213,12 +219,12 @@ namespace Objects
     {
     }
 
-    void Car::setup(std::shared_ptr<Assets::Shader> geometryShader)
+    void Car::load()
     {
         // ***** CREATE MODEL *****
         // Import model
         auto carModel = std::make_shared<Assets::Model>(
-            PROJECT_SOURCE_DIR "/Models/lambo/Lamborghini_Aventador.fbx"
+            PROJECT_SOURCE_DIR "/Models/lambo/Lamborghini_Aventador.fbx", false
         );
 
         // Center wheels
@@ -230,7 +236,6 @@ namespace Objects
 
         // ***** CREATE MATERIAL *****
         auto carMaterial = std::make_shared<Assets::Material>();
-        carMaterial->mGeometryShader = geometryShader;
         carMaterial->mAlbedoMap =
             mModel->mAlbedoTextures.size() >= 1 ?
             mModel->mAlbedoTextures[0] :
@@ -245,4 +250,10 @@ namespace Objects
             nullptr;
         mMaterial = carMaterial;
     }
+
+    void Car::setup(std::shared_ptr<Assets::Shader> geometryShader)
+    {
+        mModel->upload();
+        mMaterial->mGeometryShader = geometryShader;
+    }
 }
\ No newline at end of file
@@ -23,6 +23,7 @@ float poleY0 = -A*X_MIN*X_MIN+C;
 
 std::shared_ptr<Assets::Mesh> Streetlight::mPostMesh;
 std::shared_ptr<Assets::Material> Streetlight::mPostMaterial;
+std::shared_ptr<Assets::Impostor> Streetlight::mPostImpostor;
 
 std::shared_ptr<Assets::Mesh> Streetlight::mBulbMesh;
 std::shared_ptr<Assets::Material> Streetlight::mBulbMaterial;
@@ -47,6 +48,7 @@ Streetlight::Streetlight(glm::vec3 position, float theta, bool onLeft, const Phy
     // Create mesh renderer for post
     auto postMeshRenderer = std::make_shared<Components::MeshRenderer>(*this);
     postMeshRenderer->mMaterial = mPostMaterial;
+    postMeshRenderer->mImpostor = mPostImpostor;
     addComponent(postMeshRenderer);
 
     // Create physics body
@@ -57,7 +59,7 @@ Streetlight::Streetlight(glm::vec3 position, float theta, bool onLeft, const Phy
     streetlightTransform.setOrigin(btVector3(position[0], 0, position[2]));
     btScalar mass(0.0f);
     btVector3 localInertia(0, 0, 0);
-    physicsBody->mMotionState = std::make_unique<btDefaultMotionState>(streetlightTransform);
+    physicsBody->mMotionState = physicsEngine.createMotionState(streetlightTransform, *physicsBody);
     btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, &(*physicsBody->mMotionState), &(*physicsBody->mShape), localInertia);
     physicsBody->mRigidBody = std::make_unique<btRigidBody>(rbInfo);
     physicsEngine.mDynamicsWorld->addRigidBody(&(*physicsBody->mRigidBody));
@@ -93,21 +95,19 @@ Streetlight::~Streetlight()
 {
 }
 
-void Streetlight::setup(std::shared_ptr<Assets::Shader> geometryShader)
+void Streetlight::load()
 {
     // ***** CREATE POST MATERIAL *****
     auto postMaterial = std::make_shared<Assets::Material>();
-    postMaterial->mGeometryShader = geometryShader;
     postMaterial->mAlbedoMap = std::make_shared<Assets::Texture>(
-        PROJECT_SOURCE_DIR "/Textures/Streetlight/metal.jpg"
+        PROJECT_SOURCE_DIR "/Textures/Streetlight/metal.jpg", false, false
     );
     mPostMaterial = postMaterial;
 
     // ***** CREATE BULB MATERIAL *****
     auto bulbMaterial = std::make_shared<Assets::Material>();
-    bulbMaterial->mGeometryShader = geometryShader;
     bulbMaterial->mAlbedoMap = std::make_shared<Assets::Texture>(
-        PROJECT_SOURCE_DIR "/Textures/Streetlight/glass.jpg"
+        PROJECT_SOURCE_DIR "/Textures/Streetlight/glass.jpg", false, false
     );
     mBulbMaterial = bulbMaterial;
 
@@ -139,11 +139,23 @@ void Streetlight::setup(std::shared_ptr<Assets::Shader> geometryShader)
     // Create bulb guard shape
     postMeshCreator.addSphere(90.0f, glm::vec3(poleX0-X_MIN, poleY0, 0), 0.2, glm::radians(180.0f)-ROTATION);
 
-    // Convert into mesh
-    mPostMesh = postMeshCreator.create();
+    // Convert into mesh, with an impostor for the far distance
+    mPostMesh = postMeshCreator.create(false);
+    mPostImpostor = std::make_shared<Assets::Impostor>();
 
     // **** CREATE BULB MESH ****
     Utils::MeshCreator bulbMeshCreator;
     bulbMeshCreator.addSphere(180.0f, glm::vec3(poleX0-X_MIN, poleY0, 0), 0.18, 0);
-    mBulbMesh = bulbMeshCreator.create();
+    mBulbMesh = bulbMeshCreator.create(false);
+}
+
+void Streetlight::setup(std::shared_ptr<Assets::Shader> geometryShader)
+{
+    mPostMaterial->mGeometryShader = geometryShader;
+    mPostMaterial->upload();
+    mPostMesh->setupMesh();
+
+    mBulbMaterial->mGeometryShader = geometryShader;
+    mBulbMaterial->upload();
+    mBulbMesh->setupMesh();
 }
\ No newline at end of file
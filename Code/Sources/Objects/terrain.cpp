@@ -3,8 +3,6 @@
 #include "Components/terrainrenderer.hpp"
 #include "Utils/meshcreator.hpp"
 
-#include <stb_image.h>
-
 using namespace Objects;
 
 const float SIZE_X = 128.0f;
@@ -15,21 +13,22 @@ namespace Objects
 {
     std::shared_ptr<Assets::Material> Terrain::mMaterial;
 
-    int Terrain::mHeightmapWidth;
-    int Terrain::mHeightmapHeight;
-    unsigned char *Terrain::mHeightData;
+    std::shared_ptr<Assets::HeightField> Terrain::mHeightField;
+    std::shared_ptr<Physics::HeightFieldQuery> Terrain::mHeightFieldQuery;
 
     Terrain::Terrain(glm::vec3 position, const Physics::PhysicsEngine &physicsEngine) : Core::GameObject(position)
     {
         mTransform->setTranslation(glm::vec3(0, SIZE_Y/2, 0));
 
         // **** CREATE COMPONENTS ****
-        // Create physics body
+        // Create physics body (Bullet reads the shared height data in place)
+        int heightmapWidth = mHeightField->getWidth();
+        int heightmapLength = mHeightField->getLength();
         auto physicsBody = std::make_shared<Components::PhysicsBody>(*this);
         physicsBody->mShape = std::make_unique<btHeightfieldTerrainShape>(
-            mHeightmapHeight,
-            mHeightmapWidth,
-            mHeightData,
+            heightmapWidth,
+            heightmapLength,
+            mHeightField->getData(),
             1.0/255.0*SIZE_Y,
             0,
             SIZE_Y,
@@ -37,7 +36,7 @@ namespace Objects
             PHY_UCHAR,
             false
         );
-        physicsBody->mShape->setLocalScaling(btVector3(SIZE_X/(mHeightmapWidth-1), 1, SIZE_Z/(mHeightmapHeight-1)));
+        physicsBody->mShape->setLocalScaling(btVector3(SIZE_X/(heightmapWidth-1), 1, SIZE_Z/(heightmapLength-1)));
         #ifdef DEBUG
             btVector3 aabbMin, aabbMax;
             physicsBody->mShape->getAabb(btTransform::getIdentity(), aabbMin, aabbMax);
@@ -49,10 +48,11 @@ namespace Objects
         terrainTransform.setOrigin(btVector3(0, SIZE_Y/2, 0));
         btScalar mass(0.0f);
         btVector3 localInertia(0, 0, 0);
-        physicsBody->mMotionState = std::make_unique<btDefaultMotionState>(terrainTransform);
+        physicsBody->mMotionState = physicsEngine.createMotionState(terrainTransform, *physicsBody);
         btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, &(*physicsBody->mMotionState), &(*physicsBody->mShape), localInertia);
         physicsBody->mRigidBody = std::make_unique<btRigidBody>(rbInfo);
         physicsEngine.mDynamicsWorld->addRigidBody(&(*physicsBody->mRigidBody));
+        physicsEngine.getVehicleGround().setTerrain(&(*physicsBody->mRigidBody), mHeightFieldQuery);
         addComponent(physicsBody);
 
         // Create terrain renderer
@@ -69,54 +69,42 @@ namespace Objects
         addComponent(terrainRenderer);
     }
 
-    Terrain::~Terrain()
-    {
-        delete [] mHeightData;
-    }
-
-    void Terrain::setup(std::shared_ptr<Assets::Shader> terrainShader)
+    void Terrain::load()
     {
         // ***** LOAD HEIGHTMAP *****
-        loadHeightMap(PROJECT_SOURCE_DIR "/Textures/HeightMaps/height_map1.png");
+        mHeightField = std::make_shared<Assets::HeightField>(
+            PROJECT_SOURCE_DIR "/Textures/HeightMaps/height_map1.png", false
+        );
+        mHeightFieldQuery = std::make_shared<Physics::HeightFieldQuery>(mHeightField, glm::vec3(SIZE_X, SIZE_Y, SIZE_Z));
 
         // ***** CREATE MATERIAL *****
         auto terrainMaterial = std::make_shared<Assets::Material>();
-        terrainMaterial->mGeometryShader = terrainShader;
         terrainMaterial->mAlbedoMap = std::make_shared<Assets::Texture>(
-            PROJECT_SOURCE_DIR "/Textures/Ground/rock2.jpg"
+            PROJECT_SOURCE_DIR "/Textures/Ground/rock2.jpg", false, false
         );
         terrainMaterial->mSpecularMap = std::make_shared<Assets::Texture>(
-            PROJECT_SOURCE_DIR "/Textures/Specular/dark_specular.jpg"
+            PROJECT_SOURCE_DIR "/Textures/Specular/dark_specular.jpg", false, false
         );
         terrainMaterial->mNormalMap = std::make_shared<Assets::Texture>(
-            PROJECT_SOURCE_DIR "/Textures/HeightMaps/height_map1_normal.png"
-        );
-        terrainMaterial->mHeightMap = std::make_shared<Assets::Texture>(
-            PROJECT_SOURCE_DIR "/Textures/HeightMaps/height_map1.png"
+            PROJECT_SOURCE_DIR "/Textures/HeightMaps/height_map1_normal.png", false, false
         );
+        terrainMaterial->mHeightMap = mHeightField;
         mMaterial = terrainMaterial;
     }
 
-    void Terrain::loadHeightMap(std::string heightMap)
+    void Terrain::setup(std::shared_ptr<Assets::Shader> terrainShader)
+    {
+        mMaterial->mGeometryShader = terrainShader;
+        mMaterial->upload();
+    }
+
+    float Terrain::getHeight(float x, float z)
     {
-        int nrChannels;
-        unsigned char *data = stbi_load(heightMap.c_str(), &mHeightmapWidth, &mHeightmapHeight, &nrChannels, 1);
-        if (data)
-        {
-            // Create Bullet terrain shape
-            mHeightData = (unsigned char *) malloc(mHeightmapHeight*mHeightmapWidth*1);
-            for (int i = 1; i < mHeightmapHeight; i++) {
-                for (int j = 1; j < mHeightmapWidth; j++) {
-                    mHeightData[i*mHeightmapWidth+j] = data[i*mHeightmapWidth+j];
-                }
-            }
+        return mHeightFieldQuery->getHeight(x, z);
+    }
 
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Texture failed to load at path: " << heightMap << std::endl;
-            stbi_image_free(data);
-        }
+    void Terrain::getHeights(float const *x, float const *z, int count, float *heights, glm::vec3 *normals)
+    {
+        mHeightFieldQuery->getHeights(x, z, count, heights, normals);
     }
 }
\ No newline at end of file
@@ -45,20 +45,19 @@ namespace Objects
         wallTransform.setIdentity();
         btScalar mass(0.0f);
         btVector3 localInertia(0, 0, 0);
-        physicsBody->mMotionState = std::make_unique<btDefaultMotionState>(wallTransform);
+        physicsBody->mMotionState = physicsEngine.createMotionState(wallTransform, *physicsBody);
         btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, &(*physicsBody->mMotionState), &(*physicsBody->mShape), localInertia);
         physicsBody->mRigidBody = std::make_unique<btRigidBody>(rbInfo);
         physicsEngine.mDynamicsWorld->addRigidBody(&(*physicsBody->mRigidBody));
         addComponent(physicsBody);
     }
 
-    void Wall::setup(std::shared_ptr<Assets::Shader> geometryShader, float trackInnerA, float trackInnerB, float trackOuterA, float trackOuterB)
+    void Wall::load(float trackInnerA, float trackInnerB, float trackOuterA, float trackOuterB)
     {
         // ***** CREATE MATERIAL *****
         auto wallMaterial = std::make_shared<Assets::Material>();
-        wallMaterial->mGeometryShader = geometryShader;
         wallMaterial->mAlbedoMap = std::make_shared<Assets::Texture>(
-            PROJECT_SOURCE_DIR "/Textures/Wall/logo.jpg", true
+            PROJECT_SOURCE_DIR "/Textures/Wall/logo.jpg", true, false
         );
         mMaterial = wallMaterial;
         
@@ -75,16 +74,26 @@ namespace Objects
             wallMeshCreator.addEllipticalSegment(firstS, secondS, trackInnerA, trackInnerB, theta0, theta, WALL_HEIGHT, WALL_DEPTH);
             theta0 = theta;
         }
-        mMesh = wallMeshCreator.create();
+        mMesh = wallMeshCreator.create(false);
 
         // ***** CREATE COLLIDER MESH *****
         mColliderMesh = std::make_shared<btTriangleMesh>(false, false);
-        for (int i = 0; i < mMesh->mVertices.size(); i+=3) {
+        // Cached meshes keep their data in the mapped file rather than the vectors
+        const Assets::Vertex *vertices = mMesh->getVertexData();
+        const unsigned int *indices = mMesh->getIndexData();
+        for (unsigned int i = 0; i < mMesh->getLod(0).mIndexCount; i+=3) {
             mColliderMesh->addTriangle(
-                Utils::TransformConversions::glmVec32btVector3(mMesh->mVertices[i].Position),
-                Utils::TransformConversions::glmVec32btVector3(mMesh->mVertices[i+1].Position),
-                Utils::TransformConversions::glmVec32btVector3(mMesh->mVertices[i+2].Position)
+                Utils::TransformConversions::glmVec32btVector3(vertices[indices[i]].Position),
+                Utils::TransformConversions::glmVec32btVector3(vertices[indices[i+1]].Position),
+                Utils::TransformConversions::glmVec32btVector3(vertices[indices[i+2]].Position)
             );
         }
     }
+
+    void Wall::setup(std::shared_ptr<Assets::Shader> geometryShader)
+    {
+        mMaterial->mGeometryShader = geometryShader;
+        mMaterial->upload();
+        mMesh->setupMesh();
+    }
 }
\ No newline at end of file
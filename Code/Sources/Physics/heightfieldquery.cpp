@@ -0,0 +1,135 @@
+#include "Physics/heightfieldquery.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HEIGHTFIELD_QUERY_SSE2
+#endif
+
+namespace Physics
+{
+    HeightFieldQuery::HeightFieldQuery(std::shared_ptr<Assets::HeightField> heightField, glm::vec3 size)
+      : mHeightField(heightField), mSize(size)
+    {
+      mSamplesPerX = (mHeightField->getWidth() - 1) / mSize.x;
+      mSamplesPerZ = (mHeightField->getLength() - 1) / mSize.z;
+      mHeightScale = mSize.y / 255.0f;
+    }
+
+    bool HeightFieldQuery::contains(float x, float z) const
+    {
+      // At least one cell is needed to interpolate
+      return mHeightField->getWidth() >= 2 && mHeightField->getLength() >= 2 &&
+             std::abs(x) <= mSize.x/2 && std::abs(z) <= mSize.z/2;
+    }
+
+    float HeightFieldQuery::getHeight(float x, float z, glm::vec3 *normal) const
+    {
+      int width = mHeightField->getWidth();
+      int length = mHeightField->getLength();
+      if (width < 2 || length < 2) {
+        if (normal) {
+          *normal = glm::vec3(0, 1, 0);
+        }
+        return 0.0f;
+      }
+
+      // Cell containing the position, clamped so the last row and column interpolate within the field
+      float gridX = std::min(std::max((x + mSize.x/2) * mSamplesPerX, 0.0f), (float) (width - 1));
+      float gridZ = std::min(std::max((z + mSize.z/2) * mSamplesPerZ, 0.0f), (float) (length - 1));
+      int x0 = std::min((int) gridX, width - 2);
+      int z0 = std::min((int) gridZ, length - 2);
+      float fx = gridX - x0;
+      float fz = gridZ - z0;
+
+      const unsigned char *row0 = mHeightField->getData() + z0*width + x0;
+      const unsigned char *row1 = row0 + width;
+      float h00 = row0[0], h10 = row0[1], h01 = row1[0], h11 = row1[1];
+      float h0 = h00 + (h10 - h00) * fx;
+      float h1 = h01 + (h11 - h01) * fx;
+
+      // Slopes of the bilinear patch, in world units
+      if (normal) {
+        float dhdx = ((h10 - h00) + ((h11 - h01) - (h10 - h00)) * fz) * mHeightScale * mSamplesPerX;
+        float dhdz = (h1 - h0) * mHeightScale * mSamplesPerZ;
+        *normal = glm::normalize(glm::vec3(-dhdx, 1.0f, -dhdz));
+      }
+      return (h0 + (h1 - h0) * fz) * mHeightScale;
+    }
+
+    void HeightFieldQuery::getHeights(float const *x, float const *z, int count, float *heights, glm::vec3 *normals) const
+    {
+      int i = 0;
+#ifdef HEIGHTFIELD_QUERY_SSE2
+      int width = mHeightField->getWidth();
+      int length = mHeightField->getLength();
+      if (width >= 2 && length >= 2) {
+        const unsigned char *data = mHeightField->getData();
+        __m128 zero = _mm_setzero_ps();
+        __m128 halfSizeX = _mm_set1_ps(mSize.x/2);
+        __m128 halfSizeZ = _mm_set1_ps(mSize.z/2);
+        __m128 samplesPerX = _mm_set1_ps(mSamplesPerX);
+        __m128 samplesPerZ = _mm_set1_ps(mSamplesPerZ);
+        __m128 maxGridX = _mm_set1_ps((float) (width - 1));
+        __m128 maxGridZ = _mm_set1_ps((float) (length - 1));
+        __m128 maxCellX = _mm_set1_ps((float) (width - 2));
+        __m128 maxCellZ = _mm_set1_ps((float) (length - 2));
+        __m128 rowStride = _mm_set1_ps((float) width);
+        __m128 heightScale = _mm_set1_ps(mHeightScale);
+
+        for (; i + 4 <= count; i += 4) {
+          // Cells are found with vector math; the four corner samples of each are gathered with scalar loads
+          __m128 gridX = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(x + i), halfSizeX), samplesPerX), zero), maxGridX);
+          __m128 gridZ = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(z + i), halfSizeZ), samplesPerZ), zero), maxGridZ);
+          __m128 x0 = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(gridX)), maxCellX);
+          __m128 z0 = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(gridZ)), maxCellZ);
+          __m128 fx = _mm_sub_ps(gridX, x0);
+          __m128 fz = _mm_sub_ps(gridZ, z0);
+
+          alignas(16) int offsets[4];
+          _mm_store_si128((__m128i *) offsets, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(z0, rowStride), x0)));
+          alignas(16) float corners[4][4];
+          for (int j = 0; j < 4; j++) {
+            const unsigned char *row0 = data + offsets[j];
+            corners[0][j] = row0[0];
+            corners[1][j] = row0[1];
+            corners[2][j] = row0[width];
+            corners[3][j] = row0[width + 1];
+          }
+          __m128 h00 = _mm_load_ps(corners[0]);
+          __m128 h10 = _mm_load_ps(corners[1]);
+          __m128 h01 = _mm_load_ps(corners[2]);
+          __m128 h11 = _mm_load_ps(corners[3]);
+
+          __m128 dx0 = _mm_sub_ps(h10, h00);
+          __m128 dx1 = _mm_sub_ps(h11, h01);
+          __m128 h0 = _mm_add_ps(h00, _mm_mul_ps(dx0, fx));
+          __m128 h1 = _mm_add_ps(h01, _mm_mul_ps(dx1, fx));
+          __m128 dz = _mm_sub_ps(h1, h0);
+          _mm_storeu_ps(heights + i, _mm_mul_ps(_mm_add_ps(h0, _mm_mul_ps(dz, fz)), heightScale));
+
+          if (normals) {
+            __m128 dhdx = _mm_mul_ps(_mm_add_ps(dx0, _mm_mul_ps(_mm_sub_ps(dx1, dx0), fz)), _mm_mul_ps(heightScale, samplesPerX));
+            __m128 dhdz = _mm_mul_ps(dz, _mm_mul_ps(heightScale, samplesPerZ));
+            __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dhdx, dhdx), _mm_mul_ps(dhdz, dhdz)), _mm_set1_ps(1.0f));
+            __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+            alignas(16) float normalX[4], normalY[4], normalZ[4];
+            _mm_store_ps(normalX, _mm_mul_ps(_mm_sub_ps(zero, dhdx), inverseLength));
+            _mm_store_ps(normalY, inverseLength);
+            _mm_store_ps(normalZ, _mm_mul_ps(_mm_sub_ps(zero, dhdz), inverseLength));
+            for (int j = 0; j < 4; j++) {
+              normals[i + j] = glm::vec3(normalX[j], normalY[j], normalZ[j]);
+            }
+          }
+        }
+      }
+#endif
+
+      // Remaining positions, or all of them without SSE2
+      for (; i < count; i++) {
+        heights[i] = getHeight(x[i], z[i], normals ? &normals[i] : nullptr);
+      }
+    }
+}
@@ -0,0 +1,36 @@
+#include "Physics/motionstate.hpp"
+
+namespace Physics
+{
+    MotionState::MotionState(btTransform const &startTransform, Components::PhysicsBody &physicsBody, MovedBodies &movedBodies)
+      : mTransform(startTransform), mPreviousTransform(startTransform), mMovedTick(0),
+        mPhysicsBody(physicsBody), mMovedBodies(movedBodies)
+    {
+    }
+
+    MotionState::~MotionState()
+    {
+    }
+
+    void MotionState::getWorldTransform(btTransform &worldTransform) const
+    {
+      worldTransform = mTransform;
+    }
+
+    void MotionState::setWorldTransform(btTransform const &worldTransform)
+    {
+      // The first report in a tick is where the body was before it
+      if (mMovedTick != mMovedBodies.mTick) {
+        mMovedTick = mMovedBodies.mTick;
+        mPreviousTransform = mTransform;
+        mMovedBodies.mBodies.push_back(&mPhysicsBody);
+      }
+      mTransform = worldTransform;
+    }
+
+    void MotionState::teleport(btTransform const &worldTransform)
+    {
+      mTransform = worldTransform;
+      mPreviousTransform = worldTransform;
+    }
+}
@@ -0,0 +1,88 @@
+#include "Physics/physicsbenchmark.hpp"
+#include "Physics/physicsengine.hpp"
+
+#include <bullet/btBulletDynamicsCommon.h>
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace Physics
+{
+    const int STACK_HEIGHT = 5;
+    const float STACK_SPACING = 3.0f;
+    const float BOX_HALF_EXTENT = 0.5f;
+    // Ticks run before timing starts, while the stacks land and settle into contact
+    const int WARMUP_TICKS = 30;
+
+    void PhysicsBenchmark::run(std::vector<int> const &bodyCounts, std::vector<int> const &threadCounts, int numTicks)
+    {
+      std::cout << "Physics benchmark, ms per tick over " << numTicks << " ticks" << std::endl;
+      std::cout << std::setw(8) << "bodies";
+      for (int numThreads : threadCounts) {
+        std::cout << std::setw(12) << (std::to_string(numThreads) + " threads");
+      }
+      std::cout << std::endl;
+
+      for (int bodyCount : bodyCounts) {
+        std::cout << std::setw(8) << bodyCount;
+        for (int numThreads : threadCounts) {
+          std::cout << std::setw(12) << std::fixed << std::setprecision(3) << measure(bodyCount, numThreads, numTicks) << std::flush;
+        }
+        std::cout << std::endl;
+      }
+    }
+
+    double PhysicsBenchmark::measure(int bodyCount, int numThreads, int numTicks)
+    {
+      PhysicsEngine physicsEngine(numThreads);
+      auto &dynamicsWorld = *physicsEngine.mDynamicsWorld;
+      dynamicsWorld.setGravity(btVector3(0, -9.81f, 0));
+
+      // Static ground under the whole grid
+      int numStacks = (bodyCount + STACK_HEIGHT - 1) / STACK_HEIGHT;
+      int gridSize = (int) std::ceil(std::sqrt((float) numStacks));
+      float gridExtent = gridSize * STACK_SPACING;
+      btBoxShape groundShape(btVector3(gridExtent, 1.0f, gridExtent));
+      btDefaultMotionState groundMotionState(btTransform(btQuaternion(0, 0, 0, 1), btVector3(0, -1.0f, 0)));
+      btRigidBody ground(btRigidBody::btRigidBodyConstructionInfo(0.0f, &groundMotionState, &groundShape));
+      dynamicsWorld.addRigidBody(&ground);
+
+      // Stacks far enough apart that each forms its own simulation island
+      btBoxShape boxShape(btVector3(BOX_HALF_EXTENT, BOX_HALF_EXTENT, BOX_HALF_EXTENT));
+      btVector3 localInertia(0, 0, 0);
+      boxShape.calculateLocalInertia(1.0f, localInertia);
+      std::vector<std::unique_ptr<btDefaultMotionState>> motionStates;
+      std::vector<std::unique_ptr<btRigidBody>> bodies;
+      for (int i = 0; i < bodyCount; i++) {
+        int stack = i / STACK_HEIGHT;
+        btVector3 position(
+          (stack % gridSize - gridSize/2.0f) * STACK_SPACING,
+          BOX_HALF_EXTENT + (i % STACK_HEIGHT) * (2*BOX_HALF_EXTENT + 0.05f),
+          (stack / gridSize - gridSize/2.0f) * STACK_SPACING);
+        motionStates.push_back(std::make_unique<btDefaultMotionState>(btTransform(btQuaternion(0, 0, 0, 1), position)));
+        btRigidBody::btRigidBodyConstructionInfo rbInfo(1.0f, &(*motionStates.back()), &boxShape, localInertia);
+        bodies.push_back(std::make_unique<btRigidBody>(rbInfo));
+        dynamicsWorld.addRigidBody(&(*bodies.back()));
+      }
+
+      float tickLength = 1.0f / 60.0f;
+      for (int i = 0; i < WARMUP_TICKS; i++) {
+        dynamicsWorld.stepSimulation(tickLength, 1, tickLength);
+      }
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < numTicks; i++) {
+        dynamicsWorld.stepSimulation(tickLength, 1, tickLength);
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      // Bodies must leave the world before it is destroyed
+      for (auto &body : bodies) {
+        dynamicsWorld.removeRigidBody(&(*body));
+      }
+      dynamicsWorld.removeRigidBody(&ground);
+      return seconds * 1000.0 / numTicks;
+    }
+}
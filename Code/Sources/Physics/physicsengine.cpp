@@ -1,30 +1,139 @@
 #include "Physics/physicsengine.hpp"
+#include "Physics/vehicleraycaster.hpp"
 #include "Components/physicsbody.hpp"
 #include "Components/carphysicsbody.hpp"
-#include "Components/wheelmeshrenderer.hpp"
 #include "Utils/transformconversions.hpp"
 #include "Utils/logger.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
+#if BT_THREADSAFE
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#endif
 
+#include <algorithm>
 #include <iostream>
+#include <unordered_map>
+
+// Vehicles updated per job; each update casts one ray per wheel
+const int VEHICLE_BATCH_SIZE = 16;
+
+namespace
+{
+  // Components are written one at a time, leaving out the padding of Bullet's vectors, so restores are exact
+  void saveVector(Core::StateWriter &writer, btVector3 const &vector)
+  {
+    writer.write(vector.x());
+    writer.write(vector.y());
+    writer.write(vector.z());
+  }
+
+  btVector3 loadVector(Core::StateReader &reader)
+  {
+    btScalar x = reader.read<btScalar>();
+    btScalar y = reader.read<btScalar>();
+    btScalar z = reader.read<btScalar>();
+    return btVector3(x, y, z);
+  }
+
+  void saveTransform(Core::StateWriter &writer, btTransform const &transform)
+  {
+    for (int i = 0; i < 3; i++) {
+      saveVector(writer, transform.getBasis()[i]);
+    }
+    saveVector(writer, transform.getOrigin());
+  }
+
+  btTransform loadTransform(Core::StateReader &reader)
+  {
+    btTransform transform;
+    for (int i = 0; i < 3; i++) {
+      transform.getBasis()[i] = loadVector(reader);
+    }
+    transform.setOrigin(loadVector(reader));
+    return transform;
+  }
+}
 
 namespace Physics
 {
-    PhysicsEngine::PhysicsEngine()
+    namespace
     {
+      class VehicleUpdate : public btIParallelForBody
+      {
+      public:
+        VehicleUpdate(std::vector<Components::CarPhysicsBody *> const &carPhysicsBodies, btScalar timeStep)
+          : mCarPhysicsBodies(carPhysicsBodies), mTimeStep(timeStep)
+        {
+        }
+
+        virtual void forLoop(int iBegin, int iEnd) const override
+        {
+          // A vehicle only applies impulses to its own chassis, so batches share nothing but read-only ray casts
+          for (int i = iBegin; i < iEnd; i++) {
+            mCarPhysicsBodies[i]->mVehicle->updateVehicle(mTimeStep);
+          }
+        }
+
+      private:
+        std::vector<Components::CarPhysicsBody *> const &mCarPhysicsBodies;
+        btScalar mTimeStep;
+      };
+    }
+
+    PhysicsEngine::PhysicsEngine(int numThreads)
+      : mTickCount(0)
+    {
+      mMovedBodies = std::make_unique<MovedBodies>();
+      mVehicleGround = std::make_unique<VehicleGround>();
+      mSimulationLod = std::make_unique<SimulationLod>();
       mCollisionConfiguration = std::make_unique<btDefaultCollisionConfiguration>();
-      mDispatcher = std::make_unique<btCollisionDispatcher>(&(*mCollisionConfiguration));
       mOverlappingPairCache = std::make_unique<btDbvtBroadphase>();
-      mSolver = std::make_unique<btSequentialImpulseConstraintSolver>();
-      mDynamicsWorld = std::make_unique<btDiscreteDynamicsWorld>(&(*mDispatcher), &(*mOverlappingPairCache), &(*mSolver), &(*mCollisionConfiguration));
+
+#if BT_THREADSAFE
+      if (numThreads > 1) {
+        // Bullet runs its parallel loops on whichever scheduler is set; this must happen on the stepping thread
+        mTaskScheduler = std::make_unique<TaskScheduler>(numThreads);
+        btSetTaskScheduler(&(*mTaskScheduler));
+
+        // Narrowphase, island solving and integration are split across the scheduler's threads
+        mDispatcher = std::make_unique<btCollisionDispatcherMt>(&(*mCollisionConfiguration));
+        mSolverPool = std::make_unique<btConstraintSolverPoolMt>(mTaskScheduler->getNumThreads());
+        mSolver = std::make_unique<btSequentialImpulseConstraintSolverMt>();
+        mDynamicsWorld = std::make_unique<btDiscreteDynamicsWorldMt>(
+          &(*mDispatcher), &(*mOverlappingPairCache), static_cast<btConstraintSolverPoolMt *>(&(*mSolverPool)),
+          &(*mSolver), &(*mCollisionConfiguration));
+      }
+#else
+      if (numThreads > 1) {
+        std::cout << "Bullet was built without BT_THREADSAFE; stepping physics on one thread" << std::endl;
+      }
+#endif
+
+      if (!mDynamicsWorld) {
+        mDispatcher = std::make_unique<btCollisionDispatcher>(&(*mCollisionConfiguration));
+        mSolver = std::make_unique<btSequentialImpulseConstraintSolver>();
+        mDynamicsWorld = std::make_unique<btDiscreteDynamicsWorld>(&(*mDispatcher), &(*mOverlappingPairCache), &(*mSolver), &(*mCollisionConfiguration));
+      }
+      mDynamicsWorld->setInternalTickCallback(&PhysicsEngine::vehicleTickCallback, this);
     }
 
     PhysicsEngine::~PhysicsEngine()
     {
+      // The world may still run loops on the scheduler while it is torn down
+      mDynamicsWorld.reset();
+      if (mTaskScheduler) {
+        btSetTaskScheduler(btGetSequentialTaskScheduler());
+      }
+    }
+
+    int PhysicsEngine::getNumThreads() const
+    {
+      return mTaskScheduler ? mTaskScheduler->getNumThreads() : 1;
     }
 
-    void PhysicsEngine::updateScene(Core::Scene const &scene, double deltaTime)
+    void PhysicsEngine::updateScene(Core::Scene const &scene, double tickLength)
     {
       // ***** UPDATE DIRTY TRANSFORMS *****
       for (auto &gameObject : scene.mGameObjects) {
@@ -32,46 +141,109 @@ namespace Physics
       }
 
       // ***** STEP SCENE *****
-      mDynamicsWorld->stepSimulation((float) deltaTime, 5);
-
-      // ***** DEBUGGING ****
-      mDynamicsWorld->debugDrawWorld();
+      // Bodies report themselves through their motion states as Bullet moves them
+      gatherVehicles(scene);
+      mSimulationLod->update(mCarPhysicsBodies, *mDynamicsWorld, mVehicleGround->getHeightFieldQuery());
+      mDynamicCarPhysicsBodies.clear();
+      for (auto carPhysicsBody : mCarPhysicsBodies) {
+        if (!carPhysicsBody->mKinematic) {
+          mDynamicCarPhysicsBodies.push_back(carPhysicsBody);
+        }
+      }
+      mVehicleGround->update(*mDynamicsWorld);
+      mPreviouslyMovedBodies.swap(mMovedBodies->mBodies);
+      mMovedBodies->mBodies.clear();
+      mMovedBodies->mTick = ++mTickCount;
+      mDynamicsWorld->stepSimulation((float) tickLength, 1, (float) tickLength);
+      // Cars following their paths only exist in the world once they return to full dynamics
+      if (mDynamicCarPhysicsBodies.size() != mCarPhysicsBodies.size()) {
+        mSimulationLod->advance(mCarPhysicsBodies, *mVehicleGround->getHeightFieldQuery(), (float) tickLength);
+      }
 
       // ***** UPDATE TRANSFORMS ****
-      // Generic physics bodies
-      for (auto &physicsBody : scene.getComponents<Components::PhysicsBody>()) {
-        auto physicsBodyTransform = physicsBody->mRigidBody->getWorldTransform();
-        auto gameObjectTransform = physicsBody->mGameObject.mTransform;
+      // Bodies that came to rest are posed at their final transform once, and then left alone
+      for (auto physicsBody : mPreviouslyMovedBodies) {
+        if (physicsBody->mMotionState->getMovedTick() != mTickCount) {
+          physicsBody->mMotionState->settle();
+          writeTransform(*physicsBody, physicsBody->mMotionState->getTransform());
+        }
+      }
+      interpolateTransforms(1.0f);
+    }
 
-        gameObjectTransform->mTranslation = Utils::TransformConversions::btVector32glmVec3(physicsBodyTransform.getOrigin());
-        gameObjectTransform->mRotation = Utils::TransformConversions::btQuaternion2glmQuat(physicsBodyTransform.getRotation());
+    void PhysicsEngine::gatherVehicles(Core::Scene const &scene)
+    {
+      // Wheels are updated before Bullet reports the chassis, so they are recorded up front
+      mCarPhysicsBodies.clear();
+      for (auto &carPhysicsBody : scene.getComponents<Components::CarPhysicsBody>()) {
+        for (int i = 0; i < 4; i++) {
+          carPhysicsBody->mPreviousWheelTransforms[i] = carPhysicsBody->mVehicle->getWheelInfo(i).m_worldTransform;
+        }
+        mCarPhysicsBodies.push_back(&(*carPhysicsBody));
+      }
+    }
 
-        btScalar transform[16];
-        physicsBodyTransform.getOpenGLMatrix(transform);
-        glm::mat4 translateRotateMtx = Utils::TransformConversions::btScalar2glmMat4(transform);
-        glm::mat4 scaleMtx = glm::scale(glm::mat4(1), gameObjectTransform->mScale);
-        gameObjectTransform->mModelMatrix = translateRotateMtx * scaleMtx;
+    void PhysicsEngine::vehicleTickCallback(btDynamicsWorld *dynamicsWorld, btScalar timeStep)
+    {
+      static_cast<PhysicsEngine *>(dynamicsWorld->getWorldUserInfo())->updateVehicles(timeStep);
+    }
 
-        for (auto &gameObject : physicsBody->mGameObject.mChildren) {
-          updateDirtyTransforms(gameObject, gameObjectTransform->mModelMatrix, true);
-        }
+    void PhysicsEngine::updateVehicles(btScalar timeStep)
+    {
+      // Runs on the task scheduler of a multithreaded world, and inline otherwise
+      btParallelFor(0, (int) mDynamicCarPhysicsBodies.size(), VEHICLE_BATCH_SIZE, VehicleUpdate(mDynamicCarPhysicsBodies, timeStep));
+    }
+
+    void PhysicsEngine::interpolateTransforms(float interpolationFactor)
+    {
+      // Until two ticks have run there is no earlier state to start from
+      if (mTickCount < 2) {
+        interpolationFactor = 1.0f;
       }
+      auto interpolate = [interpolationFactor](btTransform const &previous, btTransform const &current) {
+        return btTransform(slerp(previous.getRotation(), current.getRotation(), interpolationFactor),
+                           previous.getOrigin().lerp(current.getOrigin(), interpolationFactor));
+      };
 
-      // Car physics bodies
-      for (auto &carPhysicsBody : scene.getComponents<Components::CarPhysicsBody>()) {
+      // Generic physics bodies; only those the latest tick moved are in motion
+      for (auto physicsBody : mMovedBodies->mBodies) {
+        auto &motionState = *physicsBody->mMotionState;
+        writeTransform(*physicsBody, interpolate(motionState.getPreviousTransform(), motionState.getTransform()));
+      }
+
+      // Wheels of each vehicle
+      for (auto carPhysicsBody : mCarPhysicsBodies) {
         auto gameObjectTransform = carPhysicsBody->mGameObject.mTransform;
-        auto wheelMeshRenderer = scene.getComponents<Components::WheelMeshRenderer>()[0];
 
         for (int i = 0; i < 4; i++) {
           btScalar wheelTransform[16];
-          carPhysicsBody->mVehicle->getWheelInfo(i).m_worldTransform.getOpenGLMatrix(wheelTransform);
+          interpolate(carPhysicsBody->mPreviousWheelTransforms[i],
+                      carPhysicsBody->mVehicle->getWheelInfo(i).m_worldTransform).getOpenGLMatrix(wheelTransform);
           glm::mat4 translateRotateMtx = Utils::TransformConversions::btScalar2glmMat4(wheelTransform);
           glm::mat4 scaleMtx = glm::scale(glm::mat4(1), gameObjectTransform->mScale);
-          wheelMeshRenderer->mWheelModelMatrices[i] = translateRotateMtx * scaleMtx;
+          carPhysicsBody->mWheelModelMatrices[i] = translateRotateMtx * scaleMtx;
         }
       }
     }
 
+    void PhysicsEngine::writeTransform(Components::PhysicsBody &physicsBody, btTransform const &physicsBodyTransform)
+    {
+      auto gameObjectTransform = physicsBody.mGameObject.mTransform;
+
+      gameObjectTransform->mTranslation = Utils::TransformConversions::btVector32glmVec3(physicsBodyTransform.getOrigin());
+      gameObjectTransform->mRotation = Utils::TransformConversions::btQuaternion2glmQuat(physicsBodyTransform.getRotation());
+
+      btScalar transform[16];
+      physicsBodyTransform.getOpenGLMatrix(transform);
+      glm::mat4 translateRotateMtx = Utils::TransformConversions::btScalar2glmMat4(transform);
+      glm::mat4 scaleMtx = glm::scale(glm::mat4(1), gameObjectTransform->mScale);
+      gameObjectTransform->mModelMatrix = translateRotateMtx * scaleMtx;
+
+      for (auto &gameObject : physicsBody.mGameObject.mChildren) {
+        updateDirtyTransforms(gameObject, gameObjectTransform->mModelMatrix, true);
+      }
+    }
+
     void PhysicsEngine::updateDirtyTransforms(std::shared_ptr<Core::GameObject> gameObject, glm::mat4 matrix, bool parentDirty)
     {
       // Update model matrix and physics bodies
@@ -85,6 +257,7 @@ namespace Physics
             Utils::TransformConversions::glmQuat2btQuaternion(gameObject->mTransform->mRotation));
           physicsBody->mRigidBody->getWorldTransform().setOrigin(
             Utils::TransformConversions::glmVec32btVector3(gameObject->mTransform->getWorldTranslation()));
+          physicsBody->mMotionState->teleport(physicsBody->mRigidBody->getWorldTransform());
         }
       }
 
@@ -94,8 +267,177 @@ namespace Physics
       }
     }
 
+    void PhysicsEngine::saveState(Core::Scene const &scene, Core::StateWriter &writer) const
+    {
+      writer.write(mTickCount);
+
+      // Static bodies never change
+      for (auto &physicsBody : scene.getComponents<Components::PhysicsBody>()) {
+        auto &rigidBody = *physicsBody->mRigidBody;
+        if (rigidBody.isStaticObject()) {
+          continue;
+        }
+        saveTransform(writer, rigidBody.getCenterOfMassTransform());
+        saveVector(writer, rigidBody.getLinearVelocity());
+        saveVector(writer, rigidBody.getAngularVelocity());
+        writer.write(rigidBody.getActivationState());
+        writer.write(rigidBody.getDeactivationTime());
+      }
+
+      // Controls and wheel state carried from one tick to the next; contacts are cast afresh each tick, but
+      // the simulation LOD reads them before that
+      for (auto &carPhysicsBody : scene.getComponents<Components::CarPhysicsBody>()) {
+        writer.write(carPhysicsBody->mKinematic);
+        writer.write(carPhysicsBody->mPathDistance);
+        writer.write(carPhysicsBody->mPathSpeed);
+        writer.write(carPhysicsBody->mLaneOffset);
+        writer.write(carPhysicsBody->mRideHeight);
+        writer.write(carPhysicsBody->mSteering);
+        auto &vehicle = *carPhysicsBody->mVehicle;
+        for (int i = 0; i < vehicle.getNumWheels(); i++) {
+          btWheelInfo const &wheel = vehicle.getWheelInfo(i);
+          writer.write(wheel.m_steering);
+          writer.write(wheel.m_engineForce);
+          writer.write(wheel.m_brake);
+          writer.write(wheel.m_rotation);
+          writer.write(wheel.m_deltaRotation);
+          writer.write(wheel.m_raycastInfo.m_suspensionLength);
+          writer.write(wheel.m_raycastInfo.m_isInContact);
+          saveTransform(writer, wheel.m_worldTransform);
+        }
+      }
+    }
+
+    void PhysicsEngine::loadState(Core::Scene const &scene, Core::StateReader &reader)
+    {
+      reader.read(mTickCount);
+
+      for (auto &physicsBody : scene.getComponents<Components::PhysicsBody>()) {
+        auto &rigidBody = *physicsBody->mRigidBody;
+        if (rigidBody.isStaticObject()) {
+          continue;
+        }
+        btTransform transform = loadTransform(reader);
+        rigidBody.setCenterOfMassTransform(transform);
+        rigidBody.setLinearVelocity(loadVector(reader));
+        rigidBody.setAngularVelocity(loadVector(reader));
+        rigidBody.setInterpolationLinearVelocity(rigidBody.getLinearVelocity());
+        rigidBody.setInterpolationAngularVelocity(rigidBody.getAngularVelocity());
+        rigidBody.clearForces();
+        rigidBody.forceActivationState(reader.read<int>());
+        rigidBody.setDeactivationTime(reader.read<btScalar>());
+        physicsBody->mMotionState->teleport(transform);
+      }
+
+      for (auto &carPhysicsBody : scene.getComponents<Components::CarPhysicsBody>()) {
+        // Cars following their paths are out of the world
+        bool kinematic = reader.read<bool>();
+        if (kinematic != carPhysicsBody->mKinematic) {
+          if (kinematic) {
+            mDynamicsWorld->removeRigidBody(&(*carPhysicsBody->mRigidBody));
+          }
+          else {
+            mDynamicsWorld->addRigidBody(&(*carPhysicsBody->mRigidBody));
+          }
+          carPhysicsBody->mKinematic = kinematic;
+        }
+        reader.read(carPhysicsBody->mPathDistance);
+        reader.read(carPhysicsBody->mPathSpeed);
+        reader.read(carPhysicsBody->mLaneOffset);
+        reader.read(carPhysicsBody->mRideHeight);
+        reader.read(carPhysicsBody->mSteering);
+        auto &vehicle = *carPhysicsBody->mVehicle;
+        for (int i = 0; i < vehicle.getNumWheels(); i++) {
+          btWheelInfo &wheel = vehicle.getWheelInfo(i);
+          reader.read(wheel.m_steering);
+          reader.read(wheel.m_engineForce);
+          reader.read(wheel.m_brake);
+          reader.read(wheel.m_rotation);
+          reader.read(wheel.m_deltaRotation);
+          reader.read(wheel.m_raycastInfo.m_suspensionLength);
+          reader.read(wheel.m_raycastInfo.m_isInContact);
+          wheel.m_worldTransform = loadTransform(reader);
+          carPhysicsBody->mPreviousWheelTransforms[i] = wheel.m_worldTransform;
+        }
+      }
+
+      // Nothing has moved since the restore, so nothing interpolates
+      mMovedBodies->mBodies.clear();
+      mPreviouslyMovedBodies.clear();
+      for (auto &physicsBody : scene.getComponents<Components::PhysicsBody>()) {
+        if (!physicsBody->mRigidBody->isStaticObject()) {
+          writeTransform(*physicsBody, physicsBody->mMotionState->getTransform());
+        }
+      }
+      interpolateTransforms(1.0f);
+      resetCollisionState(scene);
+    }
+
+    void PhysicsEngine::resetCollisionState(Core::Scene const &scene)
+    {
+      // Scene bodies first, in the order they were added, then anything else in the world's order
+      std::unordered_map<btCollisionObject const *, int> sceneOrder;
+      for (auto &physicsBody : scene.getComponents<Components::PhysicsBody>()) {
+        sceneOrder.insert(std::make_pair(&(*physicsBody->mRigidBody), (int) sceneOrder.size()));
+      }
+      struct WorldObject
+      {
+        btCollisionObject *mObject;
+        int mGroup;
+        int mMask;
+        int mOrder;
+      };
+      std::vector<WorldObject> worldObjects;
+      auto &collisionObjects = mDynamicsWorld->getCollisionObjectArray();
+      for (int i = 0; i < collisionObjects.size(); i++) {
+        auto collisionObject = collisionObjects[i];
+        auto order = sceneOrder.find(collisionObject);
+        auto handle = collisionObject->getBroadphaseHandle();
+        worldObjects.push_back({ collisionObject, handle->m_collisionFilterGroup, handle->m_collisionFilterMask,
+                                 order != sceneOrder.end() ? order->second : (int) sceneOrder.size() + i });
+      }
+      std::sort(worldObjects.begin(), worldObjects.end(), [](WorldObject const &a, WorldObject const &b) {
+        return a.mOrder < b.mOrder;
+      });
+
+      // An empty broadphase starts over completely, dropping its tree, pairs and contact manifolds
+      for (auto &worldObject : worldObjects) {
+        mDynamicsWorld->removeCollisionObject(worldObject.mObject);
+      }
+      mOverlappingPairCache->resetPool(&(*mDispatcher));
+      for (auto &worldObject : worldObjects) {
+        btRigidBody *rigidBody = btRigidBody::upcast(worldObject.mObject);
+        if (rigidBody) {
+          mDynamicsWorld->addRigidBody(rigidBody, worldObject.mGroup, worldObject.mMask);
+        }
+        else {
+          mDynamicsWorld->addCollisionObject(worldObject.mObject, worldObject.mGroup, worldObject.mMask);
+        }
+      }
+    }
+
     void PhysicsEngine::connectDebugRenderer(btIDebugDraw *debugRenderer)
     {
       mDynamicsWorld->setDebugDrawer(debugRenderer);
     }
+
+    std::unique_ptr<MotionState> PhysicsEngine::createMotionState(btTransform const &startTransform, Components::PhysicsBody &physicsBody) const
+    {
+      return std::make_unique<MotionState>(startTransform, physicsBody, *mMovedBodies);
+    }
+
+    std::unique_ptr<btVehicleRaycaster> PhysicsEngine::createVehicleRaycaster() const
+    {
+      return std::make_unique<VehicleRaycaster>(&(*mDynamicsWorld), *mVehicleGround);
+    }
+
+    void PhysicsEngine::drawDebugWorld()
+    {
+      // Once per rendered frame, since the renderer clears the lines after drawing them
+      mDynamicsWorld->debugDrawWorld();
+      // Vehicles are not world actions, so the world does not draw them
+      for (auto carPhysicsBody : mDynamicCarPhysicsBodies) {
+        carPhysicsBody->mVehicle->debugDraw(mDynamicsWorld->getDebugDrawer());
+      }
+    }
 }
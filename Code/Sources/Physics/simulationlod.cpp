@@ -0,0 +1,208 @@
+#include "Physics/simulationlod.hpp"
+#include "Components/carphysicsbody.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Cars within this distance of the player run full dynamics, and those beyond the second may follow their paths;
+// the gap keeps a car on the boundary from switching every tick
+const float DYNAMIC_RADIUS = 25.0f;
+const float KINEMATIC_RADIUS = 35.0f;
+// Likewise for the distance between two cars, below which they may collide
+const float DYNAMIC_SEPARATION = 2.0f;
+const float KINEMATIC_SEPARATION = 3.0f;
+// Cosine of the largest angle between a car's heading and its path at which it hands over without turning
+const float HEADING_ALIGNMENT = 0.95f;
+
+namespace Physics
+{
+    SimulationLod::SimulationLod()
+    {
+    }
+
+    SimulationLod::~SimulationLod()
+    {
+    }
+
+    void SimulationLod::update(std::vector<Components::CarPhysicsBody *> const &carPhysicsBodies, btDynamicsWorld &dynamicsWorld,
+                               HeightFieldQuery const *heightFieldQuery)
+    {
+      mPositions.clear();
+      mCells.clear();
+      mFoci.clear();
+      for (size_t i = 0; i < carPhysicsBodies.size(); i++) {
+        auto carPhysicsBody = carPhysicsBodies[i];
+        btVector3 origin = carPhysicsBody->mRigidBody->getCenterOfMassPosition();
+        glm::vec2 position(origin.x(), origin.z());
+        mPositions.push_back(position);
+        mCells.push_back(std::make_pair(getCellKey(position), i));
+        if (!carPhysicsBody->mTrackPath) {
+          mFoci.push_back(position);
+        }
+      }
+      // Cars close enough to collide share a cell or neighbour one
+      std::sort(mCells.begin(), mCells.end());
+
+      for (size_t i = 0; i < carPhysicsBodies.size(); i++) {
+        auto carPhysicsBody = carPhysicsBodies[i];
+        if (!carPhysicsBody->mTrackPath) {
+          continue;
+        }
+
+        float focusDistance2 = INFINITY;
+        for (auto &focus : mFoci) {
+          glm::vec2 offset = mPositions[i] - focus;
+          focusDistance2 = std::min(focusDistance2, glm::dot(offset, offset));
+        }
+        float carDistance2 = getNearestCarDistance2(i);
+
+        if (carPhysicsBody->mKinematic) {
+          if (focusDistance2 < DYNAMIC_RADIUS*DYNAMIC_RADIUS || carDistance2 < DYNAMIC_SEPARATION*DYNAMIC_SEPARATION) {
+            makeDynamic(*carPhysicsBody, dynamicsWorld);
+          }
+        }
+        else if (focusDistance2 > KINEMATIC_RADIUS*KINEMATIC_RADIUS && carDistance2 > KINEMATIC_SEPARATION*KINEMATIC_SEPARATION &&
+                 canFollowPath(*carPhysicsBody, heightFieldQuery)) {
+          makeKinematic(*carPhysicsBody, dynamicsWorld, *heightFieldQuery);
+        }
+      }
+    }
+
+    void SimulationLod::advance(std::vector<Components::CarPhysicsBody *> const &carPhysicsBodies, HeightFieldQuery const &heightFieldQuery,
+                                float tickLength)
+    {
+      // Stopped cars stay where they are and come to rest like any other body
+      mKinematicCars.clear();
+      mX.clear();
+      mZ.clear();
+      for (auto carPhysicsBody : carPhysicsBodies) {
+        if (!carPhysicsBody->mKinematic || carPhysicsBody->mPathSpeed == 0.0f) {
+          continue;
+        }
+        auto &trackPath = *carPhysicsBody->mTrackPath;
+        carPhysicsBody->mPathDistance = std::fmod(carPhysicsBody->mPathDistance + carPhysicsBody->mPathSpeed*tickLength, trackPath.getLength());
+        if (carPhysicsBody->mPathDistance < 0.0f) {
+          carPhysicsBody->mPathDistance += trackPath.getLength();
+        }
+        glm::vec2 position = trackPath.getPosition(carPhysicsBody->mPathDistance) +
+                             trackPath.getLateral(carPhysicsBody->mPathDistance)*carPhysicsBody->mLaneOffset;
+        mKinematicCars.push_back(carPhysicsBody);
+        mX.push_back(position.x);
+        mZ.push_back(position.y);
+      }
+
+      // Terrain beneath every moving car in one batch
+      mHeights.resize(mKinematicCars.size());
+      mNormals.resize(mKinematicCars.size());
+      heightFieldQuery.getHeights(mX.data(), mZ.data(), mKinematicCars.size(), mHeights.data(), mNormals.data());
+
+      for (size_t i = 0; i < mKinematicCars.size(); i++) {
+        auto carPhysicsBody = mKinematicCars[i];
+        glm::vec2 tangent = carPhysicsBody->mTrackPath->getTangent(carPhysicsBody->mPathDistance);
+
+        // Chassis sits on the terrain, facing along the path
+        glm::vec3 up = mNormals[i];
+        glm::vec3 forward = glm::normalize(glm::vec3(tangent.x, 0, tangent.y) - up*glm::dot(glm::vec3(tangent.x, 0, tangent.y), up));
+        glm::vec3 left = glm::cross(up, forward);
+        btMatrix3x3 basis(left.x, up.x, forward.x,
+                          left.y, up.y, forward.y,
+                          left.z, up.z, forward.z);
+        btTransform transform(basis, btVector3(mX[i], mHeights[i] + carPhysicsBody->mRideHeight, mZ[i]));
+
+        // Reporting through the motion state keeps the car interpolated like a simulated body
+        carPhysicsBody->mRigidBody->setCenterOfMassTransform(transform);
+        carPhysicsBody->mMotionState->setWorldTransform(transform);
+
+        // Wheels roll with the distance covered, at the suspension length they had on handover
+        auto &vehicle = *carPhysicsBody->mVehicle;
+        for (int j = 0; j < vehicle.getNumWheels(); j++) {
+          btWheelInfo &wheel = vehicle.getWheelInfo(j);
+          wheel.m_deltaRotation = carPhysicsBody->mPathSpeed*tickLength / wheel.m_wheelsRadius;
+          wheel.m_rotation += wheel.m_deltaRotation;
+          vehicle.updateWheelTransform(j, false);
+        }
+      }
+    }
+
+    bool SimulationLod::canFollowPath(Components::CarPhysicsBody &carPhysicsBody, HeightFieldQuery const *heightFieldQuery) const
+    {
+      btVector3 origin = carPhysicsBody.mRigidBody->getCenterOfMassPosition();
+      if (!heightFieldQuery || !heightFieldQuery->contains(origin.x(), origin.z())) {
+        return false;
+      }
+
+      // Only a car driving normally on all its wheels hands over without a jump
+      auto &vehicle = *carPhysicsBody.mVehicle;
+      for (int i = 0; i < vehicle.getNumWheels(); i++) {
+        if (!vehicle.getWheelInfo(i).m_raycastInfo.m_isInContact) {
+          return false;
+        }
+      }
+      auto &trackPath = *carPhysicsBody.mTrackPath;
+      glm::vec2 tangent = trackPath.getTangent(trackPath.getClosestDistance(glm::vec2(origin.x(), origin.z())));
+      btVector3 forward = carPhysicsBody.mRigidBody->getCenterOfMassTransform().getBasis().getColumn(2);
+      glm::vec2 heading(forward.x(), forward.z());
+      return glm::length(heading) > 0.0f && glm::dot(glm::normalize(heading), tangent) > HEADING_ALIGNMENT;
+    }
+
+    void SimulationLod::makeKinematic(Components::CarPhysicsBody &carPhysicsBody, btDynamicsWorld &dynamicsWorld,
+                                      HeightFieldQuery const &heightFieldQuery)
+    {
+      auto &trackPath = *carPhysicsBody.mTrackPath;
+      btVector3 origin = carPhysicsBody.mRigidBody->getCenterOfMassPosition();
+      glm::vec2 position(origin.x(), origin.z());
+
+      carPhysicsBody.mPathDistance = trackPath.getClosestDistance(position);
+      carPhysicsBody.mLaneOffset = glm::dot(position - trackPath.getPosition(carPhysicsBody.mPathDistance),
+                                            trackPath.getLateral(carPhysicsBody.mPathDistance));
+      glm::vec2 tangent = trackPath.getTangent(carPhysicsBody.mPathDistance);
+      btVector3 velocity = carPhysicsBody.mRigidBody->getLinearVelocity();
+      carPhysicsBody.mPathSpeed = velocity.x()*tangent.x + velocity.z()*tangent.y;
+      carPhysicsBody.mRideHeight = origin.y() - heightFieldQuery.getHeight(origin.x(), origin.z());
+
+      dynamicsWorld.removeRigidBody(&(*carPhysicsBody.mRigidBody));
+      carPhysicsBody.mKinematic = true;
+    }
+
+    void SimulationLod::makeDynamic(Components::CarPhysicsBody &carPhysicsBody, btDynamicsWorld &dynamicsWorld)
+    {
+      // Resume from the pose the path left the car in, moving along its heading at its path speed
+      auto &rigidBody = *carPhysicsBody.mRigidBody;
+      btTransform const &transform = rigidBody.getCenterOfMassTransform();
+      rigidBody.setInterpolationWorldTransform(transform);
+      rigidBody.setLinearVelocity(transform.getBasis().getColumn(2)*carPhysicsBody.mPathSpeed);
+      rigidBody.setAngularVelocity(btVector3(0, 0, 0));
+      rigidBody.setInterpolationLinearVelocity(rigidBody.getLinearVelocity());
+      rigidBody.setInterpolationAngularVelocity(btVector3(0, 0, 0));
+      rigidBody.clearForces();
+
+      dynamicsWorld.addRigidBody(&rigidBody);
+      carPhysicsBody.mKinematic = false;
+    }
+
+    float SimulationLod::getNearestCarDistance2(int index) const
+    {
+      glm::vec2 position = mPositions[index];
+      float nearestDistance2 = INFINITY;
+      for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          long long key = getCellKey(position + glm::vec2(dx, dz)*KINEMATIC_SEPARATION);
+          auto cell = std::lower_bound(mCells.begin(), mCells.end(), std::make_pair(key, 0));
+          for (; cell != mCells.end() && cell->first == key; cell++) {
+            if (cell->second != index) {
+              glm::vec2 offset = mPositions[cell->second] - position;
+              nearestDistance2 = std::min(nearestDistance2, glm::dot(offset, offset));
+            }
+          }
+        }
+      }
+      return nearestDistance2;
+    }
+
+    long long SimulationLod::getCellKey(glm::vec2 position) const
+    {
+      long long x = (long long) std::floor(position.x / KINEMATIC_SEPARATION);
+      long long z = (long long) std::floor(position.y / KINEMATIC_SEPARATION);
+      return (x << 32) ^ (z & 0xffffffff);
+    }
+}
@@ -0,0 +1,117 @@
+#include "Physics/taskscheduler.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace Physics
+{
+    namespace
+    {
+        // Bullet hands out thread indices on first use and never gives them back, so the workers claim theirs once
+        // and every later world reuses them. Returns one more than the highest index a worker holds.
+        unsigned int claimWorkerThreadIndices()
+        {
+            static unsigned int threadIndexCount = []() {
+                std::mutex mutex;
+                unsigned int count = 0;
+                Core::ThreadPool::getInstance().runOnEachWorker([&mutex, &count]() {
+                    unsigned int threadIndex = btGetCurrentThreadIndex();
+                    std::lock_guard<std::mutex> lock(mutex);
+                    count = std::max(count, threadIndex + 1);
+                });
+                return count;
+            }();
+            return threadIndexCount;
+        }
+    }
+
+    TaskScheduler::TaskScheduler(int numThreads)
+      : btITaskScheduler("ThreadPool"), mNumThreads(1)
+    {
+      // The stepping thread, which constructs the scheduler, claims its index before the workers
+      unsigned int threadIndexCount = btGetCurrentThreadIndex() + 1;
+      threadIndexCount = std::max(threadIndexCount, claimWorkerThreadIndices());
+      if (threadIndexCount > (unsigned int) getNumThreads()) {
+        // Other threads took indices first, so jobs on the workers could overrun Bullet's per-thread storage
+        std::cout << "Bullet thread indices exceed the thread pool; stepping physics on one thread" << std::endl;
+        return;
+      }
+      setNumThreads(numThreads);
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+    }
+
+    int TaskScheduler::getMaxNumThreads() const
+    {
+      return std::min<int>(Core::ThreadPool::getInstance().getNumThreads() + 1, BT_MAX_THREAD_COUNT);
+    }
+
+    int TaskScheduler::getNumThreads() const
+    {
+      // Any worker may run a job, so storage must cover all of them, not only the mNumThreads a loop is split across
+      return getMaxNumThreads();
+    }
+
+    void TaskScheduler::setNumThreads(int numThreads)
+    {
+      mNumThreads = std::max(1, std::min(numThreads, getMaxNumThreads()));
+    }
+
+    int TaskScheduler::getJobCount(int iBegin, int iEnd, int grainSize) const
+    {
+      int count = iEnd - iBegin;
+      int jobs = (count + std::max(grainSize, 1) - 1) / std::max(grainSize, 1);
+      return std::max(1, std::min(jobs, mNumThreads));
+    }
+
+    void TaskScheduler::runJobs(int jobs, std::function<void(int)> const &function)
+    {
+      // Jobs never outnumber mNumThreads, so at most mNumThreads-1 workers join the stepping thread
+      Core::ThreadPool::getInstance().parallelFor(jobs, function);
+    }
+
+    void TaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, btIParallelForBody const &body)
+    {
+      if (iBegin >= iEnd) {
+        return;
+      }
+      int jobs = getJobCount(iBegin, iEnd, grainSize);
+      if (jobs == 1) {
+        body.forLoop(iBegin, iEnd);
+        return;
+      }
+
+      // Contiguous, evenly sized ranges, one per job
+      int count = iEnd - iBegin;
+      runJobs(jobs, [&](int job) {
+        body.forLoop(iBegin + count*job/jobs, iBegin + count*(job + 1)/jobs);
+      });
+    }
+
+    btScalar TaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, btIParallelSumBody const &body)
+    {
+      if (iBegin >= iEnd) {
+        return btScalar(0);
+      }
+      int jobs = getJobCount(iBegin, iEnd, grainSize);
+      if (jobs == 1) {
+        return body.sumLoop(iBegin, iEnd);
+      }
+
+      // Partial sums are added in job order, so the result does not depend on scheduling
+      int count = iEnd - iBegin;
+      std::vector<btScalar> sums(jobs, btScalar(0));
+      runJobs(jobs, [&](int job) {
+        sums[job] = body.sumLoop(iBegin + count*job/jobs, iBegin + count*(job + 1)/jobs);
+      });
+      btScalar sum(0);
+      for (btScalar partialSum : sums) {
+        sum += partialSum;
+      }
+      return sum;
+    }
+}
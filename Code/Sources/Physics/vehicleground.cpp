@@ -0,0 +1,167 @@
+#include "Physics/vehicleground.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Width of a grid cell, in world units
+const float CELL_SIZE = 2.0f;
+
+namespace Physics
+{
+    VehicleGround::VehicleGround()
+      : mTerrainObject(nullptr), mGridMin(0, 0, 0), mCellsX(0), mCellsZ(0), mStaticObjectCount(-1)
+    {
+    }
+
+    VehicleGround::~VehicleGround()
+    {
+    }
+
+    void VehicleGround::setTerrain(btCollisionObject const *terrainObject, std::shared_ptr<HeightFieldQuery> heightFieldQuery)
+    {
+      mTerrainObject = terrainObject;
+      mHeightFieldQuery = heightFieldQuery;
+      mStaticObjectCount = -1;
+    }
+
+    void VehicleGround::update(btCollisionWorld &collisionWorld)
+    {
+      // Static colliders never move, so the grid only changes when they are added or removed
+      auto &collisionObjects = collisionWorld.getCollisionObjectArray();
+      int staticObjectCount = 0;
+      for (int i = 0; i < collisionObjects.size(); i++) {
+        if (collisionObjects[i]->isStaticObject()) {
+          staticObjectCount++;
+        }
+      }
+      if (staticObjectCount == mStaticObjectCount) {
+        return;
+      }
+      mStaticObjectCount = staticObjectCount;
+
+      mBounds.clear();
+      for (int i = 0; i < collisionObjects.size(); i++) {
+        auto collisionObject = collisionObjects[i];
+        if (collisionObject->isStaticObject() && collisionObject != mTerrainObject) {
+          addColliderBounds(collisionObject->getCollisionShape(), collisionObject->getWorldTransform());
+        }
+      }
+
+      // Size the grid to the colliders
+      mCellsX = 0;
+      mCellsZ = 0;
+      mCellStarts.clear();
+      mCellBounds.clear();
+      if (mBounds.empty()) {
+        return;
+      }
+      btVector3 gridMax = mBounds[0].mMax;
+      mGridMin = mBounds[0].mMin;
+      for (auto &bounds : mBounds) {
+        mGridMin.setMin(bounds.mMin);
+        gridMax.setMax(bounds.mMax);
+      }
+      mCellsX = (int) std::ceil((gridMax.x() - mGridMin.x()) / CELL_SIZE) + 1;
+      mCellsZ = (int) std::ceil((gridMax.z() - mGridMin.z()) / CELL_SIZE) + 1;
+
+      // Count the bounds in each cell, then fill them in
+      std::vector<int> cellCounts(mCellsX*mCellsZ, 0);
+      for (auto &bounds : mBounds) {
+        int minX, minZ, maxX, maxZ;
+        getCellRange(bounds.mMin, bounds.mMax, minX, minZ, maxX, maxZ);
+        for (int z = minZ; z <= maxZ; z++) {
+          for (int x = minX; x <= maxX; x++) {
+            cellCounts[z*mCellsX + x]++;
+          }
+        }
+      }
+      mCellStarts.assign(mCellsX*mCellsZ + 1, 0);
+      for (int i = 0; i < mCellsX*mCellsZ; i++) {
+        mCellStarts[i + 1] = mCellStarts[i] + cellCounts[i];
+      }
+      mCellBounds.resize(mCellStarts.back());
+      std::fill(cellCounts.begin(), cellCounts.end(), 0);
+      for (size_t i = 0; i < mBounds.size(); i++) {
+        int minX, minZ, maxX, maxZ;
+        getCellRange(mBounds[i].mMin, mBounds[i].mMax, minX, minZ, maxX, maxZ);
+        for (int z = minZ; z <= maxZ; z++) {
+          for (int x = minX; x <= maxX; x++) {
+            int cell = z*mCellsX + x;
+            mCellBounds[mCellStarts[cell] + cellCounts[cell]++] = i;
+          }
+        }
+      }
+    }
+
+    void VehicleGround::addColliderBounds(btCollisionShape const *shape, btTransform const &transform)
+    {
+      if (shape->isCompound()) {
+        auto compoundShape = static_cast<btCompoundShape const *>(shape);
+        for (int i = 0; i < compoundShape->getNumChildShapes(); i++) {
+          addColliderBounds(compoundShape->getChildShape(i), transform * compoundShape->getChildTransform(i));
+        }
+      }
+      else if (shape->isConcave()) {
+        // A wall around the track has bounds covering the whole track, but its triangles are local
+        class TriangleBoundsCallback : public btTriangleCallback
+        {
+        public:
+          TriangleBoundsCallback(btTransform const &transform, std::vector<Bounds> &bounds)
+            : mTransform(transform), mBounds(bounds)
+          {
+          }
+
+          virtual void processTriangle(btVector3 *triangle, int partId, int triangleIndex) override
+          {
+            Bounds bounds { mTransform * triangle[0], mTransform * triangle[0] };
+            for (int i = 1; i < 3; i++) {
+              bounds.mMin.setMin(mTransform * triangle[i]);
+              bounds.mMax.setMax(mTransform * triangle[i]);
+            }
+            mBounds.push_back(bounds);
+          }
+
+        private:
+          btTransform const &mTransform;
+          std::vector<Bounds> &mBounds;
+        };
+
+        TriangleBoundsCallback callback(transform, mBounds);
+        btVector3 infinity(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+        static_cast<btConcaveShape const *>(shape)->processAllTriangles(&callback, -infinity, infinity);
+      }
+      else {
+        Bounds bounds;
+        shape->getAabb(transform, bounds.mMin, bounds.mMax);
+        mBounds.push_back(bounds);
+      }
+    }
+
+    void VehicleGround::getCellRange(btVector3 const &aabbMin, btVector3 const &aabbMax, int &minX, int &minZ, int &maxX, int &maxZ) const
+    {
+      minX = std::max((int) std::floor((aabbMin.x() - mGridMin.x()) / CELL_SIZE), 0);
+      minZ = std::max((int) std::floor((aabbMin.z() - mGridMin.z()) / CELL_SIZE), 0);
+      maxX = std::min((int) std::floor((aabbMax.x() - mGridMin.x()) / CELL_SIZE), mCellsX - 1);
+      maxZ = std::min((int) std::floor((aabbMax.z() - mGridMin.z()) / CELL_SIZE), mCellsZ - 1);
+    }
+
+    bool VehicleGround::isNearCollider(btVector3 const &aabbMin, btVector3 const &aabbMax) const
+    {
+      int minX, minZ, maxX, maxZ;
+      getCellRange(aabbMin, aabbMax, minX, minZ, maxX, maxZ);
+      for (int z = minZ; z <= maxZ; z++) {
+        for (int x = minX; x <= maxX; x++) {
+          int cell = z*mCellsX + x;
+          for (int i = mCellStarts[cell]; i < mCellStarts[cell + 1]; i++) {
+            auto &bounds = mBounds[mCellBounds[i]];
+            if (bounds.mMin.x() <= aabbMax.x() && bounds.mMax.x() >= aabbMin.x() &&
+                bounds.mMin.y() <= aabbMax.y() && bounds.mMax.y() >= aabbMin.y() &&
+                bounds.mMin.z() <= aabbMax.z() && bounds.mMax.z() >= aabbMin.z()) {
+              return true;
+            }
+          }
+        }
+      }
+      return false;
+    }
+}
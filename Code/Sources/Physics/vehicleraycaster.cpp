@@ -0,0 +1,73 @@
+#include "Physics/vehicleraycaster.hpp"
+#include "Utils/transformconversions.hpp"
+
+// Distance around a ray in which another collider sends it to the world ray test
+const btScalar COLLIDER_MARGIN = 0.1f;
+// Refinements of the hit fraction; a vertical ray is exact after the first
+const int HIT_ITERATIONS = 4;
+
+namespace Physics
+{
+    VehicleRaycaster::VehicleRaycaster(btDynamicsWorld *dynamicsWorld, VehicleGround const &vehicleGround)
+      : btDefaultVehicleRaycaster(dynamicsWorld), mVehicleGround(vehicleGround)
+    {
+    }
+
+    VehicleRaycaster::~VehicleRaycaster()
+    {
+    }
+
+    void *VehicleRaycaster::castRay(btVector3 const &from, btVector3 const &to, btVehicleRaycasterResult &result)
+    {
+      auto heightFieldQuery = mVehicleGround.getHeightFieldQuery();
+      if (heightFieldQuery == nullptr ||
+          !heightFieldQuery->contains(from.x(), from.z()) || !heightFieldQuery->contains(to.x(), to.z())) {
+        return btDefaultVehicleRaycaster::castRay(from, to, result);
+      }
+
+      btVector3 aabbMin = from;
+      btVector3 aabbMax = from;
+      aabbMin.setMin(to);
+      aabbMax.setMax(to);
+      btVector3 margin(COLLIDER_MARGIN, COLLIDER_MARGIN, COLLIDER_MARGIN);
+      if (mVehicleGround.isNearCollider(aabbMin - margin, aabbMax + margin)) {
+        return btDefaultVehicleRaycaster::castRay(from, to, result);
+      }
+
+      // Height of the point a fraction along the ray above the terrain under it
+      auto heightAbove = [&](btScalar fraction, glm::vec3 *normal) {
+        btVector3 point = from.lerp(to, fraction);
+        return point.y() - heightFieldQuery->getHeight(point.x(), point.z(), normal);
+      };
+
+      // Like Bullet's height field, the surface is only hit from above
+      btScalar aboveFraction = 0.0f, belowFraction = 1.0f;
+      btScalar aboveHeight = heightAbove(aboveFraction, nullptr);
+      btScalar belowHeight = heightAbove(belowFraction, nullptr);
+      if (aboveHeight < 0.0f || belowHeight > 0.0f) {
+        return nullptr;
+      }
+
+      // Regula falsi between the ends of the ray
+      btScalar fraction = aboveFraction;
+      for (int i = 0; i < HIT_ITERATIONS && aboveHeight > 0.0f; i++) {
+        fraction = aboveFraction + (belowFraction - aboveFraction) * aboveHeight / (aboveHeight - belowHeight);
+        btScalar height = heightAbove(fraction, nullptr);
+        if (height > 0.0f) {
+          aboveFraction = fraction;
+          aboveHeight = height;
+        }
+        else {
+          belowFraction = fraction;
+          belowHeight = height;
+        }
+      }
+
+      glm::vec3 normal;
+      heightAbove(fraction, &normal);
+      result.m_hitPointInWorld = from.lerp(to, fraction);
+      result.m_hitNormalInWorld = Utils::TransformConversions::glmVec32btVector3(normal);
+      result.m_distFraction = fraction;
+      return const_cast<btCollisionObject *>(mVehicleGround.getTerrainObject());
+    }
+}
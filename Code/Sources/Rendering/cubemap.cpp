@@ -57,6 +57,36 @@ namespace Rendering
     }
 
     void CubeMap::setFaces(std::vector<std::string> faces)
+    {
+        for (unsigned int i = 0; i < faces.size(); i++) {
+            loadFace(i, faces[i]);
+        }
+        upload();
+    }
+
+    void CubeMap::loadFace(unsigned int face, std::string const &path)
+    {
+        // CPU only, so faces can be decoded concurrently
+        FaceData &faceData = mFaces[face];
+        if (Assets::TextureCache::load(path, false, false, faceData.mCompressedImage)) {
+            return;
+        }
+
+        int nrChannels;
+        unsigned char *data = stbi_load(path.c_str(), &faceData.mWidth, &faceData.mHeight, &nrChannels, 3);
+        if (data)
+        {
+            faceData.mPixels.assign(data, data + faceData.mWidth*faceData.mHeight*3);
+            stbi_image_free(data);
+        }
+        else
+        {
+            std::cout << "Cubemap texture failed to load at path: " << path << std::endl;
+            stbi_image_free(data);
+        }
+    }
+
+    void CubeMap::upload()
     {
         // Vertices
         glGenVertexArrays(1, &mVAO);
@@ -77,23 +107,24 @@ namespace Rendering
         glGenTextures(1, &mTextureID);
         glBindTexture(GL_TEXTURE_CUBE_MAP, mTextureID);
 
-        int width, height, nrChannels;
-        for (unsigned int i = 0; i < faces.size(); i++)
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (unsigned int i = 0; i < 6; i++)
         {
-            unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-            if (data)
+            FaceData &faceData = mFaces[i];
+            if (!faceData.mCompressedImage.mLevels.empty())
             {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                             0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
-                );
-                stbi_image_free(data);
+                Assets::TextureCache::upload(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, faceData.mCompressedImage);
+                faceData.mCompressedImage = Assets::CompressedImage();
             }
-            else
+            else if (!faceData.mPixels.empty())
             {
-                std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-                stbi_image_free(data);
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+                             0, GL_RGB, faceData.mWidth, faceData.mHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, &faceData.mPixels[0]
+                );
+                std::vector<unsigned char>().swap(faceData.mPixels);
             }
         }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -3,6 +3,7 @@
 #include "Utils/logger.hpp"
 
 #include <iostream>
+#include <utility>
 
 namespace Rendering
 {
@@ -28,21 +29,26 @@ namespace Rendering
         setDebugMode(2);
     }
 
-    void DebugRenderer::drawAccumulated()
+    void DebugRenderer::takeLines(std::vector<Vertex> &lines)
+    {
+        // The caller's old lines are discarded, keeping their storage for the next frame's
+        lines.clear();
+        std::swap(lines, mVertices);
+    }
+
+    void DebugRenderer::draw(std::vector<Vertex> const &lines)
     {
         #ifdef DEBUG
-            std::cout << "Drawing " << mVertices.size() << " vertices." << std::endl;
+            std::cout << "Drawing " << lines.size() << " vertices." << std::endl;
         #endif
+        if (lines.empty()) {
+            return;
+        }
         mShader->use();
         glBindVertexArray(mVAO);
         glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-        glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), &mVertices[0], GL_STATIC_DRAW);
-        glDrawArrays(GL_LINES, 0, mVertices.size());
-    }
-
-    void DebugRenderer::clear()
-    {
-        mVertices.clear();
+        glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(Vertex), &lines[0], GL_STATIC_DRAW);
+        glDrawArrays(GL_LINES, 0, lines.size());
     }
 
     void DebugRenderer::drawLine(const btVector3 &from, const btVector3 &to, const btVector3 &color)
@@ -0,0 +1,74 @@
+#include "Rendering/dynamicresolution.hpp"
+
+#include <algorithm>
+
+// Controller gains, applied to the frame time error as a fraction of the budget. Measurements lag by
+// several frames, so the gains stay small enough not to oscillate around the target.
+const float PROPORTIONAL_GAIN = 0.2f;
+const float INTEGRAL_GAIN = 0.02f;
+
+namespace Rendering
+{
+    DynamicResolution::DynamicResolution()
+        : mCurrentQuery(0), mGPUTime(0.0), mNewMeasurement(false), mScale(1.0f), mIntegral(1.0f), mError(0.0f)
+    {
+        glGenQueries(QUERY_COUNT, mQueries);
+        for (int i = 0; i < QUERY_COUNT; i++) {
+            mQueryIssued[i] = false;
+        }
+    }
+
+    DynamicResolution::~DynamicResolution()
+    {
+        glDeleteQueries(QUERY_COUNT, mQueries);
+    }
+
+    void DynamicResolution::beginFrame()
+    {
+        // The query in this slot was issued QUERY_COUNT frames ago; skip it rather than stall if it is still pending
+        GLuint query = mQueries[mCurrentQuery];
+        if (mQueryIssued[mCurrentQuery]) {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                mGPUTime = elapsed * 1e-9;
+                mNewMeasurement = true;
+            }
+        }
+
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        mQueryIssued[mCurrentQuery] = true;
+    }
+
+    void DynamicResolution::endFrame()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        mCurrentQuery = (mCurrentQuery + 1) % QUERY_COUNT;
+    }
+
+    float DynamicResolution::update(RenderSettings const &renderSettings)
+    {
+        // Render targets are allocated at framebuffer size, so the scale can only go down from 1
+        float maxScale = std::min(renderSettings.mMaxRenderScale, 1.0f);
+        float minScale = std::min(std::max(renderSettings.mMinRenderScale, 0.1f), maxScale);
+        if (!renderSettings.mDynamicResolution) {
+            // Re-enabling starts from full quality and backs off from there
+            mIntegral = maxScale;
+            mError = 0.0f;
+            mScale = 1.0f;
+            return mScale;
+        }
+
+        // Only react to fresh measurements, so one slow frame is not counted several times
+        if (mNewMeasurement && renderSettings.mTargetGPUFrameTime > 0.0f) {
+            mError = (renderSettings.mTargetGPUFrameTime - mGPUTime) / renderSettings.mTargetGPUFrameTime;
+            // Clamping the integral keeps it from winding up while the scale sits at a bound
+            mIntegral = std::min(std::max(mIntegral + INTEGRAL_GAIN*mError, minScale), maxScale);
+            mNewMeasurement = false;
+        }
+        mScale = std::min(std::max(mIntegral + PROPORTIONAL_GAIN*mError, minScale), maxScale);
+        return mScale;
+    }
+}
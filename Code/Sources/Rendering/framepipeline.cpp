@@ -0,0 +1,87 @@
+#include "Rendering/framepipeline.hpp"
+#include "Utils/threadutils.hpp"
+
+#include <algorithm>
+
+namespace Rendering
+{
+    FramePipeline::FramePipeline(GLFWwindow *window, RenderingEngine &renderingEngine, int framesInFlight, int renderCPU)
+        : mWindow(window), mRenderingEngine(renderingEngine), mRenderCPU(renderCPU), mAcquiredSnapshot(nullptr), mStopping(false)
+    {
+        // One snapshot being drawn and one being filled is the least that overlaps the two threads
+        framesInFlight = std::max(framesInFlight, 2);
+        for (int i = 0; i < framesInFlight; i++) {
+            mSnapshots.push_back(std::make_unique<RenderSnapshot>());
+            mFreeSnapshots.push_back(mSnapshots.back().get());
+        }
+
+        // A context can only be current on one thread at a time
+        glfwMakeContextCurrent(nullptr);
+        mRenderThread = std::thread(&FramePipeline::renderLoop, this);
+    }
+
+    FramePipeline::~FramePipeline()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mCondition.notify_all();
+        mRenderThread.join();
+
+        glfwMakeContextCurrent(mWindow);
+    }
+
+    RenderSnapshot &FramePipeline::acquireSnapshot()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() { return !mFreeSnapshots.empty(); });
+        mAcquiredSnapshot = mFreeSnapshots.front();
+        mFreeSnapshots.pop_front();
+        return *mAcquiredSnapshot;
+    }
+
+    void FramePipeline::submitSnapshot()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueuedSnapshots.push_back(mAcquiredSnapshot);
+            mAcquiredSnapshot = nullptr;
+        }
+        mCondition.notify_all();
+    }
+
+    void FramePipeline::renderLoop()
+    {
+        glfwMakeContextCurrent(mWindow);
+        if (mRenderCPU >= 0) {
+            Utils::ThreadUtils::setCurrentThreadAffinity(mRenderCPU);
+        }
+
+        while (true) {
+            RenderSnapshot *snapshot;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mStopping || !mQueuedSnapshots.empty(); });
+                // Draw remaining frames before shutting down
+                if (mQueuedSnapshots.empty()) {
+                    break;
+                }
+                snapshot = mQueuedSnapshots.front();
+                mQueuedSnapshots.pop_front();
+            }
+
+            mRenderingEngine.renderScene(*snapshot);
+
+            // Everything the frame needs has been submitted, so the simulation can refill the snapshot during the swap
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFreeSnapshots.push_back(snapshot);
+            }
+            mCondition.notify_all();
+            glfwSwapBuffers(mWindow);
+        }
+
+        glfwMakeContextCurrent(nullptr);
+    }
+}
@@ -0,0 +1,6 @@
+#include "Rendering/graphicscontext.hpp"
+
+namespace Rendering
+{
+    bool GraphicsContext::mHeadless = false;
+}
@@ -0,0 +1,421 @@
+#include "Rendering/rendergraph.hpp"
+#include "Utils/openglerrors.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+// Pooled textures unused for this many frames are freed, so a resize or a disabled effect
+// releases its memory without reallocating every frame
+const unsigned int POOL_FRAMES_TO_KEEP = 3;
+
+namespace
+{
+    bool isDepthFormat(GLenum format)
+    {
+        return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F ||
+               format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+    }
+
+    bool hasStencil(GLenum format)
+    {
+        return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+    }
+}
+
+namespace Rendering
+{
+    bool TextureDesc::operator==(TextureDesc const &other) const
+    {
+        return mWidth == other.mWidth && mHeight == other.mHeight &&
+               mInternalFormat == other.mInternalFormat && mFilter == other.mFilter;
+    }
+
+    RenderGraph::Resource RenderGraph::PassBuilder::createTexture(std::string const &name, TextureDesc const &desc)
+    {
+        mGraph.mResources.push_back({name, desc, false, -1, 0});
+        return mGraph.mResources.size() - 1;
+    }
+
+    RenderGraph::Resource RenderGraph::PassBuilder::read(Resource resource)
+    {
+        mGraph.mPasses[mPass].mReads.push_back(resource);
+        return resource;
+    }
+
+    RenderGraph::Resource RenderGraph::PassBuilder::write(Resource resource)
+    {
+        mGraph.mPasses[mPass].mWrites.push_back(resource);
+        if (resource == mGraph.mBackbuffer) {
+            mGraph.mPasses[mPass].mSideEffect = true;
+        }
+        return resource;
+    }
+
+    RenderGraph::Resource RenderGraph::PassBuilder::writeDepth(Resource resource)
+    {
+        mGraph.mPasses[mPass].mDepth = resource;
+        return resource;
+    }
+
+    RenderGraph::Resource RenderGraph::PassBuilder::readStorage(Resource resource)
+    {
+        mGraph.mPasses[mPass].mStorageReads.push_back(resource);
+        return resource;
+    }
+
+    RenderGraph::Resource RenderGraph::PassBuilder::writeStorage(Resource resource)
+    {
+        mGraph.mPasses[mPass].mStorageWrites.push_back(resource);
+        return resource;
+    }
+
+    void RenderGraph::PassBuilder::setSideEffect()
+    {
+        mGraph.mPasses[mPass].mSideEffect = true;
+    }
+
+    void RenderGraph::PassBuilder::setRenderArea(int width, int height)
+    {
+        mGraph.mPasses[mPass].mRenderWidth = width;
+        mGraph.mPasses[mPass].mRenderHeight = height;
+    }
+
+    RenderGraph::RenderGraph()
+        : mBackbuffer(-1), mCurrentPass(-1), mFrame(0)
+    {
+    }
+
+    RenderGraph::~RenderGraph()
+    {
+        for (auto &framebuffer : mFramebuffers) {
+            glDeleteFramebuffers(1, &framebuffer.second);
+        }
+        for (auto &texture : mPool) {
+            glDeleteTextures(1, &texture.mID);
+        }
+    }
+
+    void RenderGraph::beginFrame(int width, int height)
+    {
+        mPasses.clear();
+        mResources.clear();
+        mResources.push_back({"Backbuffer", {width, height, GL_RGBA8, GL_NEAREST}, true, -1, 0});
+        mBackbuffer = 0;
+    }
+
+    TextureDesc const &RenderGraph::getDesc(Resource resource) const
+    {
+        return mResources[resource].mDesc;
+    }
+
+    void RenderGraph::addPass(std::string const &name, SetupFunction const &setup, ExecuteFunction const &execute)
+    {
+        Pass pass;
+        pass.mName = name;
+        pass.mExecute = execute;
+        pass.mDepth = -1;
+        pass.mRenderWidth = 0;
+        pass.mRenderHeight = 0;
+        pass.mSideEffect = false;
+        pass.mCulled = false;
+        mPasses.push_back(pass);
+
+        PassBuilder builder(*this, mPasses.size() - 1);
+        setup(builder);
+    }
+
+    void RenderGraph::execute()
+    {
+        cull();
+        computeLifetimes();
+
+        for (unsigned int i = 0; i < mPasses.size(); i++) {
+            Pass &pass = mPasses[i];
+            if (pass.mCulled) {
+                continue;
+            }
+
+            for (auto resource : pass.mAllocations) {
+                mResources[resource].mPoolIndex = acquireTexture(mResources[resource].mDesc);
+            }
+
+            insertBarriers(pass);
+            bindTargets(pass);
+            bindImages(pass);
+            mCurrentPass = i;
+            pass.mExecute();
+            mCurrentPass = -1;
+            for (auto resource : pass.mStorageWrites) {
+                mResources[resource].mPendingBarriers = GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT |
+                                                        GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+            }
+
+            // Storage goes back to the pool for later passes in this frame to alias
+            for (auto resource : pass.mReleases) {
+                mPool[mResources[resource].mPoolIndex].mInUse = false;
+            }
+        }
+
+        collectGarbage();
+        mFrame++;
+    }
+
+    GLuint RenderGraph::getTexture(Resource resource) const
+    {
+        auto &node = mResources[resource];
+        if (node.mImported || node.mPoolIndex < 0) {
+            std::cout << "Render graph resource has no texture: " << node.mName << std::endl;
+            return 0;
+        }
+        return mPool[node.mPoolIndex].mID;
+    }
+
+    GLuint RenderGraph::getFramebuffer(Resource resource)
+    {
+        return getFramebuffer(std::vector<Resource>{resource}, -1);
+    }
+
+    void RenderGraph::bindPassTarget()
+    {
+        if (mCurrentPass >= 0) {
+            bindTargets(mPasses[mCurrentPass]);
+            bindImages(mPasses[mCurrentPass]);
+        }
+    }
+
+    unsigned int RenderGraph::getCulledPassCount() const
+    {
+        return std::count_if(mPasses.begin(), mPasses.end(), [](Pass const &pass) { return pass.mCulled; });
+    }
+
+    void RenderGraph::cull()
+    {
+        // Walk backwards from the passes with side effects. Writing a resource keeps its contents, so a kept
+        // pass also needs every earlier writer of what it writes.
+        std::vector<bool> needed(mResources.size(), false);
+        for (int i = mPasses.size() - 1; i >= 0; i--) {
+            Pass &pass = mPasses[i];
+            bool keep = pass.mSideEffect || (pass.mDepth >= 0 && needed[pass.mDepth]);
+            for (auto resource : pass.mWrites) {
+                keep = keep || needed[resource];
+            }
+            for (auto resource : pass.mStorageWrites) {
+                keep = keep || needed[resource];
+            }
+            pass.mCulled = !keep;
+            if (!keep) {
+                continue;
+            }
+
+            for (auto const *resources : {&pass.mReads, &pass.mWrites, &pass.mStorageReads, &pass.mStorageWrites}) {
+                for (auto resource : *resources) {
+                    needed[resource] = true;
+                }
+            }
+            if (pass.mDepth >= 0) {
+                needed[pass.mDepth] = true;
+            }
+        }
+    }
+
+    void RenderGraph::computeLifetimes()
+    {
+        std::vector<int> firstPass(mResources.size(), -1);
+        std::vector<int> lastPass(mResources.size(), -1);
+        for (unsigned int i = 0; i < mPasses.size(); i++) {
+            Pass &pass = mPasses[i];
+            pass.mAllocations.clear();
+            pass.mReleases.clear();
+            if (pass.mCulled) {
+                continue;
+            }
+
+            std::vector<Resource> used;
+            for (auto const *resources : {&pass.mReads, &pass.mWrites, &pass.mStorageReads, &pass.mStorageWrites}) {
+                used.insert(used.end(), resources->begin(), resources->end());
+            }
+            if (pass.mDepth >= 0) {
+                used.push_back(pass.mDepth);
+            }
+            for (auto resource : used) {
+                if (firstPass[resource] < 0) {
+                    firstPass[resource] = i;
+                }
+                lastPass[resource] = i;
+            }
+        }
+
+        for (unsigned int resource = 0; resource < mResources.size(); resource++) {
+            mResources[resource].mPoolIndex = -1;
+            mResources[resource].mPendingBarriers = 0;
+            if (mResources[resource].mImported || firstPass[resource] < 0) {
+                continue;
+            }
+            mPasses[firstPass[resource]].mAllocations.push_back(resource);
+            mPasses[lastPass[resource]].mReleases.push_back(resource);
+        }
+    }
+
+    void RenderGraph::insertBarriers(Pass const &pass)
+    {
+        // Render target and sampler hazards are handled by GL; only image stores need explicit barriers
+        GLbitfield barriers = 0;
+        for (auto resource : pass.mReads) {
+            // Reads may sample the texture or blit from it
+            barriers |= mResources[resource].mPendingBarriers & (GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+        }
+        for (auto const *resources : {&pass.mStorageReads, &pass.mStorageWrites}) {
+            for (auto resource : *resources) {
+                barriers |= mResources[resource].mPendingBarriers & GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+            }
+        }
+        for (auto resource : pass.mWrites) {
+            barriers |= mResources[resource].mPendingBarriers & GL_FRAMEBUFFER_BARRIER_BIT;
+        }
+
+        if (barriers) {
+            // A barrier orders every earlier store, but only for the access kinds in its bits
+            glMemoryBarrier(barriers);
+            for (auto &node : mResources) {
+                node.mPendingBarriers &= ~barriers;
+            }
+        }
+    }
+
+    void RenderGraph::bindTargets(Pass const &pass)
+    {
+        if (pass.mWrites.empty() && pass.mDepth < 0) {
+            return;
+        }
+
+        Resource sizeSource;
+        if (std::find(pass.mWrites.begin(), pass.mWrites.end(), mBackbuffer) != pass.mWrites.end()) {
+            if (pass.mWrites.size() > 1 || pass.mDepth >= 0) {
+                std::cout << "Render pass " << pass.mName << " mixes the backbuffer with other attachments." << std::endl;
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            sizeSource = mBackbuffer;
+        }
+        else {
+            glBindFramebuffer(GL_FRAMEBUFFER, getFramebuffer(pass.mWrites, pass.mDepth));
+            sizeSource = pass.mWrites.empty() ? pass.mDepth : pass.mWrites[0];
+        }
+        TextureDesc const &desc = mResources[sizeSource].mDesc;
+        int width = pass.mRenderWidth > 0 ? std::min(pass.mRenderWidth, desc.mWidth) : desc.mWidth;
+        int height = pass.mRenderHeight > 0 ? std::min(pass.mRenderHeight, desc.mHeight) : desc.mHeight;
+        glViewport(0, 0, width, height);
+
+        // Scissoring to the area keeps clears from touching texels the pass does not render
+        if (width < desc.mWidth || height < desc.mHeight) {
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(0, 0, width, height);
+        }
+        else {
+            glDisable(GL_SCISSOR_TEST);
+        }
+    }
+
+    void RenderGraph::bindImages(Pass const &pass)
+    {
+        GLuint unit = 0;
+        for (auto resource : pass.mStorageReads) {
+            glBindImageTexture(unit++, getTexture(resource), 0, GL_FALSE, 0, GL_READ_ONLY, mResources[resource].mDesc.mInternalFormat);
+        }
+        for (auto resource : pass.mStorageWrites) {
+            glBindImageTexture(unit++, getTexture(resource), 0, GL_FALSE, 0, GL_WRITE_ONLY, mResources[resource].mDesc.mInternalFormat);
+        }
+    }
+
+    int RenderGraph::acquireTexture(TextureDesc const &desc)
+    {
+        for (unsigned int i = 0; i < mPool.size(); i++) {
+            if (!mPool[i].mInUse && mPool[i].mDesc == desc) {
+                mPool[i].mInUse = true;
+                mPool[i].mLastUsedFrame = mFrame;
+                return i;
+            }
+        }
+
+        // Immutable storage, since pooled textures are never respecified
+        PooledTexture texture;
+        glGenTextures(1, &texture.mID);
+        glBindTexture(GL_TEXTURE_2D, texture.mID);
+        glTexStorage2D(GL_TEXTURE_2D, 1, desc.mInternalFormat, desc.mWidth, desc.mHeight);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.mFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.mFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        texture.mDesc = desc;
+        texture.mLastUsedFrame = mFrame;
+        texture.mInUse = true;
+        mPool.push_back(texture);
+        return mPool.size() - 1;
+    }
+
+    void RenderGraph::collectGarbage()
+    {
+        for (unsigned int i = 0; i < mPool.size(); ) {
+            if (mFrame - mPool[i].mLastUsedFrame < POOL_FRAMES_TO_KEEP) {
+                i++;
+                continue;
+            }
+
+            // Framebuffers referencing the texture go with it
+            GLuint id = mPool[i].mID;
+            for (auto it = mFramebuffers.begin(); it != mFramebuffers.end(); ) {
+                if (std::find(it->first.begin(), it->first.end(), id) != it->first.end()) {
+                    glDeleteFramebuffers(1, &it->second);
+                    it = mFramebuffers.erase(it);
+                }
+                else {
+                    it++;
+                }
+            }
+            glDeleteTextures(1, &id);
+            mPool.erase(mPool.begin() + i);
+        }
+    }
+
+    GLuint RenderGraph::getFramebuffer(std::vector<Resource> const &colors, Resource depth)
+    {
+        std::vector<GLuint> key;
+        for (auto resource : colors) {
+            key.push_back(getTexture(resource));
+        }
+        key.push_back(depth >= 0 ? getTexture(depth) : 0);
+
+        auto it = mFramebuffers.find(key);
+        if (it != mFramebuffers.end()) {
+            return it->second;
+        }
+
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        std::vector<GLenum> attachments;
+        for (unsigned int i = 0; i < colors.size(); i++) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, key[i], 0);
+            attachments.push_back(GL_COLOR_ATTACHMENT0 + i);
+        }
+        if (depth >= 0) {
+            GLenum format = mResources[depth].mDesc.mInternalFormat;
+            if (!isDepthFormat(format)) {
+                std::cout << "Render graph depth attachment has a color format: " << mResources[depth].mName << std::endl;
+            }
+            GLenum attachment = hasStencil(format) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+            glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, key.back(), 0);
+        }
+
+        // Draw buffer state belongs to the framebuffer, so it only needs setting once
+        if (attachments.empty()) {
+            glDrawBuffer(GL_NONE);
+        }
+        else {
+            glDrawBuffers(attachments.size(), attachments.data());
+        }
+        Utils::OpenGLErrors::checkFramebufferComplete();
+
+        mFramebuffers[key] = framebuffer;
+        return framebuffer;
+    }
+}
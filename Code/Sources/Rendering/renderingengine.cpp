@@ -1,21 +1,24 @@
 #include "Rendering/renderingengine.hpp"
 #include "Rendering/rendersettings.hpp"
+#include "Rendering/dynamicresolution.hpp"
 #include "Components/meshrenderer.hpp"
 #include "Components/wheelmeshrenderer.hpp"
 #include "Components/terrainrenderer.hpp"
 #include "Components/particlesystemrenderer.hpp"
 #include "Components/meshfilter.hpp"
-#include "Components/camera.hpp"
 #include "Utils/openglerrors.hpp"
-#include "Utils/transformconversions.hpp"
 #include "Utils/logger.hpp"
 #include "globals.hpp"
 
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <map>
 #include <vector>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <iomanip>
+#include <limits>
 #include <Components/pointlight.hpp>
 #include <Components/spotlight.hpp>
 
@@ -39,9 +42,96 @@ int terrainIndices[] = {
 
 int terrainN = sizeof(terrainIndices)/sizeof(int);
 
+// Screen-space simplification error, in pixels, accepted before switching to a coarser LOD
+const float LOD_PIXEL_ERROR = 1.0f;
+// Objects whose projected radius is below this many pixels use their impostor
+const float IMPOSTOR_PIXEL_RADIUS = 16.0f;
+// Coarsening must pass thresholds scaled by this, so levels do not flicker at the boundary
+const float LOD_HYSTERESIS = 0.75f;
+// Point light array size compiled into the lighting shader; spot lights are read from a buffer of any length
+const int MAX_POINT_LIGHTS = 6;
+// Shader storage binding of the spot light buffer; matches lighting.frag
+const int SPOT_LIGHT_BINDING = 0;
+// Spot lights are treated as reaching as far as their brightest channel stays above this
+const float SPOT_LIGHT_CUTOFF = 1.0f / 256.0f;
+// Half resolution particles cover this many pixels per texel along each axis
+const int PARTICLE_DOWNSAMPLE = 2;
+// Output pixels per post-processing workgroup along each axis; matches TILE_SIZE in post_process.cs
+const int POST_PROCESS_TILE_SIZE = 16;
+
+namespace
+{
+  // Wireframe modes are separate terrain variants rather than a per-fragment branch
+  unsigned int getTerrainPermutation(Rendering::TerrainRenderMode mode)
+  {
+    switch (mode) {
+      case Rendering::TerrainRenderMode::ALBEDO_AND_WIREFRAME:
+        return Rendering::TERRAIN_WIREFRAME_OVERLAY;
+      case Rendering::TerrainRenderMode::WIREFRAME:
+        return Rendering::TERRAIN_WIREFRAME_ONLY;
+      default:
+        return 0;
+    }
+  }
+
+  // One spot light in the std430 layout of SpotLight in lights.glsl
+  struct GpuSpotLight
+  {
+    glm::vec3 mPosition;
+    float mRange;
+    glm::vec3 mDirection;
+    float mInnerCutoff;
+    glm::vec3 mAmbient;
+    float mOuterCutoff;
+    glm::vec3 mDiffuse;
+    float mConstant;
+    glm::vec3 mSpecular;
+    float mLinear;
+    float mQuadratic;
+    float mPadding[3];
+  };
+  static_assert(sizeof(GpuSpotLight) == 96, "GpuSpotLight must match the std430 layout of SpotLight");
+
+  // Distance at which the light's attenuation drops its brightest channel below SPOT_LIGHT_CUTOFF
+  float getSpotLightRange(Components::SpotLight const &spotLight)
+  {
+    glm::vec3 color = spotLight.mAmbient + spotLight.mDiffuse + spotLight.mSpecular;
+    float brightness = std::max(color.x, std::max(color.y, color.z));
+    // Solve constant + linear*d + quadratic*d^2 = brightness / SPOT_LIGHT_CUTOFF for d
+    float constant = spotLight.mConstant - brightness / SPOT_LIGHT_CUTOFF;
+    if (constant >= 0.0f) {
+      return 0.0f;
+    }
+    if (spotLight.mQuadratic > 0.0f) {
+      float linear = spotLight.mLinear;
+      return (-linear + std::sqrt(linear*linear - 4.0f*spotLight.mQuadratic*constant)) / (2.0f*spotLight.mQuadratic);
+    }
+    if (spotLight.mLinear > 0.0f) {
+      return -constant / spotLight.mLinear;
+    }
+    return std::numeric_limits<float>::max();
+  }
+
+  // Whether a sphere is at least partly inside the frustum of a view-projection matrix
+  bool isSphereInFrustum(glm::mat4 const &viewProjection, glm::vec3 const &center, float radius)
+  {
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+      rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+    for (int i = 0; i < 6; i++) {
+      glm::vec4 plane = rows[3] + (i % 2 ? -1.0f : 1.0f)*rows[i / 2];
+      if (glm::dot(glm::vec3(plane), center) + plane.w < -radius*glm::length(glm::vec3(plane))) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
 namespace Rendering
 {
-  RenderingEngine::RenderingEngine(int texWidth, int texHeight) : mTexWidth(texWidth), mTexHeight(texHeight)
+  RenderingEngine::RenderingEngine()
   {
     // OpenGL settings that don't change
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); 
@@ -53,6 +143,7 @@ namespace Rendering
     );
     mDebugRenderer = std::make_unique<DebugRenderer>();
     mDebugRenderer->setDebugMode(2);
+    mDynamicResolution = std::make_unique<DynamicResolution>();
 
     // Check errors
     if (glGetError()) {
@@ -60,70 +151,24 @@ namespace Rendering
       exit(1);
     }
 
-    // Create gBuffer
-    glGenFramebuffers(1, &mGBufferID);
-    glBindFramebuffer(GL_FRAMEBUFFER, mGBufferID);
-
-    // Create depth buffer
-    glGenTextures(1, &mGDepthID);
-    glBindTexture(GL_TEXTURE_2D, mGDepthID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, mTexWidth, mTexHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, mGDepthID, 0);
-
-    // Create position color buffer
-    glGenTextures(1, &mGPositionID);
-    glBindTexture(GL_TEXTURE_2D, mGPositionID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mTexWidth, mTexHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mGPositionID, 0);
-      
-    // Create normal color buffer
-    glGenTextures(1, &mGNormalID);
-    glBindTexture(GL_TEXTURE_2D, mGNormalID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, mTexWidth, mTexHeight, 0, GL_RGB, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, mGNormalID, 0);
-      
-    // Create color + specular color buffer
-    glGenTextures(1, &mGAlbedoSpecID);
-    glBindTexture(GL_TEXTURE_2D, mGAlbedoSpecID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mTexWidth, mTexHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, mGAlbedoSpecID, 0);
-    
-    // Check for completeness of framebuffer
-    Utils::OpenGLErrors::checkFramebufferComplete();
-
-    // Create lBuffer
-    glGenFramebuffers(1, &mLBufferID);
-    glBindFramebuffer(GL_FRAMEBUFFER, mLBufferID);
-      
-    // Create color buffer
-    glGenTextures(1, &mLColorID);
-    glBindTexture(GL_TEXTURE_2D, mLColorID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, mTexWidth, mTexHeight, 0, GL_RGB, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mLColorID, 0);
-    
-    // Check for completeness of framebuffer
-    Utils::OpenGLErrors::checkFramebufferComplete();
-
-    // Create lighting shader
+    // Create lighting shader, with reduced-rate lighting and its upsampler as permutations
+    Assets::ShaderOptions lightingOptions;
+    lightingOptions.mDefines = {
+      "NR_POINT_LIGHTS " + std::to_string(MAX_POINT_LIGHTS)
+    };
+    lightingOptions.mFeatures = {"LOW_RESOLUTION", "UPSAMPLE"};
     mLightingShader = std::make_unique<Assets::Shader>(
       PROJECT_SOURCE_DIR "/Shaders/VertexShaders/quad.vert",
-      PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/lighting.frag"
+      PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/lighting.frag",
+      lightingOptions
     );
 
-    // Create FXAA shader
-    mFXAAShader = std::make_unique<Assets::Shader>(
-      PROJECT_SOURCE_DIR "/Shaders/VertexShaders/quad.vert",
-      PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/fxaa.frag"
+    // Create post-processing shader, with FXAA and its edge debug view as permutations
+    Assets::ShaderOptions postProcessOptions;
+    postProcessOptions.mFeatures = {"FXAA", "SHOW_EDGES"};
+    mPostProcessShader = std::make_unique<Assets::Shader>(
+      PROJECT_SOURCE_DIR "/Shaders/ComputeShaders/post_process.cs",
+      postProcessOptions
     );
 
     // Create gBuffer debugging shaders
@@ -144,6 +189,22 @@ namespace Rendering
       PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/debug_specular.frag"
     );
 
+    // Create half resolution particle shaders
+    mDepthDownsampleShader = std::make_unique<Assets::Shader>(
+      PROJECT_SOURCE_DIR "/Shaders/VertexShaders/quad.vert",
+      PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/depth_downsample.frag"
+    );
+    mParticleCompositeShader = std::make_unique<Assets::Shader>(
+      PROJECT_SOURCE_DIR "/Shaders/VertexShaders/quad.vert",
+      PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/particle_composite.frag"
+    );
+
+    // Create impostor shader
+    mImpostorShader = std::make_unique<Assets::Shader>(
+      PROJECT_SOURCE_DIR "/Shaders/VertexShaders/impostor.vert",
+      PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/impostor.frag"
+    );
+
     // Create default textures
     mDefaultAlbedoTexture = std::make_unique<Assets::Texture>(
       PROJECT_SOURCE_DIR "/Textures/Defaults/default_albedo.jpg"
@@ -176,10 +237,30 @@ namespace Rendering
     glGenBuffers(1, &mTerrainEBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mTerrainEBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(terrainIndices), &terrainIndices, GL_STATIC_DRAW);
+
+    // Create instanced quad for impostor billboards
+    glGenVertexArrays(1, &mImpostorVAO);
+    glBindVertexArray(mImpostorVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mQuadVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), (void*)0);
+    glGenBuffers(1, &mImpostorInstanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mImpostorInstanceVBO);
+    for (int i = 0; i < 4; i++) {
+      glEnableVertexAttribArray(5 + i);
+      glVertexAttribPointer(5 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i*sizeof(glm::vec4)));
+      glVertexAttribDivisor(5 + i, 1);
+    }
+    glBindVertexArray(0);
+
+    // Spot lights are refilled every frame with the ones in view
+    glGenBuffers(1, &mSpotLightBuffer);
+    mSpotLightCount = 0;
   }
 
   RenderingEngine::~RenderingEngine()
   {
+    glDeleteBuffers(1, &mSpotLightBuffer);
   }
 
   void RenderingEngine::clearFramebuffer()
@@ -188,6 +269,11 @@ namespace Rendering
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   }
 
+  glm::vec2 RenderingEngine::getTexCoordScale(RenderSnapshot const &snapshot)
+  {
+    return glm::vec2(mRenderWidth / snapshot.mRenderSettings.mFramebufferWidth, mRenderHeight / snapshot.mRenderSettings.mFramebufferHeight);
+  }
+
   void RenderingEngine::drawQuad()
   {
     mDrawCalls++;
@@ -196,102 +282,135 @@ namespace Rendering
     glBindVertexArray(0);
   }
 
-  void RenderingEngine::renderScene(Core::Scene const & scene, double deltaTime, double rollingFPS)
+  void RenderingEngine::renderScene(RenderSnapshot const &snapshot)
   {
     mDrawCalls = 0;
 
     // ***** UPDATE PARTICLE STATES *****
-    auto particleSystemRenderers = scene.getComponents<Components::ParticleSystemRenderer>();
-    for (auto particleSystemRenderer : particleSystemRenderers) {
-      if (particleSystemRenderer->mIsActive) {
-        particleSystemRenderer->mTimeActive += deltaTime;
-        if (particleSystemRenderer->mTimeActive >= particleSystemRenderer->mParticleSystem->mParticleLifetime*2) {
-          particleSystemRenderer->mTimeActive = 0.0f;
-          particleSystemRenderer->mIsActive = false;
-          particleSystemRenderer->resetBuffers();
-        }
-        else {
-          auto updateShader = particleSystemRenderer->mParticleSystem->mUpdateShader;
-          updateShader->use();
-
-          // Set color uniforms
-          auto colors = particleSystemRenderer->mParticleSystem->mColors;
-          for (int i = 0; i < colors.size(); i++) {
-            updateShader->setVec3("color" + std::to_string(i), colors[i]);
-          }
-
-          // Set particle update uniforms
-          updateShader->setInt("numParticles", particleSystemRenderer->mNumParticles);
-          updateShader->setFloat("particleLifetime", particleSystemRenderer->mParticleSystem->mParticleLifetime);
-          updateShader->setFloat("totalTime", particleSystemRenderer->mTimeActive);
-          updateShader->setFloat("deltaTime", deltaTime);
-
-          setModelUniforms(updateShader, scene, particleSystemRenderer->mGameObject);
-          particleSystemRenderer->update();
-        }
+    // Lifetimes advance with the simulation ticks
+    for (auto &emitter : snapshot.mParticleEmitters) {
+      auto particleSystemRenderer = emitter.mParticleSystemRenderer;
+      if (emitter.mReset) {
+        particleSystemRenderer->resetBuffers();
       }
-    }
-
-    // ***** MAIN RENDERING SETUP *****
-    // Handle viewport changes
-    glViewport(0, 0, scene.mRenderSettings.mFramebufferWidth, scene.mRenderSettings.mFramebufferHeight);
-    if (scene.mRenderSettings.mFramebufferWidth != mTexWidth || scene.mRenderSettings.mFramebufferHeight != mTexHeight) {
-      mTexWidth = scene.mRenderSettings.mFramebufferWidth;
-      mTexHeight = scene.mRenderSettings.mFramebufferHeight;
-
-      // Modify gBuffer textures
-      glBindTexture(GL_TEXTURE_2D, mGDepthID);
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, mTexWidth, mTexHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+      else {
+        auto updateShader = particleSystemRenderer->mParticleSystem->mUpdateShader;
+        updateShader->use();
 
-      glBindTexture(GL_TEXTURE_2D, mGPositionID);
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mTexWidth, mTexHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+        // Set color uniforms
+        auto colors = particleSystemRenderer->mParticleSystem->mColors;
+        for (size_t i = 0; i < colors.size(); i++) {
+          updateShader->setVec3("color" + std::to_string(i), colors[i]);
+        }
 
-      glBindTexture(GL_TEXTURE_2D, mGNormalID);
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, mTexWidth, mTexHeight, 0, GL_RGB, GL_FLOAT, NULL);
-      
-      glBindTexture(GL_TEXTURE_2D, mGAlbedoSpecID);
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mTexWidth, mTexHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        // Set particle update uniforms
+        updateShader->setInt("numParticles", particleSystemRenderer->mNumParticles);
+        updateShader->setFloat("particleLifetime", particleSystemRenderer->mParticleSystem->mParticleLifetime);
+        updateShader->setFloat("totalTime", emitter.mTimeActive);
+        updateShader->setFloat("deltaTime", snapshot.mDeltaTime);
 
-      // Modify lBuffer textures
-      glBindTexture(GL_TEXTURE_2D, mLColorID);
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, mTexWidth, mTexHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        setModelUniforms(updateShader, emitter.mModelMatrix);
+        particleSystemRenderer->update();
+      }
     }
 
-    // Calculate common uniforms
-    calculateCameraUniforms(scene);
-
-    // ***** GEOMETRY PASS *****
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
+    // ***** DYNAMIC RESOLUTION *****
+    // Scene passes render into the bottom-left corner of framebuffer-sized targets
+    float renderScale = mDynamicResolution->update(snapshot.mRenderSettings);
+    mRenderWidth = std::max(1, (int) std::lround(snapshot.mRenderSettings.mFramebufferWidth*renderScale));
+    mRenderHeight = std::max(1, (int) std::lround(snapshot.mRenderSettings.mFramebufferHeight*renderScale));
+    mDynamicResolution->beginFrame();
+
+    // ***** FRAME GRAPH *****
+    // Passes are declared every frame; the graph drops the ones the current render mode does not need
+    mProjectionMtx = snapshot.mProjectionMtx;
+    mViewMtx = snapshot.mViewMtx;
+    uploadSpotLights(snapshot);
+    mRenderGraph.beginFrame(snapshot.mRenderSettings.mFramebufferWidth, snapshot.mRenderSettings.mFramebufferHeight);
+
+    GBuffer gBuffer = addGeometryPass(snapshot);
+    RenderGraph::Resource sceneColor = addLightingPass(snapshot, gBuffer);
+    sceneColor = addOverlayPass(snapshot, gBuffer, sceneColor);
+    sceneColor = addHalfResParticlePasses(snapshot, gBuffer, sceneColor);
+    if (snapshot.mRenderSettings.mRenderMode == Rendering::RenderMode::DEBUG) {
+      addGBufferDebugPass(snapshot, gBuffer);
+    }
+    else {
+      addPresentPass(addPostProcessPass(snapshot, gBuffer, sceneColor));
+    }
+    addUIPass(snapshot);
 
-    // Set framebuffer and clear
-    glBindFramebuffer(GL_FRAMEBUFFER, mGBufferID);
-    clearFramebuffer();
+    mRenderGraph.execute();
+    mDynamicResolution->endFrame();
+  }
 
-    // Tell OpenGL which color attachments we'll use for rendering 
-    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-    glDrawBuffers(3, attachments);
+  RenderingEngine::GBuffer RenderingEngine::addGeometryPass(RenderSnapshot const &snapshot)
+  {
+    GBuffer gBuffer;
+    int width = snapshot.mRenderSettings.mFramebufferWidth;
+    int height = snapshot.mRenderSettings.mFramebufferHeight;
+    mRenderGraph.addPass("Geometry", [&](RenderGraph::PassBuilder &builder) {
+      gBuffer.mPosition = builder.write(builder.createTexture("gPosition", {width, height, GL_RGBA16F, GL_NEAREST}));
+      gBuffer.mNormal = builder.write(builder.createTexture("gNormal", {width, height, GL_RGB16F, GL_NEAREST}));
+      gBuffer.mAlbedoSpec = builder.write(builder.createTexture("gAlbedoSpec", {width, height, GL_RGBA8, GL_NEAREST}));
+      gBuffer.mDepth = builder.writeDepth(builder.createTexture("gDepth", {width, height, GL_DEPTH24_STENCIL8, GL_NEAREST}));
+      builder.setRenderArea(mRenderWidth, mRenderHeight);
+    }, [this, &snapshot]() {
+      glEnable(GL_DEPTH_TEST);
+      glDepthMask(GL_TRUE);
+      glDisable(GL_BLEND);
+      clearFramebuffer();
+      renderGeometry(snapshot);
+    });
+    return gBuffer;
+  }
 
-    // Keep track of material&mesh combinations and their associated model matrices
-    std::unordered_map<std::shared_ptr<Assets::Material>, std::unordered_map<std::shared_ptr<Assets::Mesh>, std::vector<glm::mat4>>> renderMap;
+  void RenderingEngine::renderGeometry(RenderSnapshot const &snapshot)
+  {
+    // Keep track of material&mesh combinations and their associated model matrices, per LOD level
+    std::unordered_map<std::shared_ptr<Assets::Material>, std::unordered_map<std::shared_ptr<Assets::Mesh>, std::map<unsigned int, std::vector<glm::mat4>>>> renderMap;
+    std::unordered_map<std::shared_ptr<Assets::Impostor>, std::vector<glm::mat4>> impostorMap;
 
     // Prepare each mesh attached to gameobjects with mesh renderers
-    auto meshRenderers = scene.getComponents<Components::MeshRenderer>();
-    for (auto meshRenderer : meshRenderers) {
-      auto gameObject = meshRenderer->mGameObject;
+    for (auto &meshInstance : snapshot.mMeshes) {
+      auto meshRenderer = meshInstance.mMeshRenderer;
+      auto &gameObject = meshRenderer->mGameObject;
       auto material = meshRenderer->mMaterial;
-      if (renderMap.find(material) == renderMap.end()) {
-        renderMap[material] = std::unordered_map<std::shared_ptr<Assets::Mesh>, std::vector<glm::mat4>>();
+      auto &modelMatrix = meshInstance.mModelMatrix;
+
+      std::vector<std::shared_ptr<Assets::Mesh>> meshes;
+      for (auto meshFilter : gameObject.getComponents<Components::MeshFilter>()) {
+        meshes.push_back(meshFilter->mMesh);
       }
+      selectLod(*meshRenderer, meshes, modelMatrix, mRenderHeight);
 
-      auto meshFilters = meshRenderer->mGameObject.getComponents<Components::MeshFilter>();
-      for (auto meshFilter : meshFilters) {
-        auto mesh = meshFilter->mMesh;
-        if (renderMap[material].find(mesh) == renderMap[material].end()) {
-          renderMap[material][mesh] = std::vector<glm::mat4>();
+      unsigned int meshLodCount = 0;
+      for (auto &mesh : meshes) {
+        meshLodCount = std::max(meshLodCount, mesh->getLodCount());
+      }
+      auto impostor = meshRenderer->mImpostor;
+      if (impostor && meshRenderer->mLodLevel >= meshLodCount) {
+        // Impostors are baked the first time they are needed
+        if (!impostor->isBaked()) {
+          bakeImpostor(*impostor, meshes, material);
+          mRenderGraph.bindPassTarget();
         }
-        renderMap[material][mesh].push_back(gameObject.mTransform->mModelMatrix);
+        impostorMap[impostor].push_back(modelMatrix);
+        continue;
+      }
+
+      for (auto &mesh : meshes) {
+        renderMap[material][mesh][meshRenderer->mLodLevel].push_back(modelMatrix);
+      }
+    }
+
+    // Wheels of every vehicle are batched with the meshes, giving one instanced draw per wheel mesh and LOD
+    for (auto &wheelInstance : snapshot.mWheels) {
+      auto wheelMeshRenderer = wheelInstance.mWheelMeshRenderer;
+      // Wheels follow the LOD picked for the body they belong to
+      unsigned int lod = wheelInstance.mBodyMeshRenderer ? wheelInstance.mBodyMeshRenderer->mLodLevel : 0;
+      for (size_t i = 0; i < wheelMeshRenderer->mWheelMeshes.size(); i++) {
+        renderMap[wheelMeshRenderer->mMaterial][wheelMeshRenderer->mWheelMeshes[i]][lod].push_back(wheelInstance.mModelMatrices[i]);
       }
     }
 
@@ -302,35 +421,47 @@ namespace Rendering
       setCameraUniforms(material->mGeometryShader);
       for (auto innerIt = it->second.begin(); innerIt != it->second.end(); innerIt++) {
         auto mesh = innerIt->first;
-        auto modelMatrices = innerIt->second;
-
-        mDrawCalls++;
-        mesh->drawInstanced(modelMatrices);
+        for (auto &lodMatrices : innerIt->second) {
+          mDrawCalls++;
+          mesh->drawInstanced(lodMatrices.second, lodMatrices.first);
+        }
       }
     }
-  
-    // Render wheels
-    auto wheelMeshRenderers = scene.getComponents<Components::WheelMeshRenderer>();
-    for (auto wheelMeshRenderer : wheelMeshRenderers) {
-      // Prepare for draw
-      auto material = wheelMeshRenderer->mMaterial;
-      prepareMaterialForRender(material);
-      setCameraUniforms(material->mGeometryShader);
-      
-      // Prepare model matrices
-      std::vector<glm::mat4> modelMatrices;
-      for (int i = 0; i < wheelMeshRenderer->mWheelMeshes.size(); i++) {
-        std::vector<glm::mat4> modelMatrices { wheelMeshRenderer->mWheelModelMatrices[i] };
 
+    // Render impostors
+    if (!impostorMap.empty()) {
+      mImpostorShader->use();
+      mImpostorShader->setMat4("projection", mProjectionMtx);
+      mImpostorShader->setMat4("view", mViewMtx);
+      mImpostorShader->setInt("positionAtlas", 0);
+      mImpostorShader->setInt("normalAtlas", 1);
+      mImpostorShader->setInt("albedoSpecAtlas", 2);
+      glBindVertexArray(mImpostorVAO);
+      for (auto &impostorMatrices : impostorMap) {
+        auto &impostor = *impostorMatrices.first;
+        auto &modelMatrices = impostorMatrices.second;
+        mImpostorShader->setVec3("center", impostor.mCenter);
+        mImpostorShader->setFloat("radius", impostor.mRadius);
+        mImpostorShader->setInt("frameCount", impostor.mFrameCount);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, impostor.mPositionID);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, impostor.mNormalID);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, impostor.mAlbedoSpecID);
+
+        glBindBuffer(GL_ARRAY_BUFFER, mImpostorInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4)*modelMatrices.size(), &modelMatrices[0], GL_STREAM_DRAW);
         mDrawCalls++;
-        wheelMeshRenderer->mWheelMeshes[i]->drawInstanced(modelMatrices);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, modelMatrices.size());
       }
+      glBindVertexArray(0);
     }
-
+  
     // Render terrains
     glPatchParameteri(GL_PATCH_VERTICES, 4);
-    auto terrainRenderers = scene.getComponents<Components::TerrainRenderer>();
-    for (auto terrainRenderer : terrainRenderers) {
+    for (auto &terrainInstance : snapshot.mTerrains) {
+      auto terrainRenderer = terrainInstance.mTerrainRenderer;
       // Bind per-instance data to terrain VAO
       glBindVertexArray(mTerrainVAO);
       glBindBuffer(GL_ARRAY_BUFFER, terrainRenderer->mInstanceVBO);
@@ -343,29 +474,352 @@ namespace Rendering
 
       // Prepare for draw
       auto material = terrainRenderer->mMaterial;
+      material->mGeometryShader->setPermutation(getTerrainPermutation(snapshot.mRenderSettings.mTerrainRenderMode));
       prepareMaterialForRender(material);
-      setTerrainUniforms(material->mGeometryShader, scene, terrainRenderer);
+      setTerrainUniforms(material->mGeometryShader, terrainRenderer);
       setCameraUniforms(material->mGeometryShader);
-      setModelUniforms(material->mGeometryShader, scene, terrainRenderer->mGameObject);
+      setModelUniforms(material->mGeometryShader, terrainInstance.mModelMatrix);
       
       // Draw
       mDrawCalls++;
       glDrawElementsInstanced(GL_PATCHES, terrainN, GL_UNSIGNED_INT, 0, terrainRenderer->mPatchesX*terrainRenderer->mPatchesZ);
     }
+  }
 
-    // ***** SECOND PASS PREP *****
-    // Make gBuffer information available
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, mGPositionID);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, mGNormalID);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, mGAlbedoSpecID);
+  void RenderingEngine::addLowResLightingPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer, int downsample,
+                                              RenderGraph::Resource &diffuse, RenderGraph::Resource &specular)
+  {
+    mRenderGraph.addPass("Low resolution lighting", [&](RenderGraph::PassBuilder &builder) {
+      builder.read(gBuffer.mPosition);
+      builder.read(gBuffer.mNormal);
+      TextureDesc desc = mRenderGraph.getDesc(gBuffer.mPosition);
+      int width = (desc.mWidth + downsample - 1) / downsample;
+      int height = (desc.mHeight + downsample - 1) / downsample;
+      diffuse = builder.write(builder.createTexture("Low resolution diffuse", {width, height, GL_RGB16F, GL_NEAREST}));
+      specular = builder.write(builder.createTexture("Low resolution specular", {width, height, GL_RGB16F, GL_NEAREST}));
+      builder.setRenderArea((mRenderWidth + downsample - 1) / downsample, (mRenderHeight + downsample - 1) / downsample);
+    }, [this, &snapshot, gBuffer, downsample]() {
+      // Every texel in the render area is written, so no clear is needed
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mPosition));
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mNormal));
+
+      mLightingShader->setPermutation(Rendering::LIGHTING_LOW_RESOLUTION);
+      mLightingShader->use();
+      mLightingShader->setInt("positionTexture", 0);
+      mLightingShader->setInt("normalTexture", 1);
+      mLightingShader->setInt("downsample", downsample);
+      mLightingShader->setVec2("renderSize", glm::vec2(mRenderWidth, mRenderHeight));
+      mLightingShader->setVec2("scale", 1.0f, 1.0f);
+      mLightingShader->setVec2("offset", 0.0f, 0.0f);
+      setLightingUniforms(snapshot);
+      drawQuad();
+    });
+  }
+
+  RenderGraph::Resource RenderingEngine::addLightingPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer)
+  {
+    // Reduced-rate lighting is upsampled into the full resolution composite below
+    int downsample = snapshot.mRenderSettings.mLightingResolution;
+    RenderGraph::Resource diffuse = -1, specular = -1;
+    if (downsample > 1) {
+      addLowResLightingPass(snapshot, gBuffer, downsample, diffuse, specular);
+    }
+
+    RenderGraph::Resource sceneColor;
+    mRenderGraph.addPass("Lighting", [&](RenderGraph::PassBuilder &builder) {
+      builder.read(gBuffer.mPosition);
+      builder.read(gBuffer.mNormal);
+      builder.read(gBuffer.mAlbedoSpec);
+      if (downsample > 1) {
+        builder.read(diffuse);
+        builder.read(specular);
+      }
+      TextureDesc desc = mRenderGraph.getDesc(gBuffer.mPosition);
+      // Kept in linear HDR until post-processing tonemaps it
+      sceneColor = builder.write(builder.createTexture("Scene color", {desc.mWidth, desc.mHeight, GL_RGB16F, GL_NEAREST}));
+      builder.setRenderArea(mRenderWidth, mRenderHeight);
+    }, [this, &snapshot, gBuffer, downsample, diffuse, specular]() {
+      // Make gBuffer information available
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mPosition));
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mNormal));
+      glActiveTexture(GL_TEXTURE2);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mAlbedoSpec));
+      if (downsample > 1) {
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(diffuse));
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(specular));
+      }
+      clearFramebuffer();
+
+      // Draw skybox
+      snapshot.mCubeMap->mShader->use();
+      setCameraUniforms(snapshot.mCubeMap->mShader);
+      mDrawCalls++;
+      snapshot.mCubeMap->draw();
+
+      // Draw main scene
+      mLightingShader->setPermutation(downsample > 1 ? Rendering::LIGHTING_UPSAMPLE : 0);
+      mLightingShader->use();
+      mLightingShader->setInt("positionTexture", 0);
+      mLightingShader->setInt("normalTexture", 1);
+      mLightingShader->setInt("albedoSpecTexture", 2);
+      if (downsample > 1) {
+        mLightingShader->setInt("diffuseTexture", 3);
+        mLightingShader->setInt("specularTexture", 4);
+        mLightingShader->setInt("downsample", downsample);
+        mLightingShader->setVec2("renderSize", glm::vec2(mRenderWidth, mRenderHeight));
+      }
+      mLightingShader->setVec2("scale", 1.0f, 1.0f);
+      mLightingShader->setVec2("offset", 0.0f, 0.0f);
+      mLightingShader->setVec2("texCoordScale", getTexCoordScale(snapshot));
+      setLightingUniforms(snapshot);
+      drawQuad();
+    });
+    return sceneColor;
+  }
+
+  RenderGraph::Resource RenderingEngine::addOverlayPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer, RenderGraph::Resource sceneColor)
+  {
+    // Forward-rendered on top of the lit scene, depth tested against the gBuffer depth in place
+    mRenderGraph.addPass("Overlays", [&](RenderGraph::PassBuilder &builder) {
+      builder.write(sceneColor);
+      builder.writeDepth(gBuffer.mDepth);
+      builder.setRenderArea(mRenderWidth, mRenderHeight);
+    }, [this, &snapshot]() {
+      glEnable(GL_DEPTH_TEST);
+
+      // Draw physics and light debugging lines if enabled
+      if (snapshot.mRenderSettings.mDrawDebugLines) {
+        // Set uniforms
+        mDebugRenderer->mShader->use();
+        setCameraUniforms(mDebugRenderer->mShader);
 
-    // ***** DEBUG PASS *****
-    if (scene.mRenderSettings.mRenderMode == Rendering::RenderMode::DEBUG) {
-      // Do not use post-processing renders in deferred rendering debug
+        // Draw
+        mDrawCalls++;
+        mDebugRenderer->draw(snapshot.mDebugLines);
+      }
+
+      // Render full resolution particles
+      glEnable(GL_BLEND);
+      glDepthMask(GL_FALSE);
+      renderParticles(snapshot, false);
+      glDepthMask(GL_TRUE);
+      glDisable(GL_BLEND);
+    });
+    return sceneColor;
+  }
+
+  RenderGraph::Resource RenderingEngine::addHalfResParticlePasses(RenderSnapshot const &snapshot, GBuffer const &gBuffer, RenderGraph::Resource sceneColor)
+  {
+    if (!hasActiveParticles(snapshot, true)) {
+      return sceneColor;
+    }
+
+    // Depth at half resolution, keeping the farthest sample of each block
+    TextureDesc desc = mRenderGraph.getDesc(gBuffer.mDepth);
+    int width = (desc.mWidth + PARTICLE_DOWNSAMPLE - 1) / PARTICLE_DOWNSAMPLE;
+    int height = (desc.mHeight + PARTICLE_DOWNSAMPLE - 1) / PARTICLE_DOWNSAMPLE;
+    int renderWidth = (mRenderWidth + PARTICLE_DOWNSAMPLE - 1) / PARTICLE_DOWNSAMPLE;
+    int renderHeight = (mRenderHeight + PARTICLE_DOWNSAMPLE - 1) / PARTICLE_DOWNSAMPLE;
+    RenderGraph::Resource particleDepth;
+    mRenderGraph.addPass("Particle depth downsample", [&](RenderGraph::PassBuilder &builder) {
+      builder.read(gBuffer.mDepth);
+      particleDepth = builder.writeDepth(builder.createTexture("Particle depth", {width, height, GL_DEPTH_COMPONENT32F, GL_NEAREST}));
+      builder.setRenderArea(renderWidth, renderHeight);
+    }, [this, gBuffer]() {
+      // Every texel in the render area is written, so no clear is needed
+      glEnable(GL_DEPTH_TEST);
+      glDepthFunc(GL_ALWAYS);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mDepth));
+
+      mDepthDownsampleShader->use();
+      mDepthDownsampleShader->setInt("depthTexture", 0);
+      mDepthDownsampleShader->setInt("downsample", PARTICLE_DOWNSAMPLE);
+      mDepthDownsampleShader->setVec2("renderSize", glm::vec2(mRenderWidth, mRenderHeight));
+      mDepthDownsampleShader->setVec2("scale", 1.0f, 1.0f);
+      mDepthDownsampleShader->setVec2("offset", 0.0f, 0.0f);
+      drawQuad();
+      glDepthFunc(GL_LESS);
+    });
+
+    // Particles accumulate premultiplied color, with the transmittance of everything drawn so far in alpha
+    RenderGraph::Resource particleColor;
+    mRenderGraph.addPass("Half resolution particles", [&](RenderGraph::PassBuilder &builder) {
+      particleColor = builder.write(builder.createTexture("Particle color", {width, height, GL_RGBA16F, GL_LINEAR}));
+      builder.writeDepth(particleDepth);
+      builder.setRenderArea(renderWidth, renderHeight);
+    }, [this, &snapshot]() {
+      GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+      glClearBufferfv(GL_COLOR, 0, clearColor);
+
+      glEnable(GL_DEPTH_TEST);
+      glDepthMask(GL_FALSE);
+      glEnable(GL_BLEND);
+      glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+      renderParticles(snapshot, true);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glDisable(GL_BLEND);
+      glDepthMask(GL_TRUE);
+    });
+
+    // Upsample over the scene, picking the low resolution texel nearest in depth across edges
+    mRenderGraph.addPass("Particle composite", [&](RenderGraph::PassBuilder &builder) {
+      builder.read(particleColor);
+      builder.read(particleDepth);
+      builder.read(gBuffer.mDepth);
+      builder.write(sceneColor);
+      builder.setRenderArea(mRenderWidth, mRenderHeight);
+    }, [this, gBuffer, particleColor, particleDepth]() {
+      glDisable(GL_DEPTH_TEST);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(particleColor));
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(particleDepth));
+      glActiveTexture(GL_TEXTURE2);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mDepth));
+
+      mParticleCompositeShader->use();
+      mParticleCompositeShader->setInt("particleTexture", 0);
+      mParticleCompositeShader->setInt("particleDepthTexture", 1);
+      mParticleCompositeShader->setInt("depthTexture", 2);
+      mParticleCompositeShader->setMat4("projection", mProjectionMtx);
+      mParticleCompositeShader->setInt("downsample", PARTICLE_DOWNSAMPLE);
+      mParticleCompositeShader->setVec2("renderSize", glm::vec2(mRenderWidth, mRenderHeight));
+      mParticleCompositeShader->setVec2("scale", 1.0f, 1.0f);
+      mParticleCompositeShader->setVec2("offset", 0.0f, 0.0f);
+
+      // Scene color is scaled by the particles' transmittance before their color is added
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_ONE, GL_SRC_ALPHA);
+      drawQuad();
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glDisable(GL_BLEND);
+    });
+    return sceneColor;
+  }
+
+  void RenderingEngine::renderParticles(RenderSnapshot const &snapshot, bool halfResolution)
+  {
+    for (auto &emitter : snapshot.mParticleEmitters) {
+      auto particleSystemRenderer = emitter.mParticleSystemRenderer;
+      if (!emitter.mReset && particleSystemRenderer->mParticleSystem->mHalfResolution == halfResolution) {
+        auto textures = particleSystemRenderer->mParticleSystem->mTextures;
+        auto renderShader = particleSystemRenderer->mParticleSystem->mRenderShader;
+        renderShader->use();
+        renderShader->setFloat("particleLifetime", particleSystemRenderer->mParticleSystem->mParticleLifetime);
+        renderShader->setVec2("initialParticleSize", particleSystemRenderer->mParticleSystem->mInitialParticleSize);
+        renderShader->setVec2("finalParticleSize", particleSystemRenderer->mParticleSystem->mFinalParticleSize);
+
+        // Bind albedo textures
+        for (size_t i = 0; i < textures.size(); i++) {
+          glActiveTexture(GL_TEXTURE0 + i);
+          renderShader->setInt("albedoMap" + std::to_string(i), i);
+          glBindTexture(GL_TEXTURE_2D, textures[i]->mID);
+        }
+        
+        setCameraUniforms(renderShader);
+        mDrawCalls++;
+        particleSystemRenderer->draw();
+      }
+    }
+  }
+
+  bool RenderingEngine::hasActiveParticles(RenderSnapshot const &snapshot, bool halfResolution)
+  {
+    for (auto &emitter : snapshot.mParticleEmitters) {
+      if (!emitter.mReset && emitter.mParticleSystemRenderer->mParticleSystem->mHalfResolution == halfResolution) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  RenderGraph::Resource RenderingEngine::addPostProcessPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer, RenderGraph::Resource sceneColor)
+  {
+    RenderGraph::Resource output;
+    mRenderGraph.addPass("Post-process", [&](RenderGraph::PassBuilder &builder) {
+      builder.read(sceneColor);
+      builder.read(gBuffer.mPosition);
+      TextureDesc target = mRenderGraph.getDesc(mRenderGraph.getBackbuffer());
+      output = builder.writeStorage(builder.createTexture("Post-process output", {target.mWidth, target.mHeight, GL_RGBA8, GL_NEAREST}));
+    }, [this, &snapshot, gBuffer, sceneColor]() {
+      // The graph binds the output to image unit 0
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(sceneColor));
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mPosition));
+
+      unsigned int permutation = 0;
+      if (snapshot.mRenderSettings.mFXAARenderMode != Rendering::FXAARenderMode::NONE) {
+        permutation |= Rendering::POST_PROCESS_FXAA;
+      }
+      if (snapshot.mRenderSettings.mFXAARenderMode == Rendering::FXAARenderMode::FXAA_AND_DEBUG) {
+        permutation |= Rendering::POST_PROCESS_SHOW_EDGES;
+      }
+      mPostProcessShader->setPermutation(permutation);
+      mPostProcessShader->use();
+      mPostProcessShader->setInt("colorTexture", 0);
+      mPostProcessShader->setInt("positionTexture", 1);
+      mPostProcessShader->setVec2("renderSize", glm::vec2(mRenderWidth, mRenderHeight));
+      mPostProcessShader->setVec2("sourceScale", getTexCoordScale(snapshot));
+
+      // Fog fades to the clear color
+      mPostProcessShader->setVec3("viewPos", snapshot.mViewPosition);
+      mPostProcessShader->setVec3("fogColor", glm::vec3(0.3f, 0.7f, 0.8f));
+      mPostProcessShader->setFloat("fogDensity", snapshot.mRenderSettings.mFogDensity);
+
+      mPostProcessShader->setFloat("exposure", snapshot.mRenderSettings.mExposure);
+      mPostProcessShader->setFloat("contrast", snapshot.mRenderSettings.mContrast);
+      mPostProcessShader->setFloat("saturation", snapshot.mRenderSettings.mSaturation);
+
+      mPostProcessShader->setFloat("lumaThreshold", 0.5f);
+      mPostProcessShader->setFloat("mulReduce", 1.0f/8.0f);
+      mPostProcessShader->setFloat("minReduce", 1.0f/128.0f);
+      mPostProcessShader->setFloat("maxSpan", 8.0f);
+
+      TextureDesc target = mRenderGraph.getDesc(mRenderGraph.getBackbuffer());
+      glDispatchCompute((target.mWidth + POST_PROCESS_TILE_SIZE - 1) / POST_PROCESS_TILE_SIZE,
+                        (target.mHeight + POST_PROCESS_TILE_SIZE - 1) / POST_PROCESS_TILE_SIZE, 1);
+    });
+    return output;
+  }
+
+  void RenderingEngine::addPresentPass(RenderGraph::Resource image)
+  {
+    // Compute shaders cannot write the default framebuffer, so the post-processed image is copied over
+    mRenderGraph.addPass("Present", [&](RenderGraph::PassBuilder &builder) {
+      builder.read(image);
+      builder.write(mRenderGraph.getBackbuffer());
+    }, [this, image]() {
+      TextureDesc desc = mRenderGraph.getDesc(image);
+      TextureDesc target = mRenderGraph.getDesc(mRenderGraph.getBackbuffer());
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, mRenderGraph.getFramebuffer(image));
+      glBlitFramebuffer(0, 0, desc.mWidth, desc.mHeight, 0, 0, target.mWidth, target.mHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
       glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    });
+  }
+
+  void RenderingEngine::addGBufferDebugPass(RenderSnapshot const &snapshot, GBuffer const &gBuffer)
+  {
+    // Do not use post-processing renders in deferred rendering debug
+    mRenderGraph.addPass("GBuffer debug", [&](RenderGraph::PassBuilder &builder) {
+      builder.read(gBuffer.mPosition);
+      builder.read(gBuffer.mNormal);
+      builder.read(gBuffer.mAlbedoSpec);
+      builder.write(mRenderGraph.getBackbuffer());
+    }, [this, &snapshot, gBuffer]() {
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mPosition));
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mNormal));
+      glActiveTexture(GL_TEXTURE2);
+      glBindTexture(GL_TEXTURE_2D, mRenderGraph.getTexture(gBuffer.mAlbedoSpec));
       clearFramebuffer();
 
       // Draw positions in top-left
@@ -373,6 +827,7 @@ namespace Rendering
       mDebugPositionShader->setInt("positionTexture", 0);
       mDebugPositionShader->setVec2("scale", 0.5f, 0.5f);
       mDebugPositionShader->setVec2("offset", -0.5f, 0.5f);
+      mDebugPositionShader->setVec2("texCoordScale", getTexCoordScale(snapshot));
       drawQuad();
 
       // Draw normals in top-right
@@ -381,6 +836,7 @@ namespace Rendering
       mDebugNormalShader->setInt("normalTexture", 1);
       mDebugNormalShader->setVec2("scale", 0.5f, 0.5f);
       mDebugNormalShader->setVec2("offset", 0.5f, 0.5f);
+      mDebugNormalShader->setVec2("texCoordScale", getTexCoordScale(snapshot));
       drawQuad();
 
       // Draw albedo colors in bottom-left
@@ -388,6 +844,7 @@ namespace Rendering
       mDebugAlbedoShader->setInt("albedoSpecTexture", 2);
       mDebugAlbedoShader->setVec2("scale", 0.5f, 0.5f);
       mDebugAlbedoShader->setVec2("offset", -0.5f, -0.5f);
+      mDebugAlbedoShader->setVec2("texCoordScale", getTexCoordScale(snapshot));
       drawQuad();
 
       // Draw specular intensities in bottom-right
@@ -395,149 +852,172 @@ namespace Rendering
       mDebugSpecShader->setInt("albedoSpecTexture", 2);
       mDebugSpecShader->setVec2("scale", 0.5f, 0.5f);
       mDebugSpecShader->setVec2("offset", 0.5f, -0.5f);
+      mDebugSpecShader->setVec2("texCoordScale", getTexCoordScale(snapshot));
       drawQuad();
-    }
-
-    // ***** LIGHTING PASS *****
-    if (scene.mRenderSettings.mRenderMode == Rendering::RenderMode::DEFERRED_SHADING) {
-      // Render to lighting buffer if post-processing is necessary
-      // Otherwise, render directly to default framebuffer
-      if (scene.mRenderSettings.mFXAARenderMode != Rendering::FXAARenderMode::NONE) {
-        glBindFramebuffer(GL_FRAMEBUFFER, mLBufferID);
-      }
-      else {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-      }
-      clearFramebuffer();
+    });
+  }
 
-      // Draw skybox
-      scene.mCubeMap.mShader->use();
-      setCameraUniforms(scene.mCubeMap.mShader);
-      mDrawCalls++;
-      scene.mCubeMap.draw();
+  void RenderingEngine::addUIPass(RenderSnapshot const &snapshot)
+  {
+    mRenderGraph.addPass("UI", [&](RenderGraph::PassBuilder &builder) {
+      builder.write(mRenderGraph.getBackbuffer());
+    }, [this, &snapshot]() {
+      glEnable(GL_BLEND);
+      glDisable(GL_DEPTH_TEST);
+
+      // Start text renderer at bottom
+      mTextRenderer->resetVerticalOffset();
+
+      // Render FPS as string
+      std::ostringstream fpsOSS;
+      fpsOSS << std::fixed << std::setprecision(5) << "FPS: " << snapshot.mRollingFPS;
+      mTextRenderer->renderText(fpsOSS.str(), 1, snapshot.mRenderSettings.mFramebufferWidth, snapshot.mRenderSettings.mFramebufferHeight, glm::vec3(1.0f, 1.0f, 1.0f));
+
+      // Render draw calls as string
+      std::ostringstream drawCallsOSS;
+      drawCallsOSS << std::fixed << std::setprecision(5) << "Draw Calls: " << mDrawCalls;
+      mTextRenderer->renderText(drawCallsOSS.str(), 1, snapshot.mRenderSettings.mFramebufferWidth, snapshot.mRenderSettings.mFramebufferHeight, glm::vec3(1.0f, 1.0f, 1.0f));
+
+      // Render resolution scale and measured GPU time as string
+      std::ostringstream resolutionOSS;
+      resolutionOSS << std::fixed << std::setprecision(2) << "Render Scale: " << mDynamicResolution->getScale()
+                    << " (GPU " << mDynamicResolution->getGPUTime()*1000.0 << " ms)";
+      mTextRenderer->renderText(resolutionOSS.str(), 1, snapshot.mRenderSettings.mFramebufferWidth, snapshot.mRenderSettings.mFramebufferHeight, glm::vec3(1.0f, 1.0f, 1.0f));
+    });
+  }
 
-      // Draw main scene
-      mLightingShader->use();
-      mLightingShader->setInt("positionTexture", 0);
-      mLightingShader->setInt("normalTexture", 1);
-      mLightingShader->setInt("albedoSpecTexture", 2);
-      mLightingShader->setVec2("scale", 1.0f, 1.0f);
-      mLightingShader->setVec2("offset", 0.0f, 0.0f);
-      setLightingUniforms(scene);
-      drawQuad();
+  void RenderingEngine::selectLod(Components::MeshRenderer &meshRenderer, std::vector<std::shared_ptr<Assets::Mesh>> const &meshes,
+                                  glm::mat4 const &modelMatrix, float framebufferHeight)
+  {
+    if (meshes.empty()) {
+      return;
+    }
 
-      // Use FXAA if enabled
-      if (scene.mRenderSettings.mFXAARenderMode != Rendering::FXAARenderMode::NONE) {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        clearFramebuffer();
+    // Pixels per object-space unit at the object's depth, folding in the largest scale axis
+    float scale = std::max(glm::length(glm::vec3(modelMatrix[0])),
+                  std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+    glm::vec4 clipCenter = mProjectionMtx * mViewMtx * modelMatrix * glm::vec4((meshes[0]->mBoundsMin + meshes[0]->mBoundsMax) * 0.5f, 1.0f);
+    float pixelsPerUnit = clipCenter.w > 0.0f ? scale * mProjectionMtx[1][1] / clipCenter.w * framebufferHeight * 0.5f : 0.0f;
+
+    unsigned int levelCount = 0;
+    float radius = 0.0f;
+    for (auto &mesh : meshes) {
+      levelCount = std::max(levelCount, mesh->getLodCount());
+      radius = std::max(radius, mesh->getBoundingRadius());
+    }
+    bool hasImpostor = meshRenderer.mImpostor != nullptr;
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, mLColorID);
-
-        mFXAAShader->use();
-        mFXAAShader->setInt("colorTexture", 0);
-        mFXAAShader->setVec2("texelStep", glm::vec2(
-          1.0f / scene.mRenderSettings.mFramebufferWidth, 1.0f / scene.mRenderSettings.mFramebufferHeight));
-        mFXAAShader->setBool("showEdges", scene.mRenderSettings.mFXAARenderMode == Rendering::FXAARenderMode::FXAA_AND_DEBUG);
-        mFXAAShader->setFloat("lumaThreshold", 0.5f);
-        mFXAAShader->setFloat("mulReduce", 1.0f/8.0f);
-        mFXAAShader->setFloat("minReduce", 1.0f/128.0f);
-        mFXAAShader->setFloat("maxSpan", 8.0f);
-
-        mFXAAShader->setVec2("scale", 1.0f, 1.0f);
-        mFXAAShader->setVec2("offset", 0.0f, 0.0f);
-        drawQuad();
+    // Coarsest level whose worst error across the meshes stays within the pixel budget
+    auto chooseLevel = [&](float threshold) {
+      if (hasImpostor && radius*pixelsPerUnit < IMPOSTOR_PIXEL_RADIUS*threshold) {
+        return levelCount;
       }
-
-      // Draw physics debugging lines if enabled
-      if (scene.mRenderSettings.mDrawDebugLines) {
-        // Add debug lines for spot lights
-        for (auto &spotLight : scene.getComponents<Components::SpotLight>()) {
-          auto transform = spotLight->mGameObject.mTransform;
-          mDebugRenderer->drawLine(
-            Utils::TransformConversions::glmVec32btVector3(transform->getWorldTranslation()),
-            Utils::TransformConversions::glmVec32btVector3(transform->getWorldTranslation() + spotLight->getDirection()),
-            btVector3(1.0, 1.0, 1.0));
+      unsigned int level = 0;
+      for (unsigned int lod = 1; lod < levelCount; lod++) {
+        float error = 0.0f;
+        for (auto &mesh : meshes) {
+          error = std::max(error, mesh->getLod(lod).mError * mesh->getBoundingRadius());
         }
-
-        // Copy depth buffer from gBuffer to default framebuffer
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, mGBufferID);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
-        glBlitFramebuffer(
-          0, 0, scene.mRenderSettings.mFramebufferWidth, scene.mRenderSettings.mFramebufferHeight,
-          0, 0, scene.mRenderSettings.mFramebufferWidth, scene.mRenderSettings.mFramebufferHeight,
-          GL_DEPTH_BUFFER_BIT, GL_NEAREST
-        );
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // Set uniforms
-        mDebugRenderer->mShader->use();
-        setCameraUniforms(mDebugRenderer->mShader);
-
-        // Draw
-        mDrawCalls++;
-        mDebugRenderer->drawAccumulated();
-      }
-      mDebugRenderer->clear();
-
-      // Render particles
-      glEnable(GL_BLEND);
-      glDepthMask(GL_FALSE);
-      auto particleSystemRenderers = scene.getComponents<Components::ParticleSystemRenderer>();
-      for (auto particleSystemRenderer : particleSystemRenderers) {
-        if (particleSystemRenderer->mIsActive) {
-          auto textures = particleSystemRenderer->mParticleSystem->mTextures;
-          auto renderShader = particleSystemRenderer->mParticleSystem->mRenderShader;
-          renderShader->use();
-          renderShader->setFloat("particleLifetime", particleSystemRenderer->mParticleSystem->mParticleLifetime);
-          renderShader->setVec2("initialParticleSize", particleSystemRenderer->mParticleSystem->mInitialParticleSize);
-          renderShader->setVec2("finalParticleSize", particleSystemRenderer->mParticleSystem->mFinalParticleSize);
-
-          // Bind albedo textures
-          for (int i = 0; i < textures.size(); i++) {
-            glActiveTexture(GL_TEXTURE0 + i);
-            renderShader->setInt("albedoMap" + std::to_string(i), i);
-            glBindTexture(GL_TEXTURE_2D, textures[i]->mID);
-          }
-          
-          setCameraUniforms(renderShader);
-          mDrawCalls++;
-          particleSystemRenderer->draw();
+        if (error*pixelsPerUnit > LOD_PIXEL_ERROR*threshold) {
+          break;
         }
+        level = lod;
       }
-    }
+      return level;
+    };
 
+    unsigned int coarser = chooseLevel(LOD_HYSTERESIS);
+    unsigned int finer = chooseLevel(1.0f);
+    if (coarser > meshRenderer.mLodLevel) {
+      meshRenderer.mLodLevel = coarser;
+    }
+    else if (finer < meshRenderer.mLodLevel) {
+      meshRenderer.mLodLevel = finer;
+    }
+  }
 
-    // ***** RENDER UI *****
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glEnable(GL_BLEND);
-    glDisable(GL_DEPTH_TEST);
-
-    // Start text renderer at bottom
-    mTextRenderer->resetVerticalOffset();
+  void RenderingEngine::bakeImpostor(Assets::Impostor &impostor, std::vector<std::shared_ptr<Assets::Mesh>> const &meshes,
+                                     std::shared_ptr<Assets::Material> material)
+  {
+    if (meshes.empty()) {
+      return;
+    }
 
-    // Render FPS as string
-    std::ostringstream fpsOSS;
-    fpsOSS << std::fixed << std::setprecision(5) << "FPS: " << rollingFPS;
-    mTextRenderer->renderText(fpsOSS.str(), 1, scene.mRenderSettings.mFramebufferWidth, scene.mRenderSettings.mFramebufferHeight, glm::vec3(1.0f, 1.0f, 1.0f));
+    // Bounding sphere around every mesh
+    glm::vec3 boundsMin = meshes[0]->mBoundsMin;
+    glm::vec3 boundsMax = meshes[0]->mBoundsMax;
+    for (auto &mesh : meshes) {
+      boundsMin = glm::min(boundsMin, mesh->mBoundsMin);
+      boundsMax = glm::max(boundsMax, mesh->mBoundsMax);
+    }
+    impostor.mCenter = (boundsMin + boundsMax) * 0.5f;
+    impostor.mRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+
+    // Atlas textures match the gBuffer layout, one frame per view along a row
+    int atlasWidth = impostor.mFrameCount*impostor.mFrameSize;
+    int atlasHeight = impostor.mFrameSize;
+    GLuint framebuffer, depthbuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    glGenTextures(1, &impostor.mPositionID);
+    glBindTexture(GL_TEXTURE_2D, impostor.mPositionID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, atlasWidth, atlasHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, impostor.mPositionID, 0);
+
+    glGenTextures(1, &impostor.mNormalID);
+    glBindTexture(GL_TEXTURE_2D, impostor.mNormalID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, atlasWidth, atlasHeight, 0, GL_RGB, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, impostor.mNormalID, 0);
+
+    glGenTextures(1, &impostor.mAlbedoSpecID);
+    glBindTexture(GL_TEXTURE_2D, impostor.mAlbedoSpecID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, impostor.mAlbedoSpecID, 0);
+
+    glGenRenderbuffers(1, &depthbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasWidth, atlasHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
 
-    // Render draw calls as string
-    std::ostringstream drawCallsOSS;
-    drawCallsOSS << std::fixed << std::setprecision(5) << "Draw Calls: " << mDrawCalls;
-    mTextRenderer->renderText(drawCallsOSS.str(), 1, scene.mRenderSettings.mFramebufferWidth, scene.mRenderSettings.mFramebufferHeight, glm::vec3(1.0f, 1.0f, 1.0f));
-  }
+    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, attachments);
+    Utils::OpenGLErrors::checkFramebufferComplete();
 
-  void RenderingEngine::calculateCameraUniforms(Core::Scene const &scene)
-  {
-    auto camera = scene.getComponents<Components::Camera>()[0];
+    // Zero position w marks texels the object does not cover
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, atlasWidth, atlasHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Set projection matrix
-    float aspectRatio = scene.mRenderSettings.mFramebufferWidth / scene.mRenderSettings.mFramebufferHeight;
-    mProjectionMtx = camera->getProjectionMatrix(aspectRatio);
+    // Orthographic views from evenly spaced directions around the vertical axis, in object space
+    prepareMaterialForRender(material);
+    float radius = impostor.mRadius;
+    glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 4.0f*radius);
+    std::vector<glm::mat4> identity { glm::mat4(1.0f) };
+    for (unsigned int frame = 0; frame < impostor.mFrameCount; frame++) {
+      float azimuth = glm::radians(360.0f)*frame/impostor.mFrameCount;
+      glm::vec3 direction(glm::sin(azimuth), 0.0f, glm::cos(azimuth));
+      glm::mat4 view = glm::lookAt(impostor.mCenter + direction*2.0f*radius, impostor.mCenter, glm::vec3(0, 1, 0));
+
+      material->mGeometryShader->setMat4("projection", projection);
+      material->mGeometryShader->setMat4("view", view);
+      glViewport(frame*impostor.mFrameSize, 0, impostor.mFrameSize, impostor.mFrameSize);
+      for (auto &mesh : meshes) {
+        mDrawCalls++;
+        mesh->drawInstanced(identity);
+      }
+    }
 
-    // Set view matrix
-    glm::vec3 up = glm::vec3(0, 1, 0);
-    mViewMtx = camera->getViewMatrix(up);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &depthbuffer);
+    glDeleteFramebuffers(1, &framebuffer);
   }
 
   void RenderingEngine::prepareMaterialForRender(std::shared_ptr<Assets::Material> material)
@@ -586,12 +1066,10 @@ namespace Rendering
     shader->setMat4("view", mViewMtx);
   }
 
-  void RenderingEngine::setLightingUniforms(Core::Scene const &scene)
+  void RenderingEngine::setLightingUniforms(RenderSnapshot const &snapshot)
   {
     // Set view position
-    auto camera = scene.getComponents<Components::Camera>()[0];
-    auto cameraPos = camera->getWorldTranslation();
-    mLightingShader->setVec3("viewPos", cameraPos);
+    mLightingShader->setVec3("viewPos", snapshot.mViewPosition);
 
     // Set directional light uniforms
     mLightingShader->setVec3("dirLight.direction", glm::vec3(0.3f, -0.7f, 0.648f));
@@ -600,19 +1078,16 @@ namespace Rendering
     mLightingShader->setVec3("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
 
     // Set point light uniforms
-    auto followPos = camera->mFollowTransform->getWorldTranslation();
-    auto pointLights = scene.getComponents<Components::PointLight>();
-    std::map<float, std::shared_ptr<Components::PointLight>> distancesMap;
-    for (int i = 0; i < pointLights.size(); i++) {
-      glm::vec3 pointLightPos = pointLights[i]->mGameObject.mTransform->getWorldTranslation();
-      float distance = glm::length(followPos-pointLightPos);
-      distancesMap[distance] = pointLights[i];
+    std::map<float, RenderSnapshot::PointLightInstance const *> distancesMap;
+    for (auto &pointLightInstance : snapshot.mPointLights) {
+      float distance = glm::length(snapshot.mFollowPosition-pointLightInstance.mPosition);
+      distancesMap[distance] = &pointLightInstance;
     }
     auto iter = distancesMap.begin();
-    for (int i = 0; i < std::min((size_t) 6, distancesMap.size()); i++) {
+    for (size_t i = 0; i < std::min((size_t) MAX_POINT_LIGHTS, distancesMap.size()); i++) {
       std::string number = std::to_string(i);
-      auto pointLight = iter->second;
-      mLightingShader->setVec3("pointLights[" + number + "].position", pointLight->mGameObject.mTransform->getWorldTranslation());
+      auto pointLight = iter->second->mPointLight;
+      mLightingShader->setVec3("pointLights[" + number + "].position", iter->second->mPosition);
       mLightingShader->setVec3("pointLights[" + number + "].ambient", pointLight->mAmbient);
       mLightingShader->setVec3("pointLights[" + number + "].diffuse", pointLight->mDiffuse);
       mLightingShader->setVec3("pointLights[" + number + "].specular", pointLight->mSpecular);
@@ -622,35 +1097,56 @@ namespace Rendering
       iter++;
     }
 
-    // Set spot light uniforms
-    auto spotLights = scene.getComponents<Components::SpotLight>();
-    for (int i = 0; i < spotLights.size(); i++) {
-        std::string number = std::to_string(i);
-        auto spotLight = spotLights[i];
+    // Spot lights come from the buffer uploadSpotLights() filled for this frame
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SPOT_LIGHT_BINDING, mSpotLightBuffer);
+    mLightingShader->setInt("spotLightCount", mSpotLightCount);
+  }
 
-        mLightingShader->setVec3("spotLights[" + number + "].position", spotLight->mGameObject.mTransform->getWorldTranslation());
-        mLightingShader->setVec3("spotLights[" + number + "].direction", spotLight->getDirection());
-        mLightingShader->setVec3("spotLights[" + number + "].ambient", spotLight->mAmbient);
-        mLightingShader->setVec3("spotLights[" + number + "].diffuse", spotLight->mDiffuse);
-        mLightingShader->setVec3("spotLights[" + number + "].specular", spotLight->mSpecular);
-        mLightingShader->setFloat("spotLights[" + number + "].innerCutoff", spotLight->mInnerCutoff);
-        mLightingShader->setFloat("spotLights[" + number + "].outerCutoff", spotLight->mOuterCutoff);
-        mLightingShader->setFloat("spotLights[" + number + "].constant", spotLight->mConstant);
-        mLightingShader->setFloat("spotLights[" + number + "].linear", spotLight->mLinear);
-        mLightingShader->setFloat("spotLights[" + number + "].quadratic", spotLight->mQuadratic);
+  void RenderingEngine::uploadSpotLights(RenderSnapshot const &snapshot)
+  {
+    // Every light whose reach touches the view frustum is lit, however many cars carry them
+    glm::mat4 viewProjection = mProjectionMtx * mViewMtx;
+    std::vector<GpuSpotLight> spotLights;
+    spotLights.reserve(snapshot.mSpotLights.size());
+    for (auto &spotLightInstance : snapshot.mSpotLights) {
+      auto &spotLight = *spotLightInstance.mSpotLight;
+      float range = getSpotLightRange(spotLight);
+      if (range <= 0.0f || !isSphereInFrustum(viewProjection, spotLightInstance.mPosition, range)) {
+        continue;
+      }
+
+      GpuSpotLight gpuSpotLight;
+      gpuSpotLight.mPosition = spotLightInstance.mPosition;
+      gpuSpotLight.mRange = range;
+      gpuSpotLight.mDirection = spotLightInstance.mDirection;
+      gpuSpotLight.mInnerCutoff = spotLight.mInnerCutoff;
+      gpuSpotLight.mAmbient = spotLight.mAmbient;
+      gpuSpotLight.mOuterCutoff = spotLight.mOuterCutoff;
+      gpuSpotLight.mDiffuse = spotLight.mDiffuse;
+      gpuSpotLight.mConstant = spotLight.mConstant;
+      gpuSpotLight.mSpecular = spotLight.mSpecular;
+      gpuSpotLight.mLinear = spotLight.mLinear;
+      gpuSpotLight.mQuadratic = spotLight.mQuadratic;
+      spotLights.push_back(gpuSpotLight);
     }
+    mSpotLightCount = spotLights.size();
+
+    // Orphaned each frame; never empty, so the binding stays valid with no lights in view
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSpotLightBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(spotLights.size(), 1)*sizeof(GpuSpotLight),
+                 spotLights.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
   }
 
-  void RenderingEngine::setModelUniforms(std::shared_ptr<Assets::Shader> shader, Core::Scene const &scene, Core::GameObject &gameObject)
+  void RenderingEngine::setModelUniforms(std::shared_ptr<Assets::Shader> shader, glm::mat4 const &modelMatrix)
   {
     // Set model matrix
-    shader->setMat4("model", gameObject.mTransform->mModelMatrix);
+    shader->setMat4("model", modelMatrix);
   }
 
-  void RenderingEngine::setTerrainUniforms(std::shared_ptr<Assets::Shader> shader, Core::Scene const &scene, std::shared_ptr<Components::TerrainRenderer> terrainRenderer)
+  void RenderingEngine::setTerrainUniforms(std::shared_ptr<Assets::Shader> shader, std::shared_ptr<Components::TerrainRenderer> terrainRenderer)
   {
-    shader->setInt("wireframeMode", scene.mRenderSettings.mTerrainRenderMode);
-    shader->setVec2("viewport", glm::vec2(scene.mRenderSettings.mFramebufferWidth, scene.mRenderSettings.mFramebufferHeight));
+    shader->setVec2("viewport", glm::vec2(mRenderWidth, mRenderHeight));
     shader->setFloat("scaleX", terrainRenderer->mScaleX);
     shader->setFloat("scaleZ", terrainRenderer->mScaleZ);
     shader->setFloat("heightScale", terrainRenderer->mHeightScale);
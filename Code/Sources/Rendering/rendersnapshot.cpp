@@ -0,0 +1,83 @@
+#include "Rendering/rendersnapshot.hpp"
+#include "Components/camera.hpp"
+#include "Components/meshrenderer.hpp"
+#include "Components/wheelmeshrenderer.hpp"
+#include "Components/carphysicsbody.hpp"
+#include "Components/terrainrenderer.hpp"
+#include "Components/particlesystemrenderer.hpp"
+#include "Components/pointlight.hpp"
+#include "Components/spotlight.hpp"
+#include "Utils/transformconversions.hpp"
+
+#include <iterator>
+
+namespace Rendering
+{
+    void RenderSnapshot::capture(Core::Scene &scene, DebugRenderer &debugRenderer, double deltaTime, double rollingFPS)
+    {
+        mRenderSettings = scene.mRenderSettings;
+        mDeltaTime = deltaTime;
+        mRollingFPS = rollingFPS;
+        mCubeMap = &scene.mCubeMap;
+
+        // Camera
+        auto camera = scene.getComponents<Components::Camera>()[0];
+        float aspectRatio = mRenderSettings.mFramebufferWidth / mRenderSettings.mFramebufferHeight;
+        mProjectionMtx = camera->getProjectionMatrix(aspectRatio);
+        mViewMtx = camera->getViewMatrix(glm::vec3(0, 1, 0));
+        mViewPosition = camera->getWorldTranslation();
+        mFollowPosition = camera->mFollowTransform->getWorldTranslation();
+
+        // Geometry
+        mMeshes.clear();
+        for (auto &meshRenderer : scene.getComponents<Components::MeshRenderer>()) {
+            mMeshes.push_back({ meshRenderer, meshRenderer->mGameObject.mTransform->mModelMatrix });
+        }
+        mWheels.clear();
+        for (auto &wheelMeshRenderer : scene.getComponents<Components::WheelMeshRenderer>()) {
+            std::shared_ptr<Components::MeshRenderer> bodyMeshRenderer;
+            for (auto &meshRenderer : wheelMeshRenderer->mGameObject.getComponents<Components::MeshRenderer>()) {
+                bodyMeshRenderer = meshRenderer;
+            }
+            auto &wheelModelMatrices = wheelMeshRenderer->mCarPhysicsBody->mWheelModelMatrices;
+            mWheels.push_back({ wheelMeshRenderer, bodyMeshRenderer,
+                                std::vector<glm::mat4>(std::begin(wheelModelMatrices), std::end(wheelModelMatrices)) });
+        }
+        mTerrains.clear();
+        for (auto &terrainRenderer : scene.getComponents<Components::TerrainRenderer>()) {
+            mTerrains.push_back({ terrainRenderer, terrainRenderer->mGameObject.mTransform->mModelMatrix });
+        }
+
+        // Lights
+        mPointLights.clear();
+        for (auto &pointLight : scene.getComponents<Components::PointLight>()) {
+            mPointLights.push_back({ pointLight, pointLight->mGameObject.mTransform->getWorldTranslation() });
+        }
+        mSpotLights.clear();
+        for (auto &spotLight : scene.getComponents<Components::SpotLight>()) {
+            mSpotLights.push_back({ spotLight, spotLight->mGameObject.mTransform->getWorldTranslation(), spotLight->getDirection() });
+        }
+
+        // Particle lifetimes are simulation state; the renderer only replays the resulting updates and resets
+        mParticleEmitters.clear();
+        for (auto &particleSystemRenderer : scene.getComponents<Components::ParticleSystemRenderer>()) {
+            if (!particleSystemRenderer->mIsActive && !particleSystemRenderer->mPendingReset) {
+                continue;
+            }
+            mParticleEmitters.push_back({ particleSystemRenderer, particleSystemRenderer->mGameObject.mTransform->mModelMatrix,
+                                          particleSystemRenderer->mTimeActive, particleSystemRenderer->mPendingReset });
+            particleSystemRenderer->mPendingReset = false;
+        }
+
+        // Debug lines, with spot light positions and directions added to Bullet's
+        if (mRenderSettings.mDrawDebugLines) {
+            for (auto &spotLight : mSpotLights) {
+                debugRenderer.drawLine(
+                    Utils::TransformConversions::glmVec32btVector3(spotLight.mPosition),
+                    Utils::TransformConversions::glmVec32btVector3(spotLight.mPosition + spotLight.mDirection),
+                    btVector3(1.0, 1.0, 1.0));
+            }
+        }
+        debugRenderer.takeLines(mDebugLines);
+    }
+}
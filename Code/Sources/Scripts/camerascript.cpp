@@ -34,32 +34,32 @@ namespace Scripts
     void CameraScript::onUpdate(GLFWwindow *window, Core::Scene &scene, float deltaTime)
     {
         // Key for resetting camera
-        if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_R)) {
             mRadius = DEFAULT_RADIUS;
             mTheta = DEFAULT_THETA;
             mPhi = DEFAULT_PHI;
         }
 
         // Keys for modifying radius/theta/phi
-        if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_Q)) {
             mRadius += RADIUS_RATE * deltaTime;
             if (mRadius > 250) mRadius = 250;
         }
-        if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_E)) {
             mRadius -= RADIUS_RATE * deltaTime;
             if (mRadius < 2) mRadius = 2;
         }
-        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_LEFT)) {
             mTheta -= ROTATION_RATE * deltaTime;
         }
-        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_RIGHT)) {
             mTheta += ROTATION_RATE * deltaTime;
         }
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_UP)) {
             mPhi -= ROTATION_RATE * deltaTime;
             if (mPhi < -85) mPhi = -85;
         }
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_DOWN)) {
             mPhi += ROTATION_RATE * deltaTime;
             if (mPhi > 85) mPhi = 85;
         }
@@ -1,4 +1,5 @@
 #include "Scripts/carscript.hpp"
+#include "Rendering/graphicscontext.hpp"
 #include "Utils/logger.hpp"
 
 #include <iostream>
@@ -15,23 +16,25 @@ namespace Scripts
     CarScript::CarScript(Core::GameObject &gameObject, glm::vec3 initialPosition) : Script(gameObject),
         mInitialPosition(initialPosition), mTimeSinceLastSpawnedPS(1e6), mNextPoolIdx(0)
     {
-        auto particleUpdateShader = std::make_shared<Assets::Shader>(
-            PROJECT_SOURCE_DIR "/Shaders/ComputeShaders/flames_update.cs"
-        );
-        auto particleRenderShader = std::make_shared<Assets::Shader>(
-            PROJECT_SOURCE_DIR "/Shaders/VertexShaders/flames_render.vert",
-            PROJECT_SOURCE_DIR "/Shaders/GeometryShaders/flames_render.geom",
-            PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/flames_render.frag"
-        );
         auto particleSystem = std::make_shared<Assets::ParticleSystem>();
         particleSystem->mParticleLifetime = 0.5f;
         particleSystem->mInitialParticleSize = glm::vec2(0.07f, 0.07f);
         particleSystem->mFinalParticleSize = glm::vec2(0.02f, 0.02f);
-        particleSystem->mUpdateShader = particleUpdateShader;
-        particleSystem->mRenderShader = particleRenderShader;
-        particleSystem->mTextures.push_back(std::make_shared<Assets::Texture>(PROJECT_SOURCE_DIR "/Textures/Particles/flames.tga"));
+        particleSystem->mHalfResolution = true;
         particleSystem->mColors.push_back(glm::vec3(0.886, 0.345, 0.133));
         particleSystem->mColors.push_back(glm::vec3(0.0, 0.0, 1.0));
+        // Headless, the particle systems keep their lifetimes but are never drawn
+        if (!Rendering::GraphicsContext::isHeadless()) {
+            particleSystem->mUpdateShader = std::make_shared<Assets::Shader>(
+                PROJECT_SOURCE_DIR "/Shaders/ComputeShaders/flames_update.cs"
+            );
+            particleSystem->mRenderShader = std::make_shared<Assets::Shader>(
+                PROJECT_SOURCE_DIR "/Shaders/VertexShaders/flames_render.vert",
+                PROJECT_SOURCE_DIR "/Shaders/GeometryShaders/flames_render.geom",
+                PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/flames_render.frag"
+            );
+            particleSystem->mTextures.push_back(std::make_shared<Assets::Texture>(PROJECT_SOURCE_DIR "/Textures/Particles/flames.tga"));
+        }
         mParticleSystem = particleSystem;
     }
 
@@ -70,7 +73,7 @@ namespace Scripts
         mTimeSinceLastSpawnedPS += deltaTime;
 
         // Key for resetting car position and position
-        if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_R)) {
             mGameObject.mTransform->setTranslation(mInitialPosition);
             mGameObject.mTransform->setRotation(INITIAL_ROTATION);
             mCarPhysicsBody->setSteering(INITIAL_STEERING);
@@ -84,13 +87,13 @@ namespace Scripts
         #endif
 
         // Keys for driving car
-        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_SPACE)) {
             mCarPhysicsBody->setBrake(BRAKE_FORCE);
         }
         else {
             mCarPhysicsBody->setBrake(0);
         }
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_W)) {
             mCarPhysicsBody->applyEngineForce(ENGINE_FORCE);
             
             if (mTimeSinceLastSpawnedPS > 0.01f) {
@@ -111,16 +114,16 @@ namespace Scripts
                 mTimeSinceLastSpawnedPS = 0.0f;
             }
         }
-        else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+        else if (isKeyPressed(window, GLFW_KEY_S)) {
             mCarPhysicsBody->applyEngineForce(-ENGINE_FORCE);
         }
         else {
             mCarPhysicsBody->applyEngineForce(0);
         }
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+        if (isKeyPressed(window, GLFW_KEY_A)) {
             mCarPhysicsBody->setSteering((float)(mCarPhysicsBody->mSteering + WHEEL_TURN_RATE*deltaTime));
         }
-        else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+        else if (isKeyPressed(window, GLFW_KEY_D)) {
             mCarPhysicsBody->setSteering((float)(mCarPhysicsBody->mSteering - WHEEL_TURN_RATE*deltaTime));
         }
         else {
@@ -128,4 +131,17 @@ namespace Scripts
             mCarPhysicsBody->setSteering(float((1-10*deltaTime)*mCarPhysicsBody->mSteering));
         }
     }
+
+    void CarScript::saveState(Core::StateWriter &writer) const
+    {
+        // Pooled particle systems save their own state
+        writer.write(mTimeSinceLastSpawnedPS);
+        writer.write(mNextPoolIdx);
+    }
+
+    void CarScript::loadState(Core::StateReader &reader)
+    {
+        reader.read(mTimeSinceLastSpawnedPS);
+        reader.read(mNextPoolIdx);
+    }
 }
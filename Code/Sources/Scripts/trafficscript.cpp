@@ -0,0 +1,177 @@
+#include "Scripts/trafficscript.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Speed on straights, and the accelerations the speed plan keeps within
+const float CRUISE_SPEED = 12.0f;
+const float LATERAL_ACCELERATION = 5.0f;
+const float ACCELERATION = 3.0f;
+const float BRAKE_DECELERATION = 4.0f;
+const float PROFILE_SPACING = 1.0f;
+
+// Pure pursuit aims at the point this far along the racing line, plus the distance covered in LOOKAHEAD_TIME
+const float LOOKAHEAD_DISTANCE = 2.0f;
+const float LOOKAHEAD_TIME = 0.4f;
+// Each tick's nearest point on the line is searched for within this distance of the last one
+const float SEARCH_RANGE = 5.0f;
+
+// Throttle per unit of speed error, and the forces full throttle and full braking apply, as the player's car uses
+const float SPEED_GAIN = 0.5f;
+const float ENGINE_FORCE = 600.0f;
+const float BRAKE_FORCE = 100.0f;
+
+namespace Scripts
+{
+    TrafficScript::TrafficScript(Core::GameObject &gameObject, std::shared_ptr<Core::TrackPath> racingLine) : Script(gameObject),
+        mRacingLine(racingLine)
+    {
+        // Fastest each point can be taken, then limited by the braking needed for every later point
+        int samples = std::max((int) std::ceil(mRacingLine->getLength() / PROFILE_SPACING), 1);
+        mProfileSpacing = mRacingLine->getLength() / samples;
+        for (int i = 0; i < samples; i++) {
+            float curvature = std::max(std::abs(mRacingLine->getCurvature(i*mProfileSpacing)), 1e-6f);
+            mSpeedProfile.push_back(std::min(CRUISE_SPEED, std::sqrt(LATERAL_ACCELERATION / curvature)));
+        }
+        // Twice around, since braking for a bend may reach back past the start of the loop
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = samples - 1; i >= 0; i--) {
+                float next = mSpeedProfile[(i + 1) % samples];
+                mSpeedProfile[i] = std::min(mSpeedProfile[i], std::sqrt(next*next + 2*BRAKE_DECELERATION*mProfileSpacing));
+            }
+        }
+    }
+
+    TrafficScript::~TrafficScript()
+    {
+    }
+
+    void TrafficScript::addAgent(std::shared_ptr<Components::CarPhysicsBody> carPhysicsBody, float laneOffset)
+    {
+        // Distance between the front and rear axles
+        auto &vehicle = *carPhysicsBody->mVehicle;
+        float front = 0.0f;
+        float rear = 0.0f;
+        for (int i = 0; i < vehicle.getNumWheels(); i++) {
+            float z = vehicle.getWheelInfo(i).m_chassisConnectionPointCS.z();
+            front = std::max(front, z);
+            rear = std::min(rear, z);
+        }
+
+        mAgents.push_back(carPhysicsBody);
+        mLaneOffsets.push_back(laneOffset);
+        mWheelbases.push_back(front - rear);
+        mPathDistances.push_back(0.0f);
+        for (auto field : { &mPositionX, &mPositionZ, &mLeftX, &mLeftZ, &mSpeeds, &mTargetX, &mTargetZ, &mTargetSpeeds,
+                            &mSteerings, &mEngineForces, &mBrakeForces }) {
+            field->push_back(0.0f);
+        }
+    }
+
+    void TrafficScript::onStart(Core::Scene &scene)
+    {
+        for (size_t i = 0; i < mAgents.size(); i++) {
+            btVector3 origin = mAgents[i]->mRigidBody->getCenterOfMassPosition();
+            mPathDistances[i] = mRacingLine->getClosestDistance(glm::vec2(origin.x(), origin.z()));
+        }
+    }
+
+    void TrafficScript::onUpdate(GLFWwindow *window, Core::Scene &scene, float deltaTime)
+    {
+        int count = mAgents.size();
+
+        // ***** GATHER *****
+        // Each agent's pose, and the point and speed it aims for
+        for (int i = 0; i < count; i++) {
+            auto &agent = *mAgents[i];
+            btTransform const &transform = agent.mRigidBody->getCenterOfMassTransform();
+            btVector3 forward = transform.getBasis().getColumn(2);
+            btVector3 left = transform.getBasis().getColumn(0);
+            glm::vec2 position(transform.getOrigin().x(), transform.getOrigin().z());
+
+            mPositionX[i] = position.x;
+            mPositionZ[i] = position.y;
+            mLeftX[i] = left.x();
+            mLeftZ[i] = left.z();
+            // Cars following their paths have no rigid body velocity
+            mSpeeds[i] = agent.mKinematic ? agent.mPathSpeed : agent.mRigidBody->getLinearVelocity().dot(forward);
+
+            mPathDistances[i] = mRacingLine->getClosestDistance(position, mPathDistances[i], SEARCH_RANGE);
+            float targetDistance = mPathDistances[i] + LOOKAHEAD_DISTANCE + LOOKAHEAD_TIME*std::max(mSpeeds[i], 0.0f);
+            glm::vec2 target = mRacingLine->getPosition(targetDistance) + mRacingLine->getLateral(targetDistance)*mLaneOffsets[i];
+            mTargetX[i] = target.x;
+            mTargetZ[i] = target.y;
+            mTargetSpeeds[i] = getPlannedSpeed(mPathDistances[i]);
+        }
+
+        // ***** CONTROL *****
+        // Branch free over plain arrays, so the compiler can vectorize it across agents
+        float const *positionX = mPositionX.data();
+        float const *positionZ = mPositionZ.data();
+        float const *leftX = mLeftX.data();
+        float const *leftZ = mLeftZ.data();
+        float const *speeds = mSpeeds.data();
+        float const *targetX = mTargetX.data();
+        float const *targetZ = mTargetZ.data();
+        float const *targetSpeeds = mTargetSpeeds.data();
+        float const *wheelbases = mWheelbases.data();
+        float *steerings = mSteerings.data();
+        float *engineForces = mEngineForces.data();
+        float *brakeForces = mBrakeForces.data();
+        for (int i = 0; i < count; i++) {
+            // Pure pursuit: the arc through the target point, and the steering angle that drives it
+            float dx = targetX[i] - positionX[i];
+            float dz = targetZ[i] - positionZ[i];
+            float offset = dx*leftX[i] + dz*leftZ[i];
+            float curvature = 2.0f*offset / (dx*dx + dz*dz + 1e-6f);
+            // Rational fit of atan, close enough over the range the steering clamp allows
+            float x = std::min(std::max(wheelbases[i]*curvature, -1.0f), 1.0f);
+            steerings[i] = x / (1.0f + 0.28f*x*x);
+
+            // Proportional speed control; negative throttle brakes
+            float throttle = std::min(std::max((targetSpeeds[i] - speeds[i])*SPEED_GAIN, -1.0f), 1.0f);
+            engineForces[i] = std::max(throttle, 0.0f)*ENGINE_FORCE;
+            brakeForces[i] = std::max(-throttle, 0.0f)*BRAKE_FORCE;
+        }
+
+        // ***** APPLY *****
+        for (int i = 0; i < count; i++) {
+            auto &agent = *mAgents[i];
+            if (agent.mKinematic) {
+                // Cars following their paths change speed at the limits the plan assumes
+                agent.mPathSpeed += std::min(std::max(mTargetSpeeds[i] - agent.mPathSpeed, -BRAKE_DECELERATION*deltaTime),
+                                             ACCELERATION*deltaTime);
+                continue;
+            }
+            agent.setSteering(mSteerings[i]);
+            agent.applyEngineForce(mEngineForces[i]);
+            agent.setBrake(mBrakeForces[i]);
+        }
+    }
+
+    void TrafficScript::saveState(Core::StateWriter &writer) const
+    {
+        // Everything else is gathered afresh each tick
+        for (float pathDistance : mPathDistances) {
+            writer.write(pathDistance);
+        }
+    }
+
+    void TrafficScript::loadState(Core::StateReader &reader)
+    {
+        for (float &pathDistance : mPathDistances) {
+            reader.read(pathDistance);
+        }
+    }
+
+    float TrafficScript::getPlannedSpeed(float distance) const
+    {
+        float position = std::fmod(distance / mProfileSpacing, (float) mSpeedProfile.size());
+        if (position < 0.0f) {
+            position += mSpeedProfile.size();
+        }
+        int sample = std::min((int) position, (int) mSpeedProfile.size() - 1);
+        float fraction = position - sample;
+        return mSpeedProfile[sample] + (mSpeedProfile[(sample + 1) % mSpeedProfile.size()] - mSpeedProfile[sample])*fraction;
+    }
+}
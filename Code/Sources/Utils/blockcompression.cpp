@@ -0,0 +1,191 @@
+#include "Utils/blockcompression.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    unsigned short packRGB565(const int color[3])
+    {
+      return (unsigned short) (((color[0]*31 + 127)/255) << 11 | ((color[1]*63 + 127)/255) << 5 | ((color[2]*31 + 127)/255));
+    }
+
+    void unpackRGB565(unsigned short packed, int color[3])
+    {
+      int r = (packed >> 11) & 31;
+      int g = (packed >> 5) & 63;
+      int b = packed & 31;
+      color[0] = (r << 3) | (r >> 2);
+      color[1] = (g << 2) | (g >> 4);
+      color[2] = (b << 3) | (b >> 2);
+    }
+}
+
+namespace Utils
+{
+    unsigned int BlockCompression::getBlockSize(Format format)
+    {
+      return (format == BC1 || format == BC4) ? 8 : 16;
+    }
+
+    unsigned int BlockCompression::getCompressedSize(Format format, int width, int height)
+    {
+      unsigned int blocksX = std::max(1, (width + 3)/4);
+      unsigned int blocksY = std::max(1, (height + 3)/4);
+      return blocksX*blocksY*getBlockSize(format);
+    }
+
+    std::vector<unsigned char> BlockCompression::compress(Format format, const unsigned char *rgba, int width, int height)
+    {
+      std::vector<unsigned char> output(getCompressedSize(format, width, height));
+      unsigned int blockSize = getBlockSize(format);
+      unsigned char *block = &output[0];
+
+      unsigned char texels[16*4];
+      for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+          // Gather block
+          for (int y = 0; y < 4; y++) {
+            int srcY = std::min(by + y, height - 1);
+            for (int x = 0; x < 4; x++) {
+              int srcX = std::min(bx + x, width - 1);
+              std::copy(rgba + (srcY*width + srcX)*4, rgba + (srcY*width + srcX)*4 + 4, texels + (y*4 + x)*4);
+            }
+          }
+
+          switch (format) {
+            case BC1:
+              encodeBC1(texels, block);
+              break;
+            case BC3:
+              encodeBC3(texels, block);
+              break;
+            case BC4:
+              encodeBC4(texels, 0, block);
+              break;
+            case BC5:
+              encodeBC5(texels, block);
+              break;
+          }
+          block += blockSize;
+        }
+      }
+      return output;
+    }
+
+    void BlockCompression::encodeBC1(const unsigned char *texels, unsigned char *block)
+    {
+      // Pick endpoints along the axis of largest extent (range fit)
+      int minColor[3] = {255, 255, 255};
+      int maxColor[3] = {0, 0, 0};
+      for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+          minColor[c] = std::min(minColor[c], (int) texels[i*4 + c]);
+          maxColor[c] = std::max(maxColor[c], (int) texels[i*4 + c]);
+        }
+      }
+      int axis[3] = {maxColor[0] - minColor[0], maxColor[1] - minColor[1], maxColor[2] - minColor[2]};
+      int minProjection = 1 << 30, maxProjection = -(1 << 30);
+      int minIdx = 0, maxIdx = 0;
+      for (int i = 0; i < 16; i++) {
+        int projection = texels[i*4]*axis[0] + texels[i*4 + 1]*axis[1] + texels[i*4 + 2]*axis[2];
+        if (projection < minProjection) {
+          minProjection = projection;
+          minIdx = i;
+        }
+        if (projection > maxProjection) {
+          maxProjection = projection;
+          maxIdx = i;
+        }
+      }
+      int endpoint0[3] = {texels[maxIdx*4], texels[maxIdx*4 + 1], texels[maxIdx*4 + 2]};
+      int endpoint1[3] = {texels[minIdx*4], texels[minIdx*4 + 1], texels[minIdx*4 + 2]};
+
+      unsigned short color0 = packRGB565(endpoint0);
+      unsigned short color1 = packRGB565(endpoint1);
+      // Four-color mode requires color0 > color1
+      if (color0 < color1) {
+        std::swap(color0, color1);
+      }
+
+      unsigned int indices = 0;
+      if (color0 != color1) {
+        int palette[4][3];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+          palette[2][c] = (2*palette[0][c] + palette[1][c])/3;
+          palette[3][c] = (palette[0][c] + 2*palette[1][c])/3;
+        }
+
+        for (int i = 0; i < 16; i++) {
+          int bestIdx = 0;
+          int bestDistance = 1 << 30;
+          for (int p = 0; p < 4; p++) {
+            int dr = texels[i*4] - palette[p][0];
+            int dg = texels[i*4 + 1] - palette[p][1];
+            int db = texels[i*4 + 2] - palette[p][2];
+            int distance = dr*dr + dg*dg + db*db;
+            if (distance < bestDistance) {
+              bestDistance = distance;
+              bestIdx = p;
+            }
+          }
+          indices |= bestIdx << (i*2);
+        }
+      }
+
+      block[0] = color0 & 0xFF;
+      block[1] = color0 >> 8;
+      block[2] = color1 & 0xFF;
+      block[3] = color1 >> 8;
+      for (int i = 0; i < 4; i++) {
+        block[4 + i] = (indices >> (i*8)) & 0xFF;
+      }
+    }
+
+    void BlockCompression::encodeBC3(const unsigned char *texels, unsigned char *block)
+    {
+      encodeBC4(texels, 3, block);
+      encodeBC1(texels, block + 8);
+    }
+
+    void BlockCompression::encodeBC4(const unsigned char *texels, int channel, unsigned char *block)
+    {
+      int minValue = 255;
+      int maxValue = 0;
+      for (int i = 0; i < 16; i++) {
+        minValue = std::min(minValue, (int) texels[i*4 + channel]);
+        maxValue = std::max(maxValue, (int) texels[i*4 + channel]);
+      }
+
+      // Eight-value mode (value0 > value1): 0 -> max, 1 -> min, 2..7 interpolate from max to min
+      unsigned long long indices = 0;
+      if (maxValue != minValue) {
+        int range = maxValue - minValue;
+        for (int i = 0; i < 16; i++) {
+          int step = ((texels[i*4 + channel] - minValue)*14 + range)/(2*range);
+          int index;
+          if (step == 7)
+            index = 0;
+          else if (step == 0)
+            index = 1;
+          else
+            index = 8 - step;
+          indices |= (unsigned long long) index << (i*3);
+        }
+      }
+
+      block[0] = maxValue;
+      block[1] = minValue;
+      for (int i = 0; i < 6; i++) {
+        block[2 + i] = (indices >> (i*8)) & 0xFF;
+      }
+    }
+
+    void BlockCompression::encodeBC5(const unsigned char *texels, unsigned char *block)
+    {
+      // Two-channel sources keep their second channel in alpha
+      encodeBC4(texels, 0, block);
+      encodeBC4(texels, 3, block + 8);
+    }
+}
@@ -0,0 +1,55 @@
+#include "Utils/fileutils.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace Utils
+{
+    void FileUtils::createDirectories(std::string const &path)
+    {
+      for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string directory = path.substr(0, pos);
+#ifdef _WIN32
+        mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(), 0755);
+#endif
+        if (pos == std::string::npos) {
+          break;
+        }
+      }
+    }
+
+    bool FileUtils::writeAtomically(std::string const &path, std::string const &contents)
+    {
+      std::stringstream tempPath;
+      tempPath << path << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+      {
+        std::ofstream file(tempPath.str(), std::ios::binary);
+        if (!file) {
+          return false;
+        }
+        file.write(contents.data(), contents.size());
+        if (!file) {
+          return false;
+        }
+      }
+      return std::rename(tempPath.str().c_str(), path.c_str()) == 0;
+    }
+
+    unsigned long long FileUtils::hash(const void *data, size_t size, unsigned long long seed)
+    {
+      const unsigned char *bytes = static_cast<const unsigned char *>(data);
+      unsigned long long hash = seed;
+      for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+      }
+      return hash;
+    }
+}
@@ -0,0 +1,61 @@
+#include "Utils/mappedfile.hpp"
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utils
+{
+    MappedFile::MappedFile(std::string const &path)
+      : mData(nullptr), mSize(0), mMapped(false)
+    {
+#ifndef _WIN32
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        return;
+      }
+      struct stat fileStat;
+      if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+        void *data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+          mData = static_cast<const unsigned char *>(data);
+          mSize = fileStat.st_size;
+          mMapped = true;
+        }
+      }
+      close(fd);
+      if (mMapped) {
+        return;
+      }
+#endif
+      // Fall back to reading the whole file
+      std::ifstream file(path, std::ios::binary | std::ios::ate);
+      if (!file) {
+        return;
+      }
+      std::streamsize size = file.tellg();
+      if (size <= 0) {
+        return;
+      }
+      file.seekg(0, std::ios::beg);
+      mBuffer.resize(size);
+      if (file.read(reinterpret_cast<char *>(&mBuffer[0]), size)) {
+        mData = &mBuffer[0];
+        mSize = size;
+      }
+    }
+
+    MappedFile::~MappedFile()
+    {
+#ifndef _WIN32
+      if (mMapped) {
+        munmap(const_cast<unsigned char *>(mData), mSize);
+      }
+#endif
+    }
+}
@@ -1,13 +1,45 @@
 #include "Utils/meshcreator.hpp"
+#include "Assets/meshcache.hpp"
+#include "Utils/fileutils.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/euler_angles.hpp>
 
 namespace Utils
 {
-    std::shared_ptr<Assets::Mesh> MeshCreator::create()
+    std::shared_ptr<Assets::Mesh> MeshCreator::create(bool upload)
     {
-        return std::make_shared<Assets::Mesh>(mPositions, mNormals, mTexCoords);
+        // Generated geometry is cooked like imported models, keyed by its inputs, so tangent
+        // generation and optimization only run the first time a given shape is built
+        unsigned long long sourceHash = FileUtils::hash(mPositions.data(), mPositions.size()*sizeof(glm::vec3));
+        sourceHash = FileUtils::hash(mNormals.data(), mNormals.size()*sizeof(glm::vec3), sourceHash);
+        sourceHash = FileUtils::hash(mTexCoords.data(), mTexCoords.size()*sizeof(glm::vec2), sourceHash);
+
+        Assets::CookedModel cookedModel;
+        if (Assets::MeshCache::load(sourceHash, cookedModel) && cookedModel.mMeshes.size() == 1) {
+            auto &cookedMesh = cookedModel.mMeshes[0];
+            return std::make_shared<Assets::Mesh>(
+                cookedModel.mFile,
+                cookedMesh.mVertices, cookedMesh.mPackedVertices, cookedMesh.mVertexCount,
+                cookedMesh.mIndices, cookedMesh.mIndexCount,
+                cookedMesh.mLods, cookedMesh.mVertexFormat, cookedMesh.mBoundsMin, cookedMesh.mBoundsMax,
+                cookedMesh.mPositionScale, cookedMesh.mPositionOffset, upload
+            );
+        }
+
+        auto mesh = std::make_shared<Assets::Mesh>(mPositions, mNormals, mTexCoords, upload);
+        if (mesh->getIndexCount() > 0) {
+            cookedModel.mMeshes.clear();
+            cookedModel.mMeshes.push_back({
+                mesh->getVertexData(), mesh->getPackedVertexData(), mesh->getVertexCount(),
+                mesh->getIndexData(), mesh->getIndexCount(),
+                mesh->mBoundsMin, mesh->mBoundsMax,
+                mesh->mLods, mesh->mVertexFormat,
+                mesh->getPositionScale(), mesh->getPositionOffset()
+            });
+            Assets::MeshCache::save(cookedModel);
+        }
+        return mesh;
     }
 
     int MeshCreator::addOpenCylinder(float tDiff, float height1, float height2, float radius)
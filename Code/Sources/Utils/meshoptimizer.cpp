@@ -0,0 +1,334 @@
+#include "Utils/meshoptimizer.hpp"
+#include "Utils/fileutils.hpp"
+#include "Utils/meshsimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+// Tuning from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+const unsigned int FORSYTH_CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+// Cache size used when splitting into overdraw clusters
+const unsigned int OVERDRAW_CACHE_SIZE = 16;
+
+namespace
+{
+    float vertexScore(int cachePosition, unsigned int remainingTriangles)
+    {
+      // Vertices with no triangles left should never attract a triangle
+      if (remainingTriangles == 0) {
+        return -1.0f;
+      }
+
+      float score = 0.0f;
+      if (cachePosition >= 0) {
+        // The last triangle's vertices get a fixed score so the next triangle does not just reuse them
+        if (cachePosition < 3) {
+          score = LAST_TRIANGLE_SCORE;
+        }
+        else {
+          float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+          score = std::pow(1.0f - (cachePosition - 3)*scaler, CACHE_DECAY_POWER);
+        }
+      }
+
+      // Boost vertices with few triangles left so they get finished off
+      score += VALENCE_BOOST_SCALE * std::pow((float) remainingTriangles, -VALENCE_BOOST_POWER);
+      return score;
+    }
+
+    struct VertexHasher
+    {
+      std::vector<Assets::Vertex> const *mVertices;
+      size_t operator()(unsigned int index) const
+      {
+        return Utils::FileUtils::hash(&(*mVertices)[index], sizeof(Assets::Vertex));
+      }
+    };
+
+    struct VertexEqual
+    {
+      std::vector<Assets::Vertex> const *mVertices;
+      bool operator()(unsigned int a, unsigned int b) const
+      {
+        return memcmp(&(*mVertices)[a], &(*mVertices)[b], sizeof(Assets::Vertex)) == 0;
+      }
+    };
+}
+
+namespace Utils
+{
+    void MeshOptimizer::optimize(std::string const &name, std::vector<Assets::Vertex> &vertices, std::vector<unsigned int> &indices,
+                                 std::vector<Assets::LodLevel> &lods)
+    {
+      unsigned int vertexCountBefore = vertices.size();
+      float acmrBefore = computeACMR(indices, vertices.size());
+
+      weldVertices(vertices, indices);
+      optimizeVertexCache(indices, vertices.size());
+      optimizeOverdraw(vertices, indices);
+      float acmrAfter = computeACMR(indices, vertices.size());
+
+      // Simplified levels share the vertex buffer, so fetch order is settled after they exist; level 0 comes first
+      MeshSimplifier::buildLodChain(vertices, indices, lods);
+      optimizeVertexFetch(vertices, indices);
+
+      std::cout << std::fixed << std::setprecision(2)
+                << "Optimized mesh " << name << ": " << vertexCountBefore << " -> " << vertices.size() << " vertices, "
+                << "ACMR " << acmrBefore << " -> " << acmrAfter << ", LOD triangles";
+      for (auto &lod : lods) {
+        std::cout << " " << lod.mIndexCount/3;
+      }
+      std::cout << std::endl;
+      std::cout << std::defaultfloat;
+    }
+
+    void MeshOptimizer::weldVertices(std::vector<Assets::Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+      std::unordered_map<unsigned int, unsigned int, VertexHasher, VertexEqual> uniqueVertices(
+        vertices.size(), VertexHasher{&vertices}, VertexEqual{&vertices}
+      );
+
+      // Map each vertex to the first identical one, compacting as we go
+      std::vector<unsigned int> remap(vertices.size());
+      std::vector<Assets::Vertex> weldedVertices;
+      weldedVertices.reserve(vertices.size());
+      for (unsigned int i = 0; i < vertices.size(); i++) {
+        auto result = uniqueVertices.insert(std::make_pair(i, (unsigned int) weldedVertices.size()));
+        if (result.second) {
+          weldedVertices.push_back(vertices[i]);
+        }
+        remap[i] = result.first->second;
+      }
+
+      for (auto &index : indices) {
+        index = remap[index];
+      }
+      vertices = std::move(weldedVertices);
+    }
+
+    void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount)
+    {
+      unsigned int triangleCount = indices.size()/3;
+      if (triangleCount == 0) {
+        return;
+      }
+
+      // Vertex to triangle adjacency; the first remainingTriangles[v] entries of each list are live
+      std::vector<unsigned int> remainingTriangles(vertexCount, 0);
+      for (auto index : indices) {
+        remainingTriangles[index]++;
+      }
+      std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+      for (unsigned int v = 0; v < vertexCount; v++) {
+        adjacencyOffsets[v+1] = adjacencyOffsets[v] + remainingTriangles[v];
+      }
+      std::vector<unsigned int> adjacency(indices.size());
+      std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+      for (unsigned int i = 0; i < indices.size(); i++) {
+        adjacency[fill[indices[i]]++] = i/3;
+      }
+
+      std::vector<int> cachePositions(vertexCount, -1);
+      std::vector<float> vertexScores(vertexCount);
+      for (unsigned int v = 0; v < vertexCount; v++) {
+        vertexScores[v] = vertexScore(-1, remainingTriangles[v]);
+      }
+      std::vector<float> triangleScores(triangleCount);
+      std::vector<bool> emitted(triangleCount, false);
+      for (unsigned int t = 0; t < triangleCount; t++) {
+        triangleScores[t] = vertexScores[indices[t*3]] + vertexScores[indices[t*3+1]] + vertexScores[indices[t*3+2]];
+      }
+
+      int bestTriangle = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+      unsigned int scanPosition = 0;
+      std::vector<unsigned int> cache;
+      std::vector<unsigned int> newCache;
+      std::vector<unsigned int> result;
+      result.reserve(indices.size());
+
+      while (bestTriangle >= 0) {
+        // Emit the triangle and retire it from its vertices' adjacency
+        const unsigned int *triangle = &indices[bestTriangle*3];
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[bestTriangle] = true;
+        for (int c = 0; c < 3; c++) {
+          unsigned int v = triangle[c];
+          unsigned int *triangles = &adjacency[adjacencyOffsets[v]];
+          unsigned int *last = triangles + remainingTriangles[v] - 1;
+          std::swap(*std::find(triangles, last + 1, (unsigned int) bestTriangle), *last);
+          remainingTriangles[v]--;
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache
+        newCache.assign(triangle, triangle + 3);
+        for (auto v : cache) {
+          if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+            newCache.push_back(v);
+          }
+        }
+
+        // Rescore touched vertices, including the ones pushed out of the cache
+        for (unsigned int i = 0; i < newCache.size(); i++) {
+          unsigned int v = newCache[i];
+          cachePositions[v] = i < FORSYTH_CACHE_SIZE ? i : -1;
+          vertexScores[v] = vertexScore(cachePositions[v], remainingTriangles[v]);
+        }
+
+        // Rescore their triangles and pick the best one touching the cache
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (auto v : newCache) {
+          for (unsigned int i = 0; i < remainingTriangles[v]; i++) {
+            unsigned int t = adjacency[adjacencyOffsets[v] + i];
+            triangleScores[t] = vertexScores[indices[t*3]] + vertexScores[indices[t*3+1]] + vertexScores[indices[t*3+2]];
+            if (triangleScores[t] > bestScore) {
+              bestScore = triangleScores[t];
+              bestTriangle = t;
+            }
+          }
+        }
+
+        if (newCache.size() > FORSYTH_CACHE_SIZE) {
+          newCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        std::swap(cache, newCache);
+
+        // Nothing in the cache is connected to the rest, so restart from the next unemitted triangle
+        if (bestTriangle < 0) {
+          while (scanPosition < triangleCount && emitted[scanPosition]) {
+            scanPosition++;
+          }
+          if (scanPosition < triangleCount) {
+            bestTriangle = scanPosition;
+          }
+        }
+      }
+
+      indices = std::move(result);
+    }
+
+    void MeshOptimizer::optimizeOverdraw(std::vector<Assets::Vertex> const &vertices, std::vector<unsigned int> &indices)
+    {
+      unsigned int triangleCount = indices.size()/3;
+      if (triangleCount == 0) {
+        return;
+      }
+
+      // Triangles that miss on all three vertices restart the cache, so clusters split there for free
+      std::vector<unsigned int> clusterStarts;
+      std::vector<unsigned int> timestamps(vertices.size(), 0);
+      unsigned int time = OVERDRAW_CACHE_SIZE + 1;
+      for (unsigned int t = 0; t < triangleCount; t++) {
+        int misses = 0;
+        for (int c = 0; c < 3; c++) {
+          unsigned int v = indices[t*3 + c];
+          if (time - timestamps[v] > OVERDRAW_CACHE_SIZE) {
+            timestamps[v] = time++;
+            misses++;
+          }
+        }
+        if (misses == 3) {
+          clusterStarts.push_back(t);
+        }
+      }
+      clusterStarts.push_back(triangleCount);
+
+      // Area-weighted centroid and normal for each cluster and for the whole mesh
+      struct Cluster
+      {
+        unsigned int mStart;
+        unsigned int mEnd;
+        glm::vec3 mCentroid;
+        glm::vec3 mNormal;
+        float mArea;
+        float mSortKey;
+      };
+      std::vector<Cluster> clusters;
+      glm::vec3 meshCentroid(0);
+      float meshArea = 0.0f;
+      for (unsigned int i = 0; i + 1 < clusterStarts.size(); i++) {
+        Cluster cluster = {clusterStarts[i], clusterStarts[i+1], glm::vec3(0), glm::vec3(0), 0.0f, 0.0f};
+        for (unsigned int t = cluster.mStart; t < cluster.mEnd; t++) {
+          glm::vec3 p0 = vertices[indices[t*3]].Position;
+          glm::vec3 p1 = vertices[indices[t*3+1]].Position;
+          glm::vec3 p2 = vertices[indices[t*3+2]].Position;
+          glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+          float area = glm::length(normal);
+          cluster.mCentroid += (p0 + p1 + p2) * (area/3.0f);
+          cluster.mNormal += normal;
+          cluster.mArea += area;
+        }
+        meshCentroid += cluster.mCentroid;
+        meshArea += cluster.mArea;
+        if (cluster.mArea > 0.0f) {
+          cluster.mCentroid /= cluster.mArea;
+        }
+        clusters.push_back(cluster);
+      }
+      if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+      }
+
+      // Clusters far out along their own normal are likely occluders, so draw them first
+      for (auto &cluster : clusters) {
+        float normalLength = glm::length(cluster.mNormal);
+        cluster.mSortKey = normalLength > 0.0f ? glm::dot(cluster.mCentroid - meshCentroid, cluster.mNormal/normalLength) : 0.0f;
+      }
+      std::stable_sort(clusters.begin(), clusters.end(), [](Cluster const &a, Cluster const &b) {
+        return a.mSortKey > b.mSortKey;
+      });
+
+      std::vector<unsigned int> result;
+      result.reserve(indices.size());
+      for (auto &cluster : clusters) {
+        result.insert(result.end(), indices.begin() + cluster.mStart*3, indices.begin() + cluster.mEnd*3);
+      }
+      indices = std::move(result);
+    }
+
+    void MeshOptimizer::optimizeVertexFetch(std::vector<Assets::Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+      // Unreferenced vertices are dropped
+      const unsigned int UNASSIGNED = ~0u;
+      std::vector<unsigned int> remap(vertices.size(), UNASSIGNED);
+      std::vector<Assets::Vertex> orderedVertices;
+      orderedVertices.reserve(vertices.size());
+      for (auto &index : indices) {
+        if (remap[index] == UNASSIGNED) {
+          remap[index] = orderedVertices.size();
+          orderedVertices.push_back(vertices[index]);
+        }
+        index = remap[index];
+      }
+      vertices = std::move(orderedVertices);
+    }
+
+    float MeshOptimizer::computeACMR(std::vector<unsigned int> const &indices, unsigned int vertexCount, unsigned int cacheSize)
+    {
+      unsigned int triangleCount = indices.size()/3;
+      if (triangleCount == 0) {
+        return 0.0f;
+      }
+
+      // A vertex is cached if fewer than cacheSize misses happened since it was loaded
+      std::vector<unsigned int> timestamps(vertexCount, 0);
+      unsigned int time = cacheSize + 1;
+      unsigned int misses = 0;
+      for (auto index : indices) {
+        if (time - timestamps[index] > cacheSize) {
+          timestamps[index] = time++;
+          misses++;
+        }
+      }
+      return (float) misses / triangleCount;
+    }
+}
@@ -0,0 +1,311 @@
+#include "Utils/meshsimplifier.hpp"
+#include "Utils/fileutils.hpp"
+#include "Utils/meshoptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+// Target index counts for each simplified level, relative to the base level
+const float LOD_RATIOS[] = {0.5f, 0.25f, 0.1f};
+// Levels are capped at this error relative to the bounding radius
+const float LOD_MAX_ERROR = 0.2f;
+// A level is only kept if it removes at least this fraction of the previous level's triangles
+const float LOD_MIN_REDUCTION = 0.2f;
+
+namespace
+{
+    // Symmetric 4x4 quadric, upper triangle only
+    struct Quadric
+    {
+      double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+
+      void addPlane(glm::vec3 const &n, double d)
+      {
+        a00 += n.x*n.x; a01 += n.x*n.y; a02 += n.x*n.z; a03 += n.x*d;
+        a11 += n.y*n.y; a12 += n.y*n.z; a13 += n.y*d;
+        a22 += n.z*n.z; a23 += n.z*d;
+        a33 += d*d;
+      }
+
+      void add(Quadric const &q)
+      {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+      }
+
+      // Sum of squared distances to the accumulated planes
+      double evaluate(glm::vec3 const &p) const
+      {
+        double x = p.x, y = p.y, z = p.z;
+        double result = a00*x*x + 2*a01*x*y + 2*a02*x*z + 2*a03*x
+                      + a11*y*y + 2*a12*y*z + 2*a13*y
+                      + a22*z*z + 2*a23*z
+                      + a33;
+        return std::max(result, 0.0);
+      }
+    };
+
+    struct PositionHasher
+    {
+      std::vector<Assets::Vertex> const *mVertices;
+      size_t operator()(unsigned int index) const
+      {
+        return Utils::FileUtils::hash(&(*mVertices)[index].Position, sizeof(glm::vec3));
+      }
+    };
+
+    struct PositionEqual
+    {
+      std::vector<Assets::Vertex> const *mVertices;
+      bool operator()(unsigned int a, unsigned int b) const
+      {
+        return memcmp(&(*mVertices)[a].Position, &(*mVertices)[b].Position, sizeof(glm::vec3)) == 0;
+      }
+    };
+
+    struct Collapse
+    {
+      unsigned int mFrom;
+      unsigned int mTo;
+      double mCost;
+    };
+
+    unsigned long long edgeKey(unsigned int a, unsigned int b)
+    {
+      return ((unsigned long long) std::min(a, b) << 32) | std::max(a, b);
+    }
+}
+
+namespace Utils
+{
+    std::vector<unsigned int> MeshSimplifier::simplify(std::vector<Assets::Vertex> const &vertices, std::vector<unsigned int> const &indices,
+                                                       unsigned int targetIndexCount, float maxError, float &error)
+    {
+      error = 0.0f;
+      unsigned int vertexCount = vertices.size();
+      if (indices.size() <= targetIndexCount || vertexCount == 0) {
+        return indices;
+      }
+
+      // Work in positions normalized to the bounding sphere so errors are scale independent
+      glm::vec3 boundsMin = vertices[0].Position;
+      glm::vec3 boundsMax = vertices[0].Position;
+      for (auto &vertex : vertices) {
+        boundsMin = glm::min(boundsMin, vertex.Position);
+        boundsMax = glm::max(boundsMax, vertex.Position);
+      }
+      glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+      float radius = glm::length(boundsMax - boundsMin) * 0.5f;
+      if (radius <= 0.0f) {
+        return indices;
+      }
+      std::vector<glm::vec3> positions(vertexCount);
+      for (unsigned int i = 0; i < vertexCount; i++) {
+        positions[i] = (vertices[i].Position - center) / radius;
+      }
+
+      // Collapse on positions; vertices that share a position with different attributes form a seam and are locked
+      std::unordered_map<unsigned int, unsigned int, PositionHasher, PositionEqual> uniquePositions(
+        vertexCount, PositionHasher{&vertices}, PositionEqual{&vertices}
+      );
+      std::vector<unsigned int> canonical(vertexCount);
+      std::vector<bool> locked(vertexCount, false);
+      for (unsigned int i = 0; i < vertexCount; i++) {
+        auto result = uniquePositions.insert(std::make_pair(i, i));
+        canonical[i] = result.first->second;
+        if (!result.second) {
+          locked[canonical[i]] = true;
+        }
+      }
+
+      // Open and non-manifold edges are locked so silhouettes and borders stay put
+      std::unordered_map<unsigned long long, unsigned int> edgeCounts;
+      for (unsigned int i = 0; i < indices.size(); i += 3) {
+        for (int e = 0; e < 3; e++) {
+          edgeCounts[edgeKey(canonical[indices[i + e]], canonical[indices[i + (e+1)%3]])]++;
+        }
+      }
+      for (auto &edgeCount : edgeCounts) {
+        if (edgeCount.second != 2) {
+          locked[edgeCount.first >> 32] = true;
+          locked[edgeCount.first & 0xFFFFFFFF] = true;
+        }
+      }
+
+      // Plane quadrics of every adjacent triangle
+      std::vector<Quadric> quadrics(vertexCount, Quadric{0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+      for (unsigned int i = 0; i < indices.size(); i += 3) {
+        unsigned int a = canonical[indices[i]], b = canonical[indices[i+1]], c = canonical[indices[i+2]];
+        glm::vec3 normal = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+        float length = glm::length(normal);
+        if (length <= 0.0f) {
+          continue;
+        }
+        normal /= length;
+        double d = -glm::dot(normal, positions[a]);
+        quadrics[a].addPlane(normal, d);
+        quadrics[b].addPlane(normal, d);
+        quadrics[c].addPlane(normal, d);
+      }
+
+      std::vector<unsigned int> collapsedTo(vertexCount);
+      for (unsigned int v = 0; v < vertexCount; v++) {
+        collapsedTo[v] = v;
+      }
+      auto resolve = [&collapsedTo](unsigned int v) {
+        while (collapsedTo[v] != v) {
+          v = collapsedTo[v];
+        }
+        return v;
+      };
+
+      // Source triangles still alive, and the same triangles in collapsed position ids
+      std::vector<unsigned int> sourceTriangles = indices;
+      std::vector<unsigned int> triangles(indices.size());
+
+      while (true) {
+        // Drop triangles that collapsed to a line
+        unsigned int live = 0;
+        for (unsigned int i = 0; i < sourceTriangles.size(); i += 3) {
+          unsigned int a = resolve(canonical[sourceTriangles[i]]);
+          unsigned int b = resolve(canonical[sourceTriangles[i+1]]);
+          unsigned int c = resolve(canonical[sourceTriangles[i+2]]);
+          if (a == b || b == c || a == c) {
+            continue;
+          }
+          std::copy(&sourceTriangles[i], &sourceTriangles[i] + 3, &sourceTriangles[live]);
+          triangles[live] = a;
+          triangles[live+1] = b;
+          triangles[live+2] = c;
+          live += 3;
+        }
+        sourceTriangles.resize(live);
+        triangles.resize(live);
+        if (live <= targetIndexCount) {
+          break;
+        }
+
+        // Vertex to triangle adjacency for flip checks
+        std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+        for (auto v : triangles) {
+          adjacencyOffsets[v+1]++;
+        }
+        for (unsigned int v = 0; v < vertexCount; v++) {
+          adjacencyOffsets[v+1] += adjacencyOffsets[v];
+        }
+        std::vector<unsigned int> adjacency(triangles.size());
+        std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (unsigned int i = 0; i < triangles.size(); i++) {
+          adjacency[fill[triangles[i]]++] = i/3;
+        }
+
+        // Cheapest collapses first
+        std::vector<Collapse> collapses;
+        collapses.reserve(triangles.size()*2);
+        for (unsigned int i = 0; i < triangles.size(); i += 3) {
+          for (int e = 0; e < 3; e++) {
+            unsigned int from = triangles[i + e];
+            unsigned int to = triangles[i + (e+1)%3];
+            for (int direction = 0; direction < 2; direction++) {
+              if (!locked[from]) {
+                Quadric quadric = quadrics[from];
+                quadric.add(quadrics[to]);
+                collapses.push_back({from, to, quadric.evaluate(positions[to])});
+              }
+              std::swap(from, to);
+            }
+          }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](Collapse const &a, Collapse const &b) {
+          return a.mCost < b.mCost;
+        });
+
+        // Apply independent collapses until the target or the error limit is reached
+        std::vector<bool> touched(vertexCount, false);
+        unsigned int removedIndices = 0;
+        bool collapsedAny = false;
+        for (auto &collapse : collapses) {
+          if (live - removedIndices <= targetIndexCount || std::sqrt(collapse.mCost) > maxError) {
+            break;
+          }
+          if (touched[collapse.mFrom] || touched[collapse.mTo]) {
+            continue;
+          }
+
+          // Reject collapses that flip a surviving triangle
+          bool valid = true;
+          unsigned int removedTriangles = 0;
+          for (unsigned int j = adjacencyOffsets[collapse.mFrom]; j < adjacencyOffsets[collapse.mFrom + 1] && valid; j++) {
+            const unsigned int *triangle = &triangles[adjacency[j]*3];
+            if (triangle[0] == collapse.mTo || triangle[1] == collapse.mTo || triangle[2] == collapse.mTo) {
+              removedTriangles++;
+              continue;
+            }
+            glm::vec3 before[3], after[3];
+            for (int c = 0; c < 3; c++) {
+              before[c] = positions[triangle[c]];
+              after[c] = triangle[c] == collapse.mFrom ? positions[collapse.mTo] : before[c];
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            valid = glm::dot(normalBefore, normalAfter) > 0.0f;
+          }
+          if (!valid) {
+            continue;
+          }
+
+          collapsedTo[collapse.mFrom] = collapse.mTo;
+          quadrics[collapse.mTo].add(quadrics[collapse.mFrom]);
+          error = std::max(error, (float) std::sqrt(collapse.mCost));
+          for (unsigned int j = adjacencyOffsets[collapse.mFrom]; j < adjacencyOffsets[collapse.mFrom + 1]; j++) {
+            const unsigned int *triangle = &triangles[adjacency[j]*3];
+            touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+          }
+          removedIndices += removedTriangles*3;
+          collapsedAny = true;
+        }
+
+        if (!collapsedAny) {
+          break;
+        }
+      }
+
+      // Untouched corners keep their own vertex; collapsed ones take the surviving position's vertex
+      std::vector<unsigned int> result(sourceTriangles.size());
+      for (unsigned int i = 0; i < sourceTriangles.size(); i++) {
+        unsigned int source = sourceTriangles[i];
+        unsigned int target = resolve(canonical[source]);
+        result[i] = target == canonical[source] ? source : target;
+      }
+      return result;
+    }
+
+    void MeshSimplifier::buildLodChain(std::vector<Assets::Vertex> const &vertices, std::vector<unsigned int> &indices,
+                                       std::vector<Assets::LodLevel> &lods)
+    {
+      unsigned int baseIndexCount = indices.size();
+      lods.clear();
+      lods.push_back({0, baseIndexCount, 0.0f});
+
+      std::vector<unsigned int> baseIndices(indices);
+      float previousError = 0.0f;
+      for (float ratio : LOD_RATIOS) {
+        unsigned int targetIndexCount = (unsigned int) (baseIndexCount/3*ratio)*3;
+        float error;
+        std::vector<unsigned int> lodIndices = simplify(vertices, baseIndices, targetIndexCount, LOD_MAX_ERROR, error);
+        if (lodIndices.empty() || lodIndices.size() > lods.back().mIndexCount*(1.0f - LOD_MIN_REDUCTION)) {
+          break;
+        }
+
+        // Every level is simplified from the base, so keep errors monotonic for selection
+        previousError = std::max(previousError, error);
+        MeshOptimizer::optimizeVertexCache(lodIndices, vertices.size());
+        lods.push_back({(unsigned int) indices.size(), (unsigned int) lodIndices.size(), previousError});
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+      }
+    }
+}
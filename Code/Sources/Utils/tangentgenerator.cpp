@@ -0,0 +1,177 @@
+#include "Utils/tangentgenerator.hpp"
+#include "Core/threadpool.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Triangles are processed in fixed-width batches of structure-of-arrays lanes the compiler can vectorize
+const unsigned int TRIANGLE_BATCH = 8;
+// Work split across the thread pool
+const unsigned int TRIANGLES_PER_TASK = 4096;
+const unsigned int VERTICES_PER_TASK = 4096;
+
+namespace
+{
+    // Per-triangle UV tangent directions and winding; orientation is zero where the UVs are degenerate
+    struct FaceFrames
+    {
+      std::vector<float> mTangentX, mTangentY, mTangentZ;
+      std::vector<float> mOrientation;
+    };
+
+    void computeFaceFrames(std::vector<Assets::Vertex> const &vertices, std::vector<unsigned int> const &indices,
+                           unsigned int begin, unsigned int end, FaceFrames &frames)
+    {
+      for (unsigned int batch = begin; batch < end; batch += TRIANGLE_BATCH) {
+        unsigned int count = std::min(TRIANGLE_BATCH, end - batch);
+
+        // Gather edges and UV deltas into lanes, padding unused lanes with degenerate triangles
+        float e1x[TRIANGLE_BATCH] = {}, e1y[TRIANGLE_BATCH] = {}, e1z[TRIANGLE_BATCH] = {};
+        float e2x[TRIANGLE_BATCH] = {}, e2y[TRIANGLE_BATCH] = {}, e2z[TRIANGLE_BATCH] = {};
+        float s1[TRIANGLE_BATCH] = {}, t1[TRIANGLE_BATCH] = {}, s2[TRIANGLE_BATCH] = {}, t2[TRIANGLE_BATCH] = {};
+        for (unsigned int lane = 0; lane < count; lane++) {
+          auto &v0 = vertices[indices[(batch + lane)*3]];
+          auto &v1 = vertices[indices[(batch + lane)*3 + 1]];
+          auto &v2 = vertices[indices[(batch + lane)*3 + 2]];
+          e1x[lane] = v1.Position.x - v0.Position.x;
+          e1y[lane] = v1.Position.y - v0.Position.y;
+          e1z[lane] = v1.Position.z - v0.Position.z;
+          e2x[lane] = v2.Position.x - v0.Position.x;
+          e2y[lane] = v2.Position.y - v0.Position.y;
+          e2z[lane] = v2.Position.z - v0.Position.z;
+          s1[lane] = v1.TexCoords.x - v0.TexCoords.x;
+          t1[lane] = v1.TexCoords.y - v0.TexCoords.y;
+          s2[lane] = v2.TexCoords.x - v0.TexCoords.x;
+          t2[lane] = v2.TexCoords.y - v0.TexCoords.y;
+        }
+
+        // Branch-free lane math; only the direction matters, so the UV area's sign replaces the division
+        float tx[TRIANGLE_BATCH], ty[TRIANGLE_BATCH], tz[TRIANGLE_BATCH], orientation[TRIANGLE_BATCH];
+        for (unsigned int lane = 0; lane < TRIANGLE_BATCH; lane++) {
+          float area = s1[lane]*t2[lane] - s2[lane]*t1[lane];
+          orientation[lane] = area > 0.0f ? 1.0f : (area < 0.0f ? -1.0f : 0.0f);
+          tx[lane] = (t2[lane]*e1x[lane] - t1[lane]*e2x[lane]) * orientation[lane];
+          ty[lane] = (t2[lane]*e1y[lane] - t1[lane]*e2y[lane]) * orientation[lane];
+          tz[lane] = (t2[lane]*e1z[lane] - t1[lane]*e2z[lane]) * orientation[lane];
+        }
+
+        for (unsigned int lane = 0; lane < count; lane++) {
+          frames.mTangentX[batch + lane] = tx[lane];
+          frames.mTangentY[batch + lane] = ty[lane];
+          frames.mTangentZ[batch + lane] = tz[lane];
+          frames.mOrientation[batch + lane] = orientation[lane];
+        }
+      }
+    }
+
+    glm::vec3 projectOntoPlane(glm::vec3 const &v, glm::vec3 const &normal)
+    {
+      return v - normal*glm::dot(normal, v);
+    }
+}
+
+namespace Utils
+{
+    void TangentGenerator::generate(std::vector<Assets::Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+      unsigned int triangleCount = indices.size()/3;
+      Core::ThreadPool &threadPool = Core::ThreadPool::getInstance();
+
+      // ***** FACE FRAMES *****
+      FaceFrames frames;
+      frames.mTangentX.resize(triangleCount);
+      frames.mTangentY.resize(triangleCount);
+      frames.mTangentZ.resize(triangleCount);
+      frames.mOrientation.resize(triangleCount);
+      int triangleTasks = (triangleCount + TRIANGLES_PER_TASK - 1)/TRIANGLES_PER_TASK;
+      threadPool.parallelFor(triangleTasks, [&](int task) {
+        unsigned int begin = task*TRIANGLES_PER_TASK;
+        computeFaceFrames(vertices, indices, begin, std::min(begin + TRIANGLES_PER_TASK, triangleCount), frames);
+      });
+
+      // ***** HANDEDNESS SPLITS *****
+      // A vertex shared by mirrored and unmirrored UV triangles cannot have one frame, so duplicate it
+      const unsigned int UNASSIGNED = ~0u;
+      std::vector<float> vertexOrientations(vertices.size(), 0.0f);
+      std::vector<unsigned int> splitVertices(vertices.size(), UNASSIGNED);
+      for (unsigned int t = 0; t < triangleCount; t++) {
+        float orientation = frames.mOrientation[t];
+        if (orientation == 0.0f) {
+          continue;
+        }
+        for (int corner = 0; corner < 3; corner++) {
+          unsigned int &index = indices[t*3 + corner];
+          if (vertexOrientations[index] == 0.0f) {
+            vertexOrientations[index] = orientation;
+          }
+          else if (vertexOrientations[index] != orientation) {
+            if (splitVertices[index] == UNASSIGNED) {
+              Assets::Vertex vertex = vertices[index];
+              splitVertices[index] = vertices.size();
+              vertices.push_back(vertex);
+              vertexOrientations.push_back(orientation);
+            }
+            index = splitVertices[index];
+          }
+        }
+      }
+
+      // ***** VERTEX FRAMES *****
+      // Vertex to corner adjacency, so each vertex is accumulated by exactly one task
+      unsigned int vertexCount = vertices.size();
+      std::vector<unsigned int> cornerOffsets(vertexCount + 1, 0);
+      for (auto index : indices) {
+        cornerOffsets[index + 1]++;
+      }
+      for (unsigned int v = 0; v < vertexCount; v++) {
+        cornerOffsets[v + 1] += cornerOffsets[v];
+      }
+      std::vector<unsigned int> corners(indices.size());
+      std::vector<unsigned int> fill(cornerOffsets.begin(), cornerOffsets.end() - 1);
+      for (unsigned int i = 0; i < indices.size(); i++) {
+        corners[fill[indices[i]]++] = i;
+      }
+
+      int vertexTasks = (vertexCount + VERTICES_PER_TASK - 1)/VERTICES_PER_TASK;
+      threadPool.parallelFor(vertexTasks, [&](int task) {
+        unsigned int begin = task*VERTICES_PER_TASK;
+        unsigned int end = std::min(begin + VERTICES_PER_TASK, vertexCount);
+        for (unsigned int v = begin; v < end; v++) {
+          auto &vertex = vertices[v];
+          glm::vec3 normal = glm::length(vertex.Normal) > 0.0f ? glm::normalize(vertex.Normal) : glm::vec3(0, 1, 0);
+
+          // Corner-angle weighted sum of the face tangents, each projected onto this vertex's tangent plane
+          glm::vec3 sum(0);
+          for (unsigned int i = cornerOffsets[v]; i < cornerOffsets[v + 1]; i++) {
+            unsigned int t = corners[i]/3;
+            unsigned int corner = corners[i]%3;
+            if (frames.mOrientation[t] == 0.0f) {
+              continue;
+            }
+            glm::vec3 tangent = projectOntoPlane(glm::vec3(frames.mTangentX[t], frames.mTangentY[t], frames.mTangentZ[t]), normal);
+            glm::vec3 edge1 = projectOntoPlane(vertices[indices[t*3 + (corner + 1)%3]].Position - vertex.Position, normal);
+            glm::vec3 edge2 = projectOntoPlane(vertices[indices[t*3 + (corner + 2)%3]].Position - vertex.Position, normal);
+            float tangentLength = glm::length(tangent);
+            float edgeLengths = glm::length(edge1)*glm::length(edge2);
+            if (tangentLength <= 0.0f || edgeLengths <= 0.0f) {
+              continue;
+            }
+            float angle = std::acos(std::max(-1.0f, std::min(1.0f, glm::dot(edge1, edge2)/edgeLengths)));
+            sum += tangent*(angle/tangentLength);
+          }
+
+          // Any perpendicular will do where there is no UV information
+          glm::vec3 tangent = projectOntoPlane(sum, normal);
+          if (glm::length(tangent) <= 1e-12f) {
+            glm::vec3 axis = std::fabs(normal.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+            tangent = glm::cross(axis, normal);
+          }
+          tangent = glm::normalize(tangent);
+
+          float orientation = vertexOrientations[v] < 0.0f ? -1.0f : 1.0f;
+          vertex.Tangent = tangent;
+          vertex.Bitangent = glm::cross(normal, tangent)*orientation;
+        }
+      });
+    }
+}
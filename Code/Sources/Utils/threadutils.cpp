@@ -0,0 +1,28 @@
+#include "Utils/threadutils.hpp"
+
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Utils
+{
+    bool ThreadUtils::setCurrentThreadAffinity(int cpu)
+    {
+#ifdef __linux__
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      CPU_SET(cpu, &cpuSet);
+      if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0) {
+        return true;
+      }
+      std::cout << "Failed to pin thread to CPU " << cpu << std::endl;
+      return false;
+#else
+      std::cout << "Thread affinity is not supported on this platform" << std::endl;
+      return false;
+#endif
+    }
+}
@@ -1,39 +1,150 @@
 #include "Physics/physicsengine.hpp"
+#include "Physics/physicsbenchmark.hpp"
 #include "Rendering/renderingengine.hpp"
+#include "Rendering/framepipeline.hpp"
+#include "Rendering/rendersnapshot.hpp"
 #include "Rendering/cubemap.hpp"
+#include "Rendering/graphicscontext.hpp"
 #include "Assets/shader.hpp"
+#include "Assets/meshcache.hpp"
+#include "Assets/shadercache.hpp"
+#include "Assets/texturecache.hpp"
 #include "Core/scene.hpp"
+#include "Core/random.hpp"
+#include "Core/simulationclock.hpp"
+#include "Core/staterecorder.hpp"
+#include "Core/trackpath.hpp"
+#include "Core/taskgraph.hpp"
+#include "Core/threadpool.hpp"
+#include "Components/carphysicsbody.hpp"
 #include "Objects/car.hpp"
 #include "Objects/terrain.hpp"
 #include "Objects/wall.hpp"
 #include "Objects/streetlight.hpp"
+#include "Scripts/trafficscript.hpp"
 #include "Utils/logger.hpp"
+#include "Utils/threadutils.hpp"
 #include "globals.hpp"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <iomanip>
 #include <memory>
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 const int FPS_ROLLING_FRAMES = 10;
+// Scripts and physics run at a fixed rate; frames slower than MAX_SIMULATION_TICKS ticks slow the simulation down instead
+const double SIMULATION_TICK_RATE = 60.0;
+const int MAX_SIMULATION_TICKS = 5;
+// Deterministic runs keep a snapshot every SNAPSHOT_INTERVAL ticks, the last SNAPSHOT_CAPACITY of them,
+// and rewind by REWIND_TICKS at a time
+const int SNAPSHOT_INTERVAL = 60;
+const int SNAPSHOT_CAPACITY = 30;
+const unsigned long long REWIND_TICKS = 300;
 const int NUM_STREETLIGHTS = 24;
 const float STREETLIGHT_OFFSET = 0.5f;
 const float TRACK_INNER_A = 58.0f;
 const float TRACK_INNER_B = 58.0f;
 const float TRACK_OUTER_A = 63.0f;
 const float TRACK_OUTER_B = 63.0f;
+// Traffic is split between two lanes, this far either side of the middle of the track
+const float TRAFFIC_LANE_OFFSET = 1.25f;
+// The racing line moves up to this far from the middle of the track, keeping both lanes clear of the walls
+const float RACING_LINE_SWING = 0.75f;
+
+// Command line options
+struct Options
+{
+    // Simulate the next frame on this thread while a render thread draws the current one
+    bool mPipelined = true;
+    int mFramesInFlight = 2;
+    // Logical CPUs to pin the simulation and render threads to, or -1 to leave them to the scheduler
+    int mSimulationCPU = -1;
+    int mRenderCPU = -1;
+    // Threads Bullet steps the world on, including the simulation thread
+    int mPhysicsThreads = 1;
+    // Time the physics world at several body and thread counts instead of running the scene
+    bool mPhysicsBenchmark = false;
+    // Cars placed around the track besides the player's
+    int mTrafficCars = 0;
+    // Drive the player's car with the traffic controller
+    bool mAutopilot = false;
+    // Step physics on one thread and record snapshots and per-tick state hashes, so the simulation can be rewound
+    // and replayed
+    bool mDeterministic = false;
+    // Seed for every random number stream
+    unsigned long long mSeed = 0;
+    // Run the scene without a window or GL context, as fast as it will go, for this many simulated seconds
+    bool mHeadless = false;
+    double mSimulateSeconds = 60.0;
+};
+
+Options parseOptions(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--single-threaded") {
+            options.mPipelined = false;
+        }
+        else if (argument == "--frames-in-flight" && hasValue) {
+            options.mFramesInFlight = std::max(2, std::min(3, std::atoi(argv[++i])));
+        }
+        else if (argument == "--simulation-cpu" && hasValue) {
+            options.mSimulationCPU = std::atoi(argv[++i]);
+        }
+        else if (argument == "--render-cpu" && hasValue) {
+            options.mRenderCPU = std::atoi(argv[++i]);
+        }
+        else if (argument == "--physics-threads" && hasValue) {
+            options.mPhysicsThreads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (argument == "--physics-benchmark") {
+            options.mPhysicsBenchmark = true;
+        }
+        else if (argument == "--traffic" && hasValue) {
+            options.mTrafficCars = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (argument == "--autopilot") {
+            options.mAutopilot = true;
+        }
+        else if (argument == "--deterministic") {
+            options.mDeterministic = true;
+        }
+        else if (argument == "--seed" && hasValue) {
+            options.mSeed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--headless") {
+            options.mHeadless = true;
+        }
+        else if (argument == "--simulate-seconds" && hasValue) {
+            options.mSimulateSeconds = std::max(0.0, std::atof(argv[++i]));
+        }
+        else {
+            std::cout << "Ignoring unknown option " << argument << std::endl;
+        }
+    }
+    return options;
+}
 
 // The following globals are used in the GLFW callbacks
 Core::Scene scene;
 bool firstMouse = true;
+// Set by the rewind key, and handled between ticks
+bool rewindRequested = false;
 double lastX;
 double lastY;
 
@@ -114,6 +225,23 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
     else if (key == GLFW_KEY_T && action == GLFW_PRESS) {
         scene.mRenderSettings.mDrawDebugLines = !scene.mRenderSettings.mDrawDebugLines;
     }
+    else if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        if (scene.mRenderSettings.mLightingResolution == Rendering::LightingResolution::FULL_RESOLUTION) {
+            scene.mRenderSettings.mLightingResolution = Rendering::LightingResolution::HALF_RESOLUTION;
+        }
+        else if (scene.mRenderSettings.mLightingResolution == Rendering::LightingResolution::HALF_RESOLUTION) {
+            scene.mRenderSettings.mLightingResolution = Rendering::LightingResolution::QUARTER_RESOLUTION;
+        }
+        else {
+            scene.mRenderSettings.mLightingResolution = Rendering::LightingResolution::FULL_RESOLUTION;
+        }
+    }
+    else if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+        scene.mRenderSettings.mDynamicResolution = !scene.mRenderSettings.mDynamicResolution;
+    }
+    else if (key == GLFW_KEY_BACKSPACE && action == GLFW_PRESS) {
+        rewindRequested = true;
+    }
 }
 
 
@@ -139,67 +267,122 @@ void framebufferSizeCallback(GLFWwindow* window, int newWidth, int newHeight)
     scene.mRenderSettings.mFramebufferHeight = newHeight;
 }
 
+// Steps the scene back to back with no frames in between, then reports how much faster than real time it ran
+void runHeadless(Options const &options, Physics::PhysicsEngine &physicsEngine, Core::StateRecorder *stateRecorder)
+{
+    if (options.mSimulationCPU >= 0) {
+        Utils::ThreadUtils::setCurrentThreadAffinity(options.mSimulationCPU);
+    }
+
+    double tickLength = 1.0/SIMULATION_TICK_RATE;
+    long long numTicks = std::llround(options.mSimulateSeconds*SIMULATION_TICK_RATE);
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < numTicks; i++) {
+        // There is nothing to draw, so scripts always see the latest simulation state
+        physicsEngine.interpolateTransforms(1.0f);
+        scene.update(nullptr, (float) tickLength);
+        physicsEngine.updateScene(scene, tickLength);
+        if (stateRecorder) {
+            stateRecorder->record();
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double simulatedSeconds = numTicks*tickLength;
+    std::cout << "Simulated " << simulatedSeconds << " s (" << numTicks << " ticks) in "
+              << std::fixed << std::setprecision(3) << wallSeconds << " s, "
+              << std::setprecision(1) << simulatedSeconds/std::max(wallSeconds, 1e-9) << " simulated seconds per second"
+              << std::endl;
+    if (stateRecorder) {
+        std::cout << "Final state hash: " << std::hex << std::setw(16) << std::setfill('0')
+                  << stateRecorder->getLastHash() << std::dec << std::endl;
+    }
+}
+
 int main(int argc, char * argv[])
 {   
-    //******* PERFORM INITIALIZATION *******
-    // Load GLFW
-    glfwInit();
-
-    // Register error callback
-    glfwSetErrorCallback(errorCallback);
-
-    // Create a window
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
-    auto window = glfwCreateWindow(INIT_WIDTH, INIT_HEIGHT, "Driving Scene - Jeffrey Everett", nullptr, nullptr);
-
-    // Determine framebuffer size
-    int fbWidth, fbHeight;
-    glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
-
-    // Check for valid context
-    if (window == nullptr) {
-        std::cout << "Failed to create OpenGL context. Exiting." << std::endl;
-        exit(1);
+    Options options = parseOptions(argc, argv);
+    Core::Random::setSeed(options.mSeed);
+    if (options.mDeterministic && options.mPhysicsThreads > 1) {
+        // Contacts found on several threads reach the solver in an order that varies from run to run
+        std::cout << "Deterministic runs step physics on one thread" << std::endl;
+        options.mPhysicsThreads = 1;
     }
 
-    // Create Context and load OpenGL Functions
-    glfwMakeContextCurrent(window);
-    gladLoadGL();
-    std::cout << "Using OpenGL " << glGetString(GL_VERSION) << std::endl;
+    if (options.mPhysicsBenchmark) {
+        std::vector<int> threadCounts;
+        int maxThreads = std::max<int>(options.mPhysicsThreads, Core::ThreadPool::getInstance().getNumThreads() + 1);
+        for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2) {
+            threadCounts.push_back(numThreads);
+        }
+        threadCounts.push_back(maxThreads);
+        Physics::PhysicsBenchmark::run({ 250, 1000, 4000, 16000 }, threadCounts, 300);
+        return 0;
+    }
+
+    //******* PERFORM INITIALIZATION *******
+    // Headless, nothing creates a window or touches GL; components keep only their CPU-side data
+    Rendering::GraphicsContext::setHeadless(options.mHeadless);
+    GLFWwindow *window = nullptr;
+    int fbWidth = INIT_WIDTH;
+    int fbHeight = INIT_HEIGHT;
+    if (!options.mHeadless) {
+        // Load GLFW
+        glfwInit();
+
+        // Register error callback
+        glfwSetErrorCallback(errorCallback);
+
+        // Create a window
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
+        window = glfwCreateWindow(INIT_WIDTH, INIT_HEIGHT, "Driving Scene - Jeffrey Everett", nullptr, nullptr);
+
+        // Determine framebuffer size
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+
+        // Check for valid context
+        if (window == nullptr) {
+            std::cout << "Failed to create OpenGL context. Exiting." << std::endl;
+            exit(1);
+        }
+
+        // Create Context and load OpenGL Functions
+        glfwMakeContextCurrent(window);
+        gladLoadGL();
+        std::cout << "Using OpenGL " << glGetString(GL_VERSION) << std::endl;
+
+        // Initialize GLAD
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+    }
 
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+    // Compressed textures, cooked meshes and program binaries are cached next to the sources
+    Assets::TextureCache::initialize(PROJECT_SOURCE_DIR "/Cache/Textures");
+    Assets::MeshCache::initialize(PROJECT_SOURCE_DIR "/Cache/Meshes");
+    if (!options.mHeadless) {
+        Assets::ShaderCache::initialize(PROJECT_SOURCE_DIR "/Cache/Shaders", (GLADloadproc) glfwGetProcAddress);
     }
 
     //******* CREATE ENGINES ******
     // Create base engines
-    Physics::PhysicsEngine physicsEngine;
-    Rendering::RenderingEngine renderingEngine(fbWidth, fbHeight);
-
-    // Make necessary connections
-    physicsEngine.connectDebugRenderer(&(*renderingEngine.mDebugRenderer));
-    
-    
-    //******* CREATE REUSABLE ASSETS *******
-    auto defaultGeometryShader = std::make_shared<Assets::Shader>(
-        PROJECT_SOURCE_DIR "/Shaders/VertexShaders/gbuffer.vert",
-        PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/gbuffer.frag"
-    );
-    auto defaultTerrainShader = std::make_shared<Assets::Shader>(
-        PROJECT_SOURCE_DIR "/Shaders/VertexShaders/terrain.vert",
-        PROJECT_SOURCE_DIR "/Shaders/TessCtrlShaders/terrain.tcs",
-        PROJECT_SOURCE_DIR "/Shaders/TessEvalShaders/terrain.tes",
-        PROJECT_SOURCE_DIR "/Shaders/GeometryShaders/terrain.geom",
-        PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/terrain.frag"
-    );
+    Physics::PhysicsEngine physicsEngine(options.mPhysicsThreads);
+    std::unique_ptr<Rendering::RenderingEngine> renderingEngine;
+    Core::ThreadPool &threadPool = Core::ThreadPool::getInstance();
+
+    //******* LOAD ASSETS *******
+    // File I/O, image decoding and model import run on worker threads,
+    // GL resource creation runs here on the context thread, unless headless
+    Core::TaskGraph startupGraph(threadPool);
+    std::shared_ptr<Assets::Shader> defaultGeometryShader;
+    std::shared_ptr<Assets::Shader> defaultTerrainShader;
 
-    //******* CREATE SCENE *******
     std::vector<std::string> darkFaces {
         PROJECT_SOURCE_DIR "/Textures/CubeMaps/DarkStormy/DarkStormyLeft2048.png",
         PROJECT_SOURCE_DIR "/Textures/CubeMaps/DarkStormy/DarkStormyRight2048.png",
@@ -208,27 +391,119 @@ int main(int argc, char * argv[])
         PROJECT_SOURCE_DIR "/Textures/CubeMaps/DarkStormy/DarkStormyFront2048.png",
         PROJECT_SOURCE_DIR "/Textures/CubeMaps/DarkStormy/DarkStormyBack2048.png"
     };
-    scene.mCubeMap.setFaces(darkFaces);
+    std::vector<int> cubeMapFaceTasks;
+    for (unsigned int i = 0; i < darkFaces.size() && !options.mHeadless; i++) {
+        cubeMapFaceTasks.push_back(startupGraph.addWorkerTask("Decode cubemap face " + std::to_string(i), [i, &darkFaces]() {
+            scene.mCubeMap.loadFace(i, darkFaces[i]);
+        }));
+    }
+    int loadCarTask = startupGraph.addWorkerTask("Load car", []() {
+        Objects::Car::load();
+    });
+    int loadTerrainTask = startupGraph.addWorkerTask("Load terrain", []() {
+        Objects::Terrain::load();
+    });
+    int loadStreetlightTask = startupGraph.addWorkerTask("Load streetlight", []() {
+        Objects::Streetlight::load();
+    });
+    int loadWallTask = startupGraph.addWorkerTask("Load wall", []() {
+        Objects::Wall::load(TRACK_INNER_A, TRACK_INNER_B, TRACK_OUTER_A, TRACK_OUTER_B);
+    });
+
+    if (!options.mHeadless) {
+        startupGraph.addMainTask("Create rendering engine", [&]() {
+            renderingEngine = std::make_unique<Rendering::RenderingEngine>();
+            physicsEngine.connectDebugRenderer(&(*renderingEngine->mDebugRenderer));
+        });
+        int shadersTask = startupGraph.addMainTask("Compile shaders", [&]() {
+            defaultGeometryShader = std::make_shared<Assets::Shader>(
+                PROJECT_SOURCE_DIR "/Shaders/VertexShaders/gbuffer.vert",
+                PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/gbuffer.frag"
+            );
+            // Features in Rendering::TerrainPermutation order
+            Assets::ShaderOptions terrainOptions;
+            terrainOptions.mFeatures = {"WIREFRAME_OVERLAY", "WIREFRAME_ONLY"};
+            defaultTerrainShader = std::make_shared<Assets::Shader>(
+                PROJECT_SOURCE_DIR "/Shaders/VertexShaders/terrain.vert",
+                PROJECT_SOURCE_DIR "/Shaders/TessCtrlShaders/terrain.tcs",
+                PROJECT_SOURCE_DIR "/Shaders/TessEvalShaders/terrain.tes",
+                PROJECT_SOURCE_DIR "/Shaders/GeometryShaders/terrain.geom",
+                PROJECT_SOURCE_DIR "/Shaders/FragmentShaders/terrain.frag",
+                terrainOptions
+            );
+        });
+        startupGraph.addMainTask("Upload cubemap", []() {
+            scene.mCubeMap.upload();
+        }, cubeMapFaceTasks);
+        startupGraph.addMainTask("Setup car", [&]() {
+            Objects::Car::setup(defaultGeometryShader);
+        }, {loadCarTask, shadersTask});
+        startupGraph.addMainTask("Setup terrain", [&]() {
+            Objects::Terrain::setup(defaultTerrainShader);
+        }, {loadTerrainTask, shadersTask});
+        startupGraph.addMainTask("Setup streetlight", [&]() {
+            Objects::Streetlight::setup(defaultGeometryShader);
+        }, {loadStreetlightTask, shadersTask});
+        startupGraph.addMainTask("Setup wall", [&]() {
+            Objects::Wall::setup(defaultGeometryShader);
+        }, {loadWallTask, shadersTask});
+    }
+
+    startupGraph.run();
+    startupGraph.report();
+
+    //******* CREATE SCENE *******
     scene.mRenderSettings.mRenderMode = Rendering::RenderMode::DEFERRED_SHADING;
     scene.mRenderSettings.mTerrainRenderMode = Rendering::TerrainRenderMode::ALBEDO_AND_WIREFRAME;
     scene.mRenderSettings.mFXAARenderMode = Rendering::FXAARenderMode::FXAA_AND_DEBUG;
+    scene.mRenderSettings.mLightingResolution = Rendering::LightingResolution::FULL_RESOLUTION;
     scene.mRenderSettings.mDrawDebugLines = true;
+    scene.mRenderSettings.mFogDensity = 0.003f;
+    scene.mRenderSettings.mExposure = 1.0f;
+    scene.mRenderSettings.mContrast = 1.05f;
+    scene.mRenderSettings.mSaturation = 1.1f;
+    scene.mRenderSettings.mDynamicResolution = true;
+    scene.mRenderSettings.mMinRenderScale = 0.5f;
+    scene.mRenderSettings.mMaxRenderScale = 1.0f;
+    scene.mRenderSettings.mTargetGPUFrameTime = 0.015f;
     scene.mRenderSettings.mFramebufferWidth = fbWidth;
     scene.mRenderSettings.mFramebufferHeight = fbHeight;
 
     //******* CREATE GAMEOBJECTS *******
-    // Setup objects
-    Objects::Wall::setup(defaultGeometryShader, TRACK_INNER_A, TRACK_INNER_B, TRACK_OUTER_A, TRACK_OUTER_B);
-    Objects::Car::setup(defaultGeometryShader);
-    Objects::Terrain::setup(defaultTerrainShader);
-    Objects::Streetlight::setup(defaultGeometryShader);
-
     // Add car
     glm::vec3 carStartingPosition = glm::vec3(-TRACK_INNER_A - (TRACK_OUTER_A-TRACK_INNER_A)/2, 1, 0);
     Utils::Logger::log("Car starting position", carStartingPosition);
     auto car = std::make_shared<Objects::Car>(carStartingPosition, physicsEngine);
     scene.add(car);
 
+    // Add traffic, spread evenly around both lanes and leaving the player's starting point clear. Traffic drives
+    // its lane of the racing line, and away from the player follows it instead of running full vehicle dynamics.
+    auto racingLine = Core::TrackPath::createRacingLine(TRACK_INNER_A, TRACK_INNER_B, TRACK_OUTER_A, TRACK_OUTER_B,
+                                                        RACING_LINE_SWING, 64);
+    auto trafficGameObject = std::make_shared<Core::GameObject>(glm::vec3(0));
+    auto trafficScript = std::make_shared<Scripts::TrafficScript>(*trafficGameObject, racingLine);
+    trafficGameObject->addComponent<Components::Script>(trafficScript);
+    if (options.mAutopilot) {
+        trafficScript->addAgent(car->getComponents<Components::CarPhysicsBody>()[0], 0.0f);
+    }
+    int trafficPerLane = (options.mTrafficCars + 1)/2;
+    for (int i = 0; i < options.mTrafficCars; i++) {
+        float laneOffset = i % 2 == 0 ? -TRAFFIC_LANE_OFFSET : TRAFFIC_LANE_OFFSET;
+        float theta = glm::radians(180.0f) + glm::radians(360.0f)*(i/2 + 1)/(trafficPerLane + 1);
+        glm::vec3 trafficPosition = glm::vec3(
+            ((TRACK_INNER_A+TRACK_OUTER_A)/2 + laneOffset)*glm::cos(theta), 1,
+            ((TRACK_INNER_B+TRACK_OUTER_B)/2 + laneOffset)*glm::sin(theta));
+        auto trafficCar = std::make_shared<Objects::Car>(trafficPosition, physicsEngine, false);
+        // Face along the track, the way the player starts
+        trafficCar->mTransform->setRotation(glm::angleAxis(-theta, glm::vec3(0, 1, 0)));
+        auto trafficPhysicsBody = trafficCar->getComponents<Components::CarPhysicsBody>()[0];
+        trafficPhysicsBody->mTrackPath = racingLine;
+        trafficScript->addAgent(trafficPhysicsBody, laneOffset);
+        scene.add(trafficCar);
+    }
+    // Added after the cars, so its controls override the player's keys under autopilot
+    scene.add(trafficGameObject);
+
     // Add streetlights
     for (int i = 0; i < NUM_STREETLIGHTS/2; i++) {
         float theta = glm::radians(360.0f)*i/(NUM_STREETLIGHTS/2);
@@ -251,14 +526,38 @@ int main(int argc, char * argv[])
     scene.add(wall);
 
     //******* Register remaining callbacks *******
-    glfwSetKeyCallback(window, keyCallback);
-    glfwSetCursorPosCallback(window, mouseCallback);
-    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    if (!options.mHeadless) {
+        glfwSetKeyCallback(window, keyCallback);
+        glfwSetCursorPosCallback(window, mouseCallback);
+        glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    }
 
     //******* Initialize scene *******
     scene.initialize();
+    std::unique_ptr<Core::StateRecorder> stateRecorder;
+    if (options.mDeterministic) {
+        stateRecorder = std::make_unique<Core::StateRecorder>(scene, physicsEngine, SNAPSHOT_CAPACITY, SNAPSHOT_INTERVAL);
+        stateRecorder->record();
+    }
+
+    if (options.mHeadless) {
+        runHeadless(options, physicsEngine, stateRecorder.get());
+        return EXIT_SUCCESS;
+    }
 
     //******* Game loop *******
+    // This thread simulates and polls events, which GLFW requires on the main thread; drawing moves to
+    // a render thread when pipelined
+    std::unique_ptr<Rendering::FramePipeline> framePipeline;
+    Rendering::RenderSnapshot snapshot;
+    if (options.mPipelined) {
+        framePipeline = std::make_unique<Rendering::FramePipeline>(window, *renderingEngine, options.mFramesInFlight, options.mRenderCPU);
+    }
+    if (options.mSimulationCPU >= 0) {
+        Utils::ThreadUtils::setCurrentThreadAffinity(options.mSimulationCPU);
+    }
+
+    Core::SimulationClock simulationClock(SIMULATION_TICK_RATE, MAX_SIMULATION_TICKS);
     double lastFrame = glfwGetTime();
     while (glfwWindowShouldClose(window) == 0) {
         // FPS timing/display
@@ -271,19 +570,51 @@ int main(int argc, char * argv[])
         std::cout << "Delta time: " << deltaTime << std::endl;
 #endif
 
-        // Handle input
-        scene.update(window, deltaTime);
+        if (rewindRequested) {
+            rewindRequested = false;
+            if (!stateRecorder) {
+                std::cout << "Rewinding needs --deterministic" << std::endl;
+            }
+            else if (!stateRecorder->rewind(REWIND_TICKS)) {
+                std::cout << "No snapshot is old enough to rewind to" << std::endl;
+            }
+        }
+
+        int ticks = simulationClock.advance(deltaTime);
+        if (ticks > 0) {
+            // Scripts act on the simulation state, not the interpolated one drawn last frame
+            physicsEngine.interpolateTransforms(1.0f);
+        }
+        for (int i = 0; i < ticks; i++) {
+            // Handle input
+            scene.update(window, (float) simulationClock.getTickLength());
+
+            // Tick physics engine
+            physicsEngine.updateScene(scene, simulationClock.getTickLength());
+            if (stateRecorder) {
+                stateRecorder->record();
+            }
+        }
+        physicsEngine.drawDebugWorld();
 
-        // Tick physics engine
-        physicsEngine.updateScene(scene, deltaTime);
+        // Draw between the last two simulation states
+        physicsEngine.interpolateTransforms((float) simulationClock.getInterpolationFactor());
 
         // Draw scene
-        renderingEngine.renderScene(scene, deltaTime, fps);
+        if (framePipeline) {
+            framePipeline->acquireSnapshot().capture(scene, *renderingEngine->mDebugRenderer, deltaTime, fps);
+            framePipeline->submitSnapshot();
+        }
+        else {
+            snapshot.capture(scene, *renderingEngine->mDebugRenderer, deltaTime, fps);
+            renderingEngine->renderScene(snapshot);
 
-        // Flip buffers and draw
-        glfwSwapBuffers(window);
+            // Flip buffers and draw
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
     }
+    framePipeline.reset();
     glfwTerminate();
 
     return EXIT_SUCCESS;
@@ -0,0 +1,198 @@
+#version 440 core
+
+// Whole post-processing stack in one pass. Fog, exposure and tonemapping, and color grading are applied
+// once per source texel into a shared memory tile; FXAA and the upscale to the output size then sample
+// the tile, so adding an effect adds no extra reads or writes of full-screen images.
+//
+// Features:
+//   FXAA       - Edge anti-aliasing on the graded image
+//   SHOW_EDGES - Draws pixels FXAA treats as edges in purple
+
+// Note: FXAA based off of https://github.com/McNopper/OpenGL/blob/master/Example42/shader/fxaa.frag.glsl
+// see FXAA
+// http://developer.download.nvidia.com/assets/gamedev/files/sdk/11/FXAA_WhitePaper.pdf
+// http://iryoku.com/aacourse/downloads/09-FXAA-3.11-in-15-Slides.pdf
+// http://horde3d.org/wiki/index.php5?title=Shading_Technique_-_FXAA
+
+#define TILE_SIZE 16
+// Source texels cached on each side of the tile, covering the neighbourhood FXAA samples
+#define APRON 2
+// Plus one, since the source footprint of a tile need not be texel aligned when upscaling
+#define CACHE_SIZE (TILE_SIZE + 2 * APRON + 1)
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE, local_size_z = 1) in;
+
+// Output
+layout(binding = 0, rgba8) writeonly uniform image2D outputImage;
+
+// Uniforms
+uniform sampler2D colorTexture;
+uniform sampler2D positionTexture;
+
+// Source texels covered by the render area, and source texels per output pixel
+uniform vec2 renderSize;
+uniform vec2 sourceScale;
+
+uniform vec3 viewPos;
+uniform vec3 fogColor;
+uniform float fogDensity;
+
+uniform float exposure;
+uniform float contrast;
+uniform float saturation;
+
+uniform float lumaThreshold;
+uniform float mulReduce;
+uniform float minReduce;
+uniform float maxSpan;
+
+// Graded colors of the tile's source footprint
+shared vec3 cachedColor[CACHE_SIZE][CACHE_SIZE];
+
+// Source texel held by cachedColor[0][0]
+ivec2 cacheOrigin;
+
+// see http://en.wikipedia.org/wiki/Grayscale
+const vec3 toLuma = vec3(0.299, 0.587, 0.114);
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 Tonemap(vec3 color)
+{
+  return clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);
+}
+
+vec3 ProcessTexel(ivec2 texel)
+{
+  texel = clamp(texel, ivec2(0), ivec2(renderSize) - 1);
+  vec3 color = texelFetch(colorTexture, texel, 0).rgb;
+  vec4 position = texelFetch(positionTexture, texel, 0);
+
+  // Fog, same as GL_EXP, on everything written to the gBuffer
+  if (position.a != 0.0) {
+    float f = exp(-fogDensity * distance(viewPos, position.xyz));
+    color = mix(fogColor, color, f);
+  }
+
+  // Exposure and tonemapping
+  color = Tonemap(color * exposure);
+
+  // Color grading
+  color = (color - 0.5) * contrast + 0.5;
+  color = mix(vec3(dot(color, toLuma)), color, saturation);
+  return clamp(color, 0.0, 1.0);
+}
+
+// Bilinear sample at a position in source texels. Reads the tile cache when the footprint lies within it,
+// otherwise processes the texels from the source images.
+vec3 SampleColor(vec2 sourcePosition)
+{
+  vec2 texelPosition = clamp(sourcePosition, vec2(0.5), renderSize - 0.5) - 0.5;
+  ivec2 texel = ivec2(floor(texelPosition));
+  vec2 fraction = texelPosition - vec2(texel);
+
+  ivec2 c = texel - cacheOrigin;
+  vec3 c00, c10, c01, c11;
+  if (all(greaterThanEqual(c, ivec2(0))) && all(lessThan(c + 1, ivec2(CACHE_SIZE)))) {
+    c00 = cachedColor[c.y][c.x];
+    c10 = cachedColor[c.y][c.x + 1];
+    c01 = cachedColor[c.y + 1][c.x];
+    c11 = cachedColor[c.y + 1][c.x + 1];
+  }
+  else {
+    c00 = ProcessTexel(texel);
+    c10 = ProcessTexel(texel + ivec2(1, 0));
+    c01 = ProcessTexel(texel + ivec2(0, 1));
+    c11 = ProcessTexel(texel + ivec2(1, 1));
+  }
+  return mix(mix(c00, c10, fraction.x), mix(c01, c11, fraction.x), fraction.y);
+}
+
+#ifdef FXAA
+vec3 ApplyFXAA(vec2 sourcePosition, vec3 rgbM)
+{
+  // Sampling neighbour texels
+  vec3 rgbNW = SampleColor(sourcePosition + vec2(-1.0, 1.0));
+  vec3 rgbNE = SampleColor(sourcePosition + vec2(1.0, 1.0));
+  vec3 rgbSW = SampleColor(sourcePosition + vec2(-1.0, -1.0));
+  vec3 rgbSE = SampleColor(sourcePosition + vec2(1.0, -1.0));
+
+  // Convert from RGB to luma.
+  float lumaNW = dot(rgbNW, toLuma);
+  float lumaNE = dot(rgbNE, toLuma);
+  float lumaSW = dot(rgbSW, toLuma);
+  float lumaSE = dot(rgbSE, toLuma);
+  float lumaM = dot(rgbM, toLuma);
+
+  // Gather minimum and maximum luma.
+  float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+  float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+  // If contrast is lower than a maximum threshold ...
+  if (lumaMax - lumaMin <= lumaMax * lumaThreshold) {
+    // ... do no AA and return.
+    return rgbM;
+  }
+
+  // Sampling is done along the gradient.
+  vec2 samplingDirection;
+  samplingDirection.x = -((lumaNW + lumaNE) - (lumaSW + lumaSE));
+  samplingDirection.y =  ((lumaNW + lumaSW) - (lumaNE + lumaSE));
+
+  // Sampling step distance depends on the luma: The brighter the sampled texels, the smaller the final sampling step direction.
+  float samplingDirectionReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * mulReduce, minReduce);
+
+  // Factor for norming the sampling direction plus adding the brightness influence.
+  float minSamplingDirectionFactor = 1.0 / (min(abs(samplingDirection.x), abs(samplingDirection.y)) + samplingDirectionReduce);
+
+  // Calculate final sampling direction vector by reducing and clamping to a range, in source texels.
+  samplingDirection = clamp(samplingDirection * minSamplingDirectionFactor, vec2(-maxSpan), vec2(maxSpan));
+
+  // Inner samples on the tab.
+  vec3 rgbSampleNeg = SampleColor(sourcePosition + samplingDirection * (1.0/3.0 - 0.5));
+  vec3 rgbSamplePos = SampleColor(sourcePosition + samplingDirection * (2.0/3.0 - 0.5));
+
+  vec3 rgbTwoTab = (rgbSamplePos + rgbSampleNeg) * 0.5;
+
+  // Outer samples on the tab.
+  vec3 rgbSampleNegOuter = SampleColor(sourcePosition + samplingDirection * (0.0/3.0 - 0.5));
+  vec3 rgbSamplePosOuter = SampleColor(sourcePosition + samplingDirection * (3.0/3.0 - 0.5));
+
+  vec3 rgbFourTab = (rgbSamplePosOuter + rgbSampleNegOuter) * 0.25 + rgbTwoTab * 0.5;
+
+  // Show edges for debug purposes.
+#ifdef SHOW_EDGES
+  return vec3(1.0, 0.0, 1.0);
+#endif
+
+  // Are outer samples of the tab beyond the edge? If so, use only two samples.
+  float lumaFourTab = dot(rgbFourTab, toLuma);
+  if (lumaFourTab < lumaMin || lumaFourTab > lumaMax) {
+    return rgbTwoTab;
+  }
+  return rgbFourTab;
+}
+#endif
+
+void main()
+{
+  // Cooperatively process the tile's source footprint, padded by the apron
+  vec2 tileMin = vec2(gl_WorkGroupID.xy * TILE_SIZE) * sourceScale;
+  cacheOrigin = ivec2(floor(tileMin)) - APRON;
+  for (uint i = gl_LocalInvocationIndex; i < CACHE_SIZE * CACHE_SIZE; i += TILE_SIZE * TILE_SIZE) {
+    ivec2 c = ivec2(i % CACHE_SIZE, i / CACHE_SIZE);
+    cachedColor[c.y][c.x] = ProcessTexel(cacheOrigin + c);
+  }
+  barrier();
+
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(pixel, imageSize(outputImage)))) {
+    return;
+  }
+
+  vec2 sourcePosition = (vec2(pixel) + 0.5) * sourceScale;
+  vec3 color = SampleColor(sourcePosition);
+#ifdef FXAA
+  color = ApplyFXAA(sourcePosition, color);
+#endif
+  imageStore(outputImage, pixel, vec4(color, 1.0));
+}
@@ -0,0 +1,25 @@
+#version 440 core
+
+// Inputs
+in vec2 vTexCoords;
+
+// Uniforms
+uniform sampler2D depthTexture;
+
+// Size of an output texel in input texels, and the input texels covered by the render area
+uniform int downsample;
+uniform vec2 renderSize;
+
+void main()
+{
+    // Keep the farthest depth of the block, so nothing behind the nearest surface in it is rejected early
+    ivec2 base = ivec2(gl_FragCoord.xy) * downsample;
+    ivec2 maxTexel = ivec2(renderSize) - 1;
+    float depth = 0.0;
+    for (int y = 0; y < downsample; y++) {
+        for (int x = 0; x < downsample; x++) {
+            depth = max(depth, texelFetch(depthTexture, min(base + ivec2(x, y), maxTexel), 0).r);
+        }
+    }
+    gl_FragDepth = depth;
+}
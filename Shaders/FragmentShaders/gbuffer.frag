@@ -6,9 +6,7 @@ in vec2 vTexCoords;
 in mat3 vTBN;
 
 // Outputs
-layout (location = 0) out vec4 fPosition;
-layout (location = 1) out vec3 fNormal;
-layout (location = 2) out vec4 fAlbedoSpec;
+#include "../Include/gbuffer_outputs.glsl"
 
 // Uniforms
 uniform sampler2D albedoMap;
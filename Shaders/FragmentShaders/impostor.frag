@@ -0,0 +1,28 @@
+#version 440 core
+
+// Inputs
+in vec2 vTexCoords;
+flat in mat4 vModel;
+flat in mat3 vNormalMatrix;
+
+// Outputs
+#include "../Include/gbuffer_outputs.glsl"
+
+// Uniforms
+uniform sampler2D positionAtlas;
+uniform sampler2D normalAtlas;
+uniform sampler2D albedoSpecAtlas;
+
+
+void main()
+{
+    // Baked positions are in object space, with w marking coverage
+    vec4 position = texture(positionAtlas, vTexCoords);
+    if (position.w < 0.5) {
+        discard;
+    }
+
+    fPosition = vec4((vModel * vec4(position.xyz, 1.0)).xyz, 1.0);
+    fNormal = vNormalMatrix * texture(normalAtlas, vTexCoords).rgb;
+    fAlbedoSpec = texture(albedoSpecAtlas, vTexCoords);
+}
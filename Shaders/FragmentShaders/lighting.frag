@@ -1,46 +1,23 @@
 #version 440 core
 
+// Features:
+//   LOW_RESOLUTION - Writes diffuse and specular light for one gBuffer texel per downsample x downsample block
+//   UPSAMPLE       - Reconstructs LOW_RESOLUTION output with a depth and normal guided bilateral filter,
+//                    lighting pixels on geometric edges at full rate instead
+
 // Inputs
 in vec2 vTexCoords;
 
 // Outputs
+#ifdef LOW_RESOLUTION
+layout (location = 0) out vec3 fDiffuse;
+layout (location = 1) out vec3 fSpecular;
+#else
 out vec4 fFragColor;
+#endif
 
 // Uniforms
-struct DirLight {
-    vec3 direction;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct SpotLight {
-    vec3  position;
-    vec3  direction;
-    float innerCutoff;
-    float outerCutoff;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+#include "../Include/lights.glsl"
 
 struct GBufferInputs {
     vec3 position;
@@ -49,6 +26,12 @@ struct GBufferInputs {
     float specular;
 };
 
+// Light arriving at a surface, before its albedo and specular intensity are applied
+struct LightingResult {
+    vec3 diffuse;
+    vec3 specular;
+};
+
 // gBuffer textures
 uniform sampler2D positionTexture;
 uniform sampler2D normalTexture;
@@ -56,22 +39,122 @@ uniform sampler2D albedoSpecTexture;
 
 // Lights
 uniform DirLight dirLight;
-#define NR_POINT_LIGHTS 6
 uniform PointLight pointLights[NR_POINT_LIGHTS];
-#define NR_SPOT_LIGHTS 4
-uniform SpotLight spotLights[NR_SPOT_LIGHTS];
+// Spot lights whose range reaches the view, culled and uploaded by the renderer every frame
+layout (std430, binding = 0) readonly buffer SpotLightBuffer {
+    SpotLight spotLights[];
+};
+uniform int spotLightCount;
 
 // Other inputs
 uniform vec3 viewPos;
-uniform vec4 fogColor;
-uniform float fogDensity;
 
-vec3 CalcDirLight(DirLight light, vec3 viewDir, GBufferInputs gBufferInputs);
-vec3 CalcPointLight(PointLight light, vec3 viewDir, GBufferInputs gBufferInputs);
-vec3 CalcSpotLight(SpotLight light, vec3 viewDir, GBufferInputs gBufferInputs);
+#if defined(LOW_RESOLUTION) || defined(UPSAMPLE)
+// Size of a low resolution texel in gBuffer texels, and the gBuffer texels covered by the render area
+uniform int downsample;
+uniform vec2 renderSize;
+#endif
+
+#ifdef UPSAMPLE
+// Low resolution lighting
+uniform sampler2D diffuseTexture;
+uniform sampler2D specularTexture;
+
+// A tap whose depth and normal weight falls below this marks an edge
+const float EDGE_THRESHOLD = 0.5;
+// Depth difference, relative to the pixel's depth, at which a tap's weight falls to 1/e
+const float DEPTH_SIGMA = 0.05;
+const float NORMAL_POWER = 16.0;
+#endif
+
+void CalcDirLight(DirLight light, vec3 viewDir, vec3 normal, inout LightingResult result);
+void CalcPointLight(PointLight light, vec3 viewDir, vec3 position, vec3 normal, inout LightingResult result);
+void CalcSpotLight(SpotLight light, vec3 viewDir, vec3 position, vec3 normal, inout LightingResult result);
+
+LightingResult EvaluateLights(vec3 position, vec3 normal)
+{
+    // Convencence calculations
+    vec3 viewDir = normalize(viewPos - position);
+
+    LightingResult result;
+    result.diffuse = vec3(0.0);
+    result.specular = vec3(0.0);
+    // Phase 1: Directional lighting
+    CalcDirLight(dirLight, viewDir, normal, result);
+    // Phase 2: Point lights
+    for(int i = 0; i < NR_POINT_LIGHTS; i++)
+        CalcPointLight(pointLights[i], viewDir, position, normal, result);
+    // Phase 3: Spot light
+    for (int i = 0; i < spotLightCount; i++)
+        CalcSpotLight(spotLights[i], viewDir, position, normal, result);
+    return result;
+}
+
+#if defined(LOW_RESOLUTION) || defined(UPSAMPLE)
+// gBuffer texel a low resolution texel is lit at, the center of its block
+ivec2 GuideTexel(ivec2 lowTexel)
+{
+    return min(lowTexel * downsample + downsample / 2, ivec2(renderSize) - 1);
+}
+#endif
+
+#ifdef UPSAMPLE
+// Joint bilateral upsample of the four nearest low resolution texels. Returns false on an edge.
+bool UpsampleLighting(GBufferInputs gBufferInputs, out LightingResult result)
+{
+    result.diffuse = vec3(0.0);
+    result.specular = vec3(0.0);
+
+    float depth = distance(viewPos, gBufferInputs.position);
+    vec2 lowPosition = (gl_FragCoord.xy - 0.5 - float(downsample / 2)) / float(downsample);
+    ivec2 base = ivec2(floor(lowPosition));
+    vec2 fraction = lowPosition - vec2(base);
+    ivec2 lowSize = (ivec2(renderSize) + downsample - 1) / downsample;
+
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 lowTexel = clamp(base + offset, ivec2(0), lowSize - 1);
+        ivec2 guideTexel = GuideTexel(lowTexel);
+        vec4 tapPosition = texelFetch(positionTexture, guideTexel, 0);
+        vec3 tapNormal = texelFetch(normalTexture, guideTexel, 0).rgb;
+
+        // Sky taps carry no lighting
+        float depthWeight = exp(-abs(distance(viewPos, tapPosition.xyz) - depth) / (DEPTH_SIGMA * depth));
+        float normalWeight = pow(max(dot(tapNormal, gBufferInputs.normal), 0.0), NORMAL_POWER);
+        float geometryWeight = tapPosition.a == 0.0 ? 0.0 : depthWeight * normalWeight;
+        if (geometryWeight < EDGE_THRESHOLD) {
+            return false;
+        }
+
+        vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+        float weight = bilinear.x * bilinear.y * geometryWeight;
+        result.diffuse += weight * texelFetch(diffuseTexture, lowTexel, 0).rgb;
+        result.specular += weight * texelFetch(specularTexture, lowTexel, 0).rgb;
+        totalWeight += weight;
+    }
+
+    result.diffuse /= max(totalWeight, 1e-4);
+    result.specular /= max(totalWeight, 1e-4);
+    return true;
+}
+#endif
 
 void main()
 {
+#ifdef LOW_RESOLUTION
+    ivec2 guideTexel = GuideTexel(ivec2(gl_FragCoord.xy));
+    vec4 position = texelFetch(positionTexture, guideTexel, 0);
+    if (position.a == 0.0) {
+        fDiffuse = vec3(0.0);
+        fSpecular = vec3(0.0);
+        return;
+    }
+
+    LightingResult lighting = EvaluateLights(position.xyz, texelFetch(normalTexture, guideTexel, 0).rgb);
+    fDiffuse = lighting.diffuse;
+    fSpecular = lighting.specular;
+#else
     // Do nothing if this location was not written to during gBuffer creation
     if (texture(positionTexture, vTexCoords).a == 0.0) {
         discard;
@@ -84,89 +167,67 @@ void main()
     gBufferInputs.albedo = texture(albedoSpecTexture, vTexCoords).rgb;
     gBufferInputs.specular = texture(albedoSpecTexture, vTexCoords).a;
 
-    // Convencence calculations
-    vec3 viewDir = normalize(viewPos - gBufferInputs.position);
+    LightingResult lighting;
+#ifdef UPSAMPLE
+    if (!UpsampleLighting(gBufferInputs, lighting))
+#endif
+        lighting = EvaluateLights(gBufferInputs.position, gBufferInputs.normal);
 
-    // Phase 1: Directional lighting
-    vec3 result = CalcDirLight(dirLight, viewDir, gBufferInputs);
-    // Phase 2: Point lights
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], viewDir, gBufferInputs);
-    // Phase 3: Spot light
-    for (int i = 0; i < NR_SPOT_LIGHTS; i++)
-        result += CalcSpotLight(spotLights[i], viewDir, gBufferInputs);
-    
-    vec4 objectColor = vec4(result, 1.0);
+    // Albedo and specular intensity always come from the full resolution gBuffer
+    vec4 objectColor = vec4(lighting.diffuse * gBufferInputs.albedo + lighting.specular * gBufferInputs.specular, 1.0);
     fFragColor = objectColor;
-
-    /*
-    // Phase 4: Apply fog
-    float distance = length(viewPos - gBufferInputs.position);
-    // Note: same as GL_EXP
-    float f = exp(-fogDensity*distance);
-
-    fFragColor = f*objectColor + (1-f)*fogColor;
-    */
+#endif
 }
 
-vec3 CalcDirLight(DirLight light, vec3 viewDir, GBufferInputs gBufferInputs)
+void CalcDirLight(DirLight light, vec3 viewDir, vec3 normal, inout LightingResult result)
 {
     vec3 lightDir = normalize(-light.direction);
     // Diffuse shading
-    float diff = max(dot(gBufferInputs.normal, lightDir), 0.0);
+    float diff = max(dot(normal, lightDir), 0.0);
     // Specular shading
-    vec3 reflectDir = reflect(-lightDir, gBufferInputs.normal);
+    vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
     // Combine results
-    vec3 ambient  = light.ambient  * gBufferInputs.albedo;
-    vec3 diffuse  = light.diffuse  * diff * gBufferInputs.albedo;
-    vec3 specular = light.specular * spec * vec3(gBufferInputs.specular);
-    return (ambient + diffuse + specular);
+    result.diffuse  += light.ambient + light.diffuse * diff;
+    result.specular += light.specular * spec;
 }
 
-vec3 CalcPointLight(PointLight light, vec3 viewDir, GBufferInputs gBufferInputs)
+void CalcPointLight(PointLight light, vec3 viewDir, vec3 position, vec3 normal, inout LightingResult result)
 {
-    vec3 lightDir = normalize(light.position - gBufferInputs.position);
+    vec3 lightDir = normalize(light.position - position);
     // Diffuse shading
-    float diff = max(dot(gBufferInputs.normal, lightDir), 0.0);
+    float diff = max(dot(normal, lightDir), 0.0);
     // Specular shading
-    vec3 reflectDir = reflect(-lightDir, gBufferInputs.normal);
+    vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
     // Attenuation
-    float distance    = length(light.position - gBufferInputs.position);
+    float distance    = length(light.position - position);
     float attenuation = 1.0 / (light.constant + light.linear * distance +
   			     light.quadratic * (distance * distance));
     // Combine results
-    vec3 ambient  = light.ambient  * gBufferInputs.albedo;
-    vec3 diffuse  = light.diffuse  * diff * gBufferInputs.albedo;
-    vec3 specular = light.specular * spec * vec3(gBufferInputs.specular);
-    ambient  *= attenuation;
-    diffuse  *= attenuation;
-    specular *= attenuation;
-    return (ambient + diffuse + specular);
+    result.diffuse  += (light.ambient + light.diffuse * diff) * attenuation;
+    result.specular += light.specular * spec * attenuation;
 }
 
-vec3 CalcSpotLight(SpotLight light, vec3 viewDir, GBufferInputs gBufferInputs)
+void CalcSpotLight(SpotLight light, vec3 viewDir, vec3 position, vec3 normal, inout LightingResult result)
 {
-    vec3 lightDir = normalize(light.position - gBufferInputs.position);
+    // Most lights in view are far from any given pixel
+    float distance = length(light.position - position);
+    if (distance > light.range)
+        return;
+    vec3 lightDir = (light.position - position) / distance;
     // Diffuse shading
-    float diff = max(dot(gBufferInputs.normal, lightDir), 0.0);
+    float diff = max(dot(normal, lightDir), 0.0);
     // Specular shading
-    vec3 reflectDir = reflect(-lightDir, gBufferInputs.normal);
+    vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
     // Attenuation
-    float distance = length(light.position - gBufferInputs.position);
     float attenuation = min(1, 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance)));
     // Spotlight intensity
     float theta = dot(lightDir, normalize(-light.direction));
     float epsilon = light.innerCutoff - light.outerCutoff;
     float intensity = clamp((theta - light.outerCutoff) / epsilon, 0.0, 1.0);
     // Combine results
-    vec3 ambient = light.ambient * gBufferInputs.albedo;
-    vec3 diffuse = light.diffuse * diff * gBufferInputs.albedo;
-    vec3 specular = light.specular * spec * vec3(gBufferInputs.specular);
-    ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
-    return (ambient + diffuse + specular);
-}
\ No newline at end of file
+    result.diffuse  += (light.ambient + light.diffuse * diff) * attenuation * intensity;
+    result.specular += light.specular * spec * attenuation * intensity;
+}
@@ -0,0 +1,62 @@
+#version 440 core
+
+// Inputs
+in vec2 vTexCoords;
+
+// Outputs
+out vec4 fFragColor;
+
+// Uniforms
+// Low resolution particles, as premultiplied color with transmittance in alpha, and the depth they were tested against
+uniform sampler2D particleTexture;
+uniform sampler2D particleDepthTexture;
+// Full resolution scene depth
+uniform sampler2D depthTexture;
+
+uniform mat4 projection;
+
+// Size of a low resolution texel in full resolution texels, and the full resolution texels covered by the render area
+uniform int downsample;
+uniform vec2 renderSize;
+
+// Depth difference, relative to the pixel's depth, below which a low resolution texel is taken to see the same surface
+const float DEPTH_THRESHOLD = 0.1;
+
+float LinearDepth(float depth)
+{
+    return projection[3][2] / (depth * 2.0 - 1.0 + projection[2][2]);
+}
+
+void main()
+{
+    float depth = LinearDepth(texelFetch(depthTexture, ivec2(gl_FragCoord.xy), 0).r);
+
+    // The four low resolution texels around this pixel
+    vec2 lowPosition = gl_FragCoord.xy / float(downsample) - 0.5;
+    ivec2 base = ivec2(floor(lowPosition));
+    ivec2 lowSize = (ivec2(renderSize) + downsample - 1) / downsample;
+
+    bool agree = true;
+    float nearestDifference = 1e30;
+    ivec2 nearestTexel = base;
+    for (int i = 0; i < 4; i++) {
+        ivec2 lowTexel = clamp(base + ivec2(i & 1, i >> 1), ivec2(0), lowSize - 1);
+        float difference = abs(LinearDepth(texelFetch(particleDepthTexture, lowTexel, 0).r) - depth);
+        agree = agree && difference < DEPTH_THRESHOLD * depth;
+        if (difference < nearestDifference) {
+            nearestDifference = difference;
+            nearestTexel = lowTexel;
+        }
+    }
+
+    // Filter where every texel saw this surface; across depth edges take the texel nearest in depth,
+    // so particles do not bleed over foreground geometry
+    if (agree) {
+        vec2 particleTextureSize = vec2(textureSize(particleTexture, 0));
+        vec2 texCoords = min(lowPosition + 0.5, vec2(lowSize) - 0.5) / particleTextureSize;
+        fFragColor = texture(particleTexture, texCoords);
+    }
+    else {
+        fFragColor = texelFetch(particleTexture, nearestTexel, 0);
+    }
+}
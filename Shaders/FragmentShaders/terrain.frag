@@ -9,13 +9,9 @@ in vec3 gTriDistance;
 in vec3 gPatchDistance;
 
 // Outputs
-layout (location = 0) out vec4 fPosition;
-layout (location = 1) out vec3 fNormal;
-layout (location = 2) out vec4 fAlbedoSpec;
+#include "../Include/gbuffer_outputs.glsl"
 
 // Uniforms
-uniform int wireframeMode;
-
 uniform sampler2D albedoMap;
 uniform sampler2D normalMap;
 uniform sampler2D specularMap;
@@ -47,27 +43,21 @@ void main()
     fNormal = mat3(1,0,0,0,0,1,0,1,0)*texture(normalMap, gTexCoords).rgb;
     // Store the diffuse per-fragment color
     vec3 color = fAlbedoSpec.rgb = texture(albedoMap, gTexCoords*vec2(textureRepeatX, textureRepeatZ)).rgb;
-    vec3 wireframeColor = determineWireframeColor();
+#if defined(WIREFRAME_OVERLAY)
+    // Output albedo + wireframe
     float d = min(min(gTriDistance.x, gTriDistance.y), gTriDistance.z);
-    float stepVal = step(0.1, d);
-    bool dUnderThreshold = stepVal == 0.0;
-    if (wireframeMode == 0) {
-        // Output albedo
-        fAlbedoSpec.rgb = color;
-    }
-    else if (wireframeMode == 1) {
-        // Output albedo + wireframe
-        fAlbedoSpec.rgb = mix(wireframeColor, color, stepVal);
-    }
-    else {
-        // Output wireframe
-        if (dUnderThreshold) {
-            fAlbedoSpec.rgb = wireframeColor;
-        }
-        else {
-            discard;
-        }
+    fAlbedoSpec.rgb = mix(determineWireframeColor(), color, step(0.1, d));
+#elif defined(WIREFRAME_ONLY)
+    // Output wireframe
+    float d = min(min(gTriDistance.x, gTriDistance.y), gTriDistance.z);
+    if (d >= 0.1) {
+        discard;
     }
+    fAlbedoSpec.rgb = determineWireframeColor();
+#else
+    // Output albedo
+    fAlbedoSpec.rgb = color;
+#endif
     // Store specular intensity in alpha component
     fAlbedoSpec.a = texture(specularMap, gTexCoords).r;
 }
\ No newline at end of file
@@ -0,0 +1,4 @@
+// gBuffer attachments written by every geometry pass
+layout (location = 0) out vec4 fPosition;
+layout (location = 1) out vec3 fNormal;
+layout (location = 2) out vec4 fAlbedoSpec;
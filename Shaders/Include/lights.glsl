@@ -0,0 +1,36 @@
+// Light uniforms; NR_POINT_LIGHTS is defined by the renderer
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// Read from a shader storage buffer; each vec3 is followed by a float to fill its std430 slot.
+// Matches GpuSpotLight in renderingengine.cpp.
+struct SpotLight {
+    vec3  position;
+    float range;
+    vec3  direction;
+    float innerCutoff;
+    vec3  ambient;
+    float outerCutoff;
+    vec3  diffuse;
+    float constant;
+    vec3  specular;
+    float linear;
+    float quadratic;
+};
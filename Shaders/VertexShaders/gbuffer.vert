@@ -2,9 +2,13 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in vec3 aTangent;
+layout (location = 3) in vec4 aTangent;
 layout (location = 4) in vec3 aBitangent;
 layout (location = 5) in mat4 aInstanceModel;
+// Per-mesh constants: packed positions are normalized to the mesh bounds,
+// and w is set when the bitangent is rebuilt from the tangent's handedness
+layout (location = 9) in vec4 aPositionScale;
+layout (location = 10) in vec3 aPositionOffset;
 
 out vec3 vPosition;
 out vec2 vTexCoords;
@@ -15,13 +19,15 @@ uniform mat4 projection;
 
 void main()
 {
-    vec4 worldPos = aInstanceModel * vec4(aPos, 1.0);
+    vec3 position = aPositionOffset + aPos * aPositionScale.xyz;
+    vec4 worldPos = aInstanceModel * vec4(position, 1.0);
     vPosition = worldPos.xyz; 
     vTexCoords = aTexCoords;
 
     mat3 normalMatrix = transpose(inverse(mat3(aInstanceModel)));
-    vec3 T = normalize(normalMatrix * aTangent);
-    vec3 B = normalize(normalMatrix * aBitangent);
+    vec3 bitangent = aPositionScale.w > 0.5 ? cross(aNormal, aTangent.xyz) * sign(aTangent.w) : aBitangent;
+    vec3 T = normalize(normalMatrix * aTangent.xyz);
+    vec3 B = normalize(normalMatrix * bitangent);
     vec3 N = normalize(normalMatrix * aNormal);
     vTBN = mat3(T, B, N);
 
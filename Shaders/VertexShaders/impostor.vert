@@ -0,0 +1,35 @@
+#version 440 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 5) in mat4 aInstanceModel;
+
+out vec2 vTexCoords;
+flat out mat4 vModel;
+flat out mat3 vNormalMatrix;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform vec3 center;
+uniform float radius;
+uniform int frameCount;
+
+void main()
+{
+    // The camera direction in object space picks the baked view around the vertical axis
+    vec3 cameraPos = inverse(view)[3].xyz;
+    vec3 objectCamera = (inverse(aInstanceModel) * vec4(cameraPos, 1.0)).xyz - center;
+    vec3 toCamera = normalize(vec3(objectCamera.x, 0.0, objectCamera.z) + vec3(0.0, 0.0, 1e-5));
+    int frame = int(round(atan(toCamera.x, toCamera.z) / 6.28318530718 * frameCount));
+    frame = (frame % frameCount + frameCount) % frameCount;
+
+    // Billboard around the vertical axis, matching the right vector used when baking
+    vec3 up = vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(-toCamera, up));
+    vec3 position = center + (right * aCorner.x + up * aCorner.y) * radius;
+
+    vTexCoords = vec2((frame + aCorner.x * 0.5 + 0.5) / frameCount, aCorner.y * 0.5 + 0.5);
+    vModel = aInstanceModel;
+    vNormalMatrix = transpose(inverse(mat3(aInstanceModel)));
+
+    gl_Position = projection * view * aInstanceModel * vec4(position, 1.0);
+}
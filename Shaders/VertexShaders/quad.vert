@@ -5,9 +5,11 @@ out vec2 vTexCoords;
 
 uniform vec2 scale;
 uniform vec2 offset;
+// Portion of the source textures holding the rendered image
+uniform vec2 texCoordScale = vec2(1.0);
 
 void main()
 {
-    vTexCoords = (aPos + 1.0) / 2.0;
+    vTexCoords = (aPos + 1.0) / 2.0 * texCoordScale;
     gl_Position = vec4(scale * aPos + offset, 0.0, 1.0);
 }
\ No newline at end of file